@@ -0,0 +1,412 @@
+#include <stddef.h>
+#include "blend_sw.h"
+#include "cpu.h"
+#include "snapshot.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+/* xmmintrin.h pulls in mm_malloc.h, which needs a hosted <stdlib.h> */
+#define _MM_MALLOC_H_INCLUDED
+#include <immintrin.h>
+#define BLEND_SW_SIMD 1
+#define SSE2_FN static inline __attribute__((target("sse2"), always_inline))
+#define AVX2_FN static inline __attribute__((target("avx2"), always_inline))
+#else
+#define BLEND_SW_SIMD 0
+#endif
+
+/* LV_OPA_MAX / LV_OPA_MIN: lv_color_32_32_mix() treats alphas at or past
+ * these as fully opaque / fully transparent */
+#define OPA_MAX 253
+#define OPA_MIN 2
+
+/* One row of a blend. The foreground alpha is the product of the source
+ * alpha, the mask and opa, whichever are present, scaled the way LVGL's
+ * LV_OPA_MIX2/LV_OPA_MIX3 do it */
+typedef struct {
+    uint32_t *dest;
+    const uint32_t *src;    /* NULL: constant color */
+    const uint8_t *mask;    /* NULL: no mask */
+    uint32_t color;
+    uint32_t opa;           /* 255: no opacity */
+    int32_t w;
+} blend_row_t;
+
+typedef struct {
+    void (*fill_row)(uint32_t *dest, int32_t w, uint32_t color);
+    void (*blend_row)(const blend_row_t *r);
+    void (*xrgb_row)(uint32_t *dest, const uint32_t *src, int32_t w);
+} kernels_t;
+
+static uint32_t lerp_rgb(uint32_t fg, uint32_t bg, uint32_t a) {
+    uint32_t ia = 255 - a;
+    uint32_t r = (((fg >> 16) & 0xFF) * a + ((bg >> 16) & 0xFF) * ia) >> 8;
+    uint32_t g = (((fg >> 8) & 0xFF) * a + ((bg >> 8) & 0xFF) * ia) >> 8;
+    uint32_t b = ((fg & 0xFF) * a + (bg & 0xFF) * ia) >> 8;
+    return r << 16 | g << 8 | b;
+}
+
+/* lv_color_32_32_mix() with the foreground alpha passed separately */
+static uint32_t mix_px(uint32_t fg, uint32_t a, uint32_t bg) {
+    uint32_t ba = bg >> 24;
+
+    if (a >= OPA_MAX || ba <= OPA_MIN)
+        return (fg & 0xFFFFFF) | a << 24;
+    if (a <= OPA_MIN)
+        return bg;
+    if (ba == 255)
+        return lerp_rgb(fg, bg, a) | 0xFF000000u;
+
+    /* Both translucent: the "over" operator */
+    uint32_t res_a = 255 - (((255 - a) * (255 - ba)) >> 8);
+    uint32_t ratio = a * 255 / res_a;
+    uint32_t rgb;
+    if (ratio >= OPA_MAX)
+        rgb = fg & 0xFFFFFF;
+    else if (ratio <= OPA_MIN)
+        rgb = bg & 0xFFFFFF;
+    else
+        rgb = lerp_rgb(fg, bg, ratio);
+    return rgb | res_a << 24;
+}
+
+static uint32_t px_alpha(const blend_row_t *r, int32_t x) {
+    uint32_t f[3];
+    int n = 0;
+
+    if (r->src)
+        f[n++] = r->src[x] >> 24;
+    if (r->mask)
+        f[n++] = r->mask[x];
+    if (r->opa != 255)
+        f[n++] = r->opa;
+
+    switch (n) {
+        case 1: return f[0];
+        case 2: return (f[0] * f[1]) >> 8;
+        case 3: return (f[0] * f[1] * f[2]) >> 16;
+        default: return 255;
+    }
+}
+
+static void blend_px(const blend_row_t *r, int32_t x) {
+    uint32_t fg = r->src ? r->src[x] : r->color;
+    r->dest[x] = mix_px(fg, px_alpha(r, x), r->dest[x]);
+}
+
+/* Scalar kernels: what LVGL's C loops compute, and the SIMD tails */
+static void fill_row_c(uint32_t *dest, int32_t w, uint32_t color) {
+    for (int32_t x = 0; x < w; x++)
+        dest[x] = color;
+}
+
+static void blend_row_c(const blend_row_t *r) {
+    for (int32_t x = 0; x < r->w; x++)
+        blend_px(r, x);
+}
+
+static void xrgb_row_c(uint32_t *dest, const uint32_t *src, int32_t w) {
+    for (int32_t x = 0; x < w; x++)
+        dest[x] = src[x] | 0xFF000000u;
+}
+
+#if BLEND_SW_SIMD
+
+/* SSE2: four pixels per step. Channels are widened to 16 bits, so
+ * fg * a + bg * (255 - a) cannot overflow */
+
+SSE2_FN __m128i load_mask4(const uint8_t *m) {
+    uint32_t v;
+    __builtin_memcpy(&v, m, 4);
+    __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)v), zero), zero);
+}
+
+/* Alphas of four pixels in 32-bit lanes. Factors are below 256, so the
+ * 16-bit multiplies are exact: mullo gives a*b, mulhi_epu16 gives
+ * (a*b*c) >> 16 */
+SSE2_FN __m128i alpha4_sse2(const blend_row_t *r, __m128i fg, int32_t x) {
+    __m128i f[3];
+    int n = 0;
+
+    if (r->src)
+        f[n++] = _mm_srli_epi32(fg, 24);
+    if (r->mask)
+        f[n++] = load_mask4(r->mask + x);
+    if (r->opa != 255)
+        f[n++] = _mm_set1_epi32((int)r->opa);
+
+    if (n == 3)
+        return _mm_mulhi_epu16(_mm_mullo_epi16(f[0], f[1]), f[2]);
+    if (n == 2)
+        return _mm_srli_epi32(_mm_mullo_epi16(f[0], f[1]), 8);
+    return f[0];
+}
+
+SSE2_FN int opaque4_sse2(__m128i bg) {
+    __m128i ones = _mm_set1_epi32(-1);
+    __m128i full = _mm_or_si128(bg, _mm_set1_epi32(0x00FFFFFF));
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(full, ones)) == 0xFFFF;
+}
+
+/* mix_px() for four pixels over an opaque background */
+SSE2_FN __m128i mix4_sse2(__m128i fg, __m128i a, __m128i bg) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i c255 = _mm_set1_epi16(255);
+    __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+
+    /* a in all four channels of its pixel, as 16-bit lanes */
+    __m128i a2 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+    __m128i a_lo = _mm_unpacklo_epi32(a2, a2);
+    __m128i a_hi = _mm_unpackhi_epi32(a2, a2);
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(fg, zero), a_lo),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(bg, zero),
+                                               _mm_sub_epi16(c255, a_lo)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(fg, zero), a_hi),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(bg, zero),
+                                               _mm_sub_epi16(c255, a_hi)));
+    __m128i mixed = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    mixed = _mm_or_si128(_mm_and_si128(mixed, rgb_mask), _mm_set1_epi32((int)0xFF000000u));
+
+    /* Nearly opaque: the foreground with its own alpha; nearly clear: bg */
+    __m128i take_fg = _mm_cmpgt_epi32(a, _mm_set1_epi32(OPA_MAX - 1));
+    __m128i take_bg = _mm_cmplt_epi32(a, _mm_set1_epi32(OPA_MIN + 1));
+    __m128i fg_a = _mm_or_si128(_mm_and_si128(fg, rgb_mask), _mm_slli_epi32(a, 24));
+
+    __m128i res = _mm_or_si128(_mm_and_si128(take_bg, bg), _mm_andnot_si128(take_bg, mixed));
+    return _mm_or_si128(_mm_and_si128(take_fg, fg_a), _mm_andnot_si128(take_fg, res));
+}
+
+__attribute__((target("sse2")))
+static void fill_row_sse2(uint32_t *dest, int32_t w, uint32_t color) {
+    __m128i c = _mm_set1_epi32((int)color);
+    int32_t x = 0;
+    for (; x + 4 <= w; x += 4)
+        _mm_storeu_si128((__m128i *)(dest + x), c);
+    for (; x < w; x++)
+        dest[x] = color;
+}
+
+__attribute__((target("sse2")))
+static void blend_row_sse2(const blend_row_t *r) {
+    __m128i color = _mm_set1_epi32((int)r->color);
+    int32_t x = 0;
+
+    for (; x + 4 <= r->w; x += 4) {
+        __m128i bg = _mm_loadu_si128((const __m128i *)(r->dest + x));
+        __m128i fg = r->src ? _mm_loadu_si128((const __m128i *)(r->src + x)) : color;
+        if (!opaque4_sse2(bg)) {
+            for (int32_t i = 0; i < 4; i++)
+                blend_px(r, x + i);
+            continue;
+        }
+        _mm_storeu_si128((__m128i *)(r->dest + x), mix4_sse2(fg, alpha4_sse2(r, fg, x), bg));
+    }
+    for (; x < r->w; x++)
+        blend_px(r, x);
+}
+
+__attribute__((target("sse2")))
+static void xrgb_row_sse2(uint32_t *dest, const uint32_t *src, int32_t w) {
+    __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+    int32_t x = 0;
+    for (; x + 4 <= w; x += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + x));
+        _mm_storeu_si128((__m128i *)(dest + x), _mm_or_si128(v, alpha));
+    }
+    for (; x < w; x++)
+        dest[x] = src[x] | 0xFF000000u;
+}
+
+/* AVX2: the same steps on eight pixels. Unpack and pack work within each
+ * 128-bit half, so pixel order is preserved */
+
+AVX2_FN __m256i alpha8_avx2(const blend_row_t *r, __m256i fg, int32_t x) {
+    __m256i f[3];
+    int n = 0;
+
+    if (r->src)
+        f[n++] = _mm256_srli_epi32(fg, 24);
+    if (r->mask)
+        f[n++] = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(r->mask + x)));
+    if (r->opa != 255)
+        f[n++] = _mm256_set1_epi32((int)r->opa);
+
+    if (n == 3)
+        return _mm256_mulhi_epu16(_mm256_mullo_epi16(f[0], f[1]), f[2]);
+    if (n == 2)
+        return _mm256_srli_epi32(_mm256_mullo_epi16(f[0], f[1]), 8);
+    return f[0];
+}
+
+AVX2_FN int opaque8_avx2(__m256i bg) {
+    __m256i full = _mm256_or_si256(bg, _mm256_set1_epi32(0x00FFFFFF));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi32(full, _mm256_set1_epi32(-1))) == -1;
+}
+
+AVX2_FN __m256i mix8_avx2(__m256i fg, __m256i a, __m256i bg) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i c255 = _mm256_set1_epi16(255);
+    __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+
+    __m256i a2 = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+    __m256i a_lo = _mm256_unpacklo_epi32(a2, a2);
+    __m256i a_hi = _mm256_unpackhi_epi32(a2, a2);
+
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(fg, zero), a_lo),
+                                  _mm256_mullo_epi16(_mm256_unpacklo_epi8(bg, zero),
+                                                     _mm256_sub_epi16(c255, a_lo)));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(fg, zero), a_hi),
+                                  _mm256_mullo_epi16(_mm256_unpackhi_epi8(bg, zero),
+                                                     _mm256_sub_epi16(c255, a_hi)));
+    __m256i mixed = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8));
+    mixed = _mm256_or_si256(_mm256_and_si256(mixed, rgb_mask),
+                            _mm256_set1_epi32((int)0xFF000000u));
+
+    __m256i take_fg = _mm256_cmpgt_epi32(a, _mm256_set1_epi32(OPA_MAX - 1));
+    __m256i take_bg = _mm256_cmpgt_epi32(_mm256_set1_epi32(OPA_MIN + 1), a);
+    __m256i fg_a = _mm256_or_si256(_mm256_and_si256(fg, rgb_mask), _mm256_slli_epi32(a, 24));
+
+    __m256i res = _mm256_blendv_epi8(mixed, bg, take_bg);
+    return _mm256_blendv_epi8(res, fg_a, take_fg);
+}
+
+__attribute__((target("avx2")))
+static void fill_row_avx2(uint32_t *dest, int32_t w, uint32_t color) {
+    __m256i c = _mm256_set1_epi32((int)color);
+    int32_t x = 0;
+    for (; x + 8 <= w; x += 8)
+        _mm256_storeu_si256((__m256i *)(dest + x), c);
+    for (; x < w; x++)
+        dest[x] = color;
+}
+
+__attribute__((target("avx2")))
+static void blend_row_avx2(const blend_row_t *r) {
+    __m256i color = _mm256_set1_epi32((int)r->color);
+    int32_t x = 0;
+
+    for (; x + 8 <= r->w; x += 8) {
+        __m256i bg = _mm256_loadu_si256((const __m256i *)(r->dest + x));
+        __m256i fg = r->src ? _mm256_loadu_si256((const __m256i *)(r->src + x)) : color;
+        if (!opaque8_avx2(bg)) {
+            for (int32_t i = 0; i < 8; i++)
+                blend_px(r, x + i);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i *)(r->dest + x), mix8_avx2(fg, alpha8_avx2(r, fg, x), bg));
+    }
+    for (; x < r->w; x++)
+        blend_px(r, x);
+}
+
+__attribute__((target("avx2")))
+static void xrgb_row_avx2(uint32_t *dest, const uint32_t *src, int32_t w) {
+    __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+    int32_t x = 0;
+    for (; x + 8 <= w; x += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + x));
+        _mm256_storeu_si256((__m256i *)(dest + x), _mm256_or_si256(v, alpha));
+    }
+    for (; x < w; x++)
+        dest[x] = src[x] | 0xFF000000u;
+}
+
+#endif
+
+static const kernels_t impls[BLEND_SW_IMPL_COUNT] = {
+    [BLEND_SW_C] = { fill_row_c, blend_row_c, xrgb_row_c },
+#if BLEND_SW_SIMD
+    [BLEND_SW_SSE2] = { fill_row_sse2, blend_row_sse2, xrgb_row_sse2 },
+    [BLEND_SW_AVX2] = { fill_row_avx2, blend_row_avx2, xrgb_row_avx2 },
+#endif
+};
+
+static const char *const names[BLEND_SW_IMPL_COUNT] = { "c", "sse2", "avx2" };
+
+/* Depends on the CPU this boot runs on, not on the one a warm-boot
+ * snapshot was taken on */
+static const kernels_t *active SNAPSHOT_SKIP;
+static blend_sw_impl_t active_impl SNAPSHOT_SKIP;
+
+void blend_sw_init(uint32_t features) {
+    /* Without SIMD the C kernels are no faster than LVGL's own loops */
+    active = NULL;
+    active_impl = BLEND_SW_C;
+    if (features & CPU_AVX2)
+        blend_sw_select(BLEND_SW_AVX2);
+    else if (features & CPU_SSE2)
+        blend_sw_select(BLEND_SW_SSE2);
+}
+
+int blend_sw_select(blend_sw_impl_t impl) {
+    if (impl >= BLEND_SW_IMPL_COUNT || !impls[impl].fill_row)
+        return -1;
+    active = &impls[impl];
+    active_impl = impl;
+    return 0;
+}
+
+blend_sw_impl_t blend_sw_current(void) {
+    return active_impl;
+}
+
+const char *blend_sw_name(blend_sw_impl_t impl) {
+    return impl < BLEND_SW_IMPL_COUNT ? names[impl] : "?";
+}
+
+int blend_sw_fill(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color) {
+    if (!active)
+        return 0;
+
+    uint8_t *d = dest;
+    for (int32_t y = 0; y < h; y++, d += stride)
+        active->fill_row((uint32_t *)d, w, color);
+    return 1;
+}
+
+int blend_sw_color(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color,
+                   uint8_t opa, const uint8_t *mask, int32_t mask_stride) {
+    if (!active)
+        return 0;
+
+    blend_row_t r = { .color = color, .opa = opa, .w = w };
+    uint8_t *d = dest;
+    for (int32_t y = 0; y < h; y++, d += stride) {
+        r.dest = (uint32_t *)d;
+        r.mask = mask ? mask + y * mask_stride : NULL;
+        active->blend_row(&r);
+    }
+    return 1;
+}
+
+int blend_sw_argb(void *dest, int32_t w, int32_t h, int32_t stride,
+                  const void *src, int32_t src_stride, uint8_t opa,
+                  const uint8_t *mask, int32_t mask_stride) {
+    if (!active)
+        return 0;
+
+    blend_row_t r = { .opa = opa, .w = w };
+    uint8_t *d = dest;
+    const uint8_t *s = src;
+    for (int32_t y = 0; y < h; y++, d += stride, s += src_stride) {
+        r.dest = (uint32_t *)d;
+        r.src = (const uint32_t *)s;
+        r.mask = mask ? mask + y * mask_stride : NULL;
+        active->blend_row(&r);
+    }
+    return 1;
+}
+
+int blend_sw_xrgb(void *dest, int32_t w, int32_t h, int32_t stride,
+                  const void *src, int32_t src_stride, int32_t src_px_size) {
+    /* Packed 24-bit sources stay with LVGL */
+    if (!active || src_px_size != 4)
+        return 0;
+
+    uint8_t *d = dest;
+    const uint8_t *s = src;
+    for (int32_t y = 0; y < h; y++, d += stride, s += src_stride)
+        active->xrgb_row((uint32_t *)d, (const uint32_t *)s, w);
+    return 1;
+}
@@ -0,0 +1,81 @@
+#ifndef BLEND_SW_H
+#define BLEND_SW_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * Vectorized ARGB8888 blending for LVGL's software renderer. lv_conf.h
+ * names this header as LV_DRAW_SW_ASM_CUSTOM_INCLUDE; the macros below
+ * replace the generic loops of lv_draw_sw_blend_to_argb8888.c and use
+ * the same arithmetic as LVGL's lv_color_32_32_mix(). A kernel returns 0
+ * (LV_RESULT_INVALID) when it has nothing faster than the C loop, e.g.
+ * before blend_sw_init() or on a CPU without SSE2.
+ */
+
+typedef enum {
+    BLEND_SW_C,             /* Scalar reference; LVGL's C loops do the work */
+    BLEND_SW_SSE2,
+    BLEND_SW_AVX2,
+    BLEND_SW_IMPL_COUNT
+} blend_sw_impl_t;
+
+/* Picks the widest implementation in `features` (cpu.h CPU_* bits) */
+void blend_sw_init(uint32_t features);
+/* Forces an implementation (benchmarks); -1 if it was not compiled in */
+int blend_sw_select(blend_sw_impl_t impl);
+blend_sw_impl_t blend_sw_current(void);
+const char *blend_sw_name(blend_sw_impl_t impl);
+
+/* Strides are in bytes. mask may be NULL; opa 255 means no opacity */
+int blend_sw_fill(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color);
+int blend_sw_color(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color,
+                   uint8_t opa, const uint8_t *mask, int32_t mask_stride);
+int blend_sw_argb(void *dest, int32_t w, int32_t h, int32_t stride,
+                  const void *src, int32_t src_stride, uint8_t opa,
+                  const uint8_t *mask, int32_t mask_stride);
+int blend_sw_xrgb(void *dest, int32_t w, int32_t h, int32_t stride,
+                  const void *src, int32_t src_stride, int32_t src_px_size);
+
+#if PORT_BLEND_SW
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_ARGB8888(dsc) \
+    blend_sw_fill((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  lv_color_to_u32((dsc)->color))
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_ARGB8888_WITH_OPA(dsc) \
+    blend_sw_color((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                   lv_color_to_u32((dsc)->color), (dsc)->opa, NULL, 0)
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_ARGB8888_WITH_MASK(dsc) \
+    blend_sw_color((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                   lv_color_to_u32((dsc)->color), 255, (dsc)->mask_buf, (dsc)->mask_stride)
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_ARGB8888_MIX_MASK_OPA(dsc) \
+    blend_sw_color((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                   lv_color_to_u32((dsc)->color), (dsc)->opa, (dsc)->mask_buf, (dsc)->mask_stride)
+
+#define LV_DRAW_SW_RGB888_BLEND_NORMAL_TO_ARGB8888(dsc, src_px_size) \
+    blend_sw_xrgb((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  (dsc)->src_buf, (dsc)->src_stride, (src_px_size))
+
+#define LV_DRAW_SW_ARGB8888_BLEND_NORMAL_TO_ARGB8888(dsc) \
+    blend_sw_argb((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  (dsc)->src_buf, (dsc)->src_stride, 255, NULL, 0)
+
+#define LV_DRAW_SW_ARGB8888_BLEND_NORMAL_TO_ARGB8888_WITH_OPA(dsc) \
+    blend_sw_argb((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  (dsc)->src_buf, (dsc)->src_stride, (dsc)->opa, NULL, 0)
+
+#define LV_DRAW_SW_ARGB8888_BLEND_NORMAL_TO_ARGB8888_WITH_MASK(dsc) \
+    blend_sw_argb((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  (dsc)->src_buf, (dsc)->src_stride, 255, (dsc)->mask_buf, (dsc)->mask_stride)
+
+#define LV_DRAW_SW_ARGB8888_BLEND_NORMAL_TO_ARGB8888_MIX_MASK_OPA(dsc) \
+    blend_sw_argb((dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                  (dsc)->src_buf, (dsc)->src_stride, (dsc)->opa, (dsc)->mask_buf, \
+                  (dsc)->mask_stride)
+
+#endif
+
+#endif
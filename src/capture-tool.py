@@ -0,0 +1,104 @@
+import os
+import sys
+
+# Reads the output of a "capture=N" boot (capture.c).
+#
+# Usage: python3 capture-tool.py check capture.log golden.txt
+#        python3 capture-tool.py update capture.log golden.txt
+#        python3 capture-tool.py ppm capture.log DIR
+#
+# check compares the per-frame framebuffer hashes against golden.txt and
+# fails on any difference; update rewrites golden.txt from the log. ppm
+# writes the frames dumped with "capture_dump=F,G" as DIR/frame_F.ppm.
+
+
+def parse(path):
+    hashes = {}
+    dumps = {}
+    done = False
+    dump = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if dump is not None:
+                if line == "capture: dump end":
+                    frame, w, h, hexdata = dump
+                    data = bytes.fromhex("".join(hexdata))
+                    if len(data) != w * h * 3:
+                        sys.exit(f"frame {frame}: dump is {len(data)} bytes, expected {w * h * 3}")
+                    dumps[frame] = (w, h, data)
+                    dump = None
+                else:
+                    dump[3].append(line)
+            elif line.startswith("capture: frame "):
+                _, _, frame, value = line.split()
+                hashes[int(frame)] = value
+            elif line.startswith("capture: dump "):
+                frame, w, h = (int(v) for v in line.split()[2:])
+                dump = (frame, w, h, [])
+            elif line == "capture: done":
+                done = True
+    if not done:
+        sys.exit(f"{path}: capture did not finish")
+    return hashes, dumps
+
+
+def read_golden(path):
+    golden = {}
+    with open(path) as f:
+        for line in f:
+            if line.strip() and not line.startswith("#"):
+                frame, value = line.split()
+                golden[int(frame)] = value
+    return golden
+
+
+def check(hashes, golden_path):
+    if not os.path.exists(golden_path):
+        sys.exit(f"{golden_path} missing; run make golden-update on a known-good build")
+    golden = read_golden(golden_path)
+    bad = [f for f in sorted(golden) if hashes.get(f) != golden[f]]
+    extra = sorted(set(hashes) - set(golden))
+    for f in bad[:20]:
+        print(f"frame {f}: {hashes.get(f, 'missing')}, golden {golden[f]}")
+    if len(bad) > 20:
+        print(f"... {len(bad) - 20} more")
+    if extra:
+        print(f"{len(extra)} frames have no golden (from frame {extra[0]})")
+    if bad:
+        sys.exit(f"{len(bad)} of {len(golden)} frames differ")
+    print(f"{len(golden)} frames match {golden_path}")
+
+
+def update(hashes, golden_path):
+    with open(golden_path, "w") as f:
+        f.write("# frame framebuffer-hash, from make golden-update\n")
+        for frame in sorted(hashes):
+            f.write(f"{frame} {hashes[frame]}\n")
+    print(f"{golden_path}: {len(hashes)} frames")
+
+
+def write_ppms(dumps, outdir):
+    os.makedirs(outdir, exist_ok=True)
+    for frame, (w, h, data) in sorted(dumps.items()):
+        path = os.path.join(outdir, f"frame_{frame}.ppm")
+        with open(path, "wb") as f:
+            f.write(b"P6 %d %d 255\n" % (w, h))
+            f.write(data)
+        print(path)
+
+
+def main():
+    if len(sys.argv) != 4 or sys.argv[1] not in ("check", "update", "ppm"):
+        sys.exit("usage: capture-tool.py check|update|ppm capture.log golden.txt|DIR")
+    hashes, dumps = parse(sys.argv[2])
+    if sys.argv[1] == "check":
+        check(hashes, sys.argv[3])
+    elif sys.argv[1] == "update":
+        update(hashes, sys.argv[3])
+    else:
+        write_ppms(dumps, sys.argv[3])
+
+
+if __name__ == "__main__":
+    main()
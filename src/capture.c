@@ -0,0 +1,133 @@
+#include <stddef.h>
+#include "capture.h"
+
+#if PORT_CAPTURE
+
+#include "cmdline.h"
+#include "io.h"
+#include "keyboard.h"
+#include "pacer.h"
+#include "serial.h"
+#include "vbe.h"
+#include "lvgl/lvgl.h"
+
+#define FRAME_MS    (1000 / PORT_PACER_HZ)
+#define MAX_DUMPS   16
+#define DUMP_PX     32          /* Pixels per hex line */
+
+/* Keys fed during a capture: focus walks down the list far enough to
+ * scroll it, a row is checked, then focus walks back up */
+typedef struct {
+    uint16_t first;         /* Frame of the first press */
+    uint16_t count;
+    uint16_t every;         /* Frames between presses */
+    char key;               /* key_event_t.ascii */
+} step_t;
+
+static const step_t script[] = {
+    { 10, 40, 2, 2 },       /* Down */
+    { 100, 1, 1, '\n' },
+    { 110, 20, 3, 1 },      /* Up */
+};
+
+uint32_t capture_requested(void *mboot_info) {
+    const char *v = cmdline_value(mboot_info, "capture");
+    return v ? cmdline_parse_uint(&v) : 0;
+}
+
+uint32_t capture_hash(void) {
+    vbe_info_t *vbe = vbe_get_info();
+    uint32_t stride = vbe->pitch / 4;
+    uint32_t h = 2166136261u;
+
+    for (uint32_t y = 0; y < vbe->height; y++) {
+        const uint32_t *row = vbe->framebuffer + y * stride;
+        for (uint32_t x = 0; x < vbe->width; x++)
+            h = (h ^ (row[x] & 0xFFFFFF)) * 16777619u;
+    }
+    return h;
+}
+
+void capture_print(void) {
+    serial_printf("capture: hash %08x\n", (unsigned)capture_hash());
+}
+
+/* Pixels as R G B hex, DUMP_PX to a line, between "capture: dump F W H"
+ * and "capture: dump end" */
+static void dump_frame(uint32_t frame) {
+    static const char digits[] = "0123456789abcdef";
+    vbe_info_t *vbe = vbe_get_info();
+    uint32_t stride = vbe->pitch / 4;
+    char line[DUMP_PX * 6 + 1];
+    uint32_t fill = 0;
+
+    serial_printf("capture: dump %u %u %u\n", (unsigned)frame, (unsigned)vbe->width,
+                  (unsigned)vbe->height);
+    for (uint32_t y = 0; y < vbe->height; y++) {
+        const uint32_t *row = vbe->framebuffer + y * stride;
+        for (uint32_t x = 0; x < vbe->width; x++) {
+            for (int shift = 16; shift >= 0; shift -= 8) {
+                uint32_t b = (row[x] >> shift) & 0xFF;
+                line[fill++] = digits[b >> 4];
+                line[fill++] = digits[b & 0xF];
+            }
+            if (fill == DUMP_PX * 6) {
+                line[fill++] = '\n';
+                serial_write(line, fill);
+                fill = 0;
+            }
+        }
+    }
+    if (fill) {
+        line[fill++] = '\n';
+        serial_write(line, fill);
+    }
+    serial_puts("capture: dump end\n");
+}
+
+void capture_dump(void) {
+    dump_frame(0);
+}
+
+static void feed_keys(uint32_t frame) {
+    for (uint32_t i = 0; i < sizeof(script) / sizeof(script[0]); i++) {
+        const step_t *s = &script[i];
+        if (frame < s->first || (frame - s->first) % s->every)
+            continue;
+        if ((frame - s->first) / s->every < s->count)
+            keyboard_inject((key_event_t){ 0, 1, s->key });
+    }
+}
+
+void capture_run(void *mboot_info, uint32_t frames) {
+    uint32_t dumps[MAX_DUMPS];
+    uint32_t dump_count = 0;
+
+    const char *v = cmdline_value(mboot_info, "capture_dump");
+    while (v && *v >= '0' && *v <= '9' && dump_count < MAX_DUMPS) {
+        dumps[dump_count++] = cmdline_parse_uint(&v);
+        if (*v == ',')
+            v++;
+    }
+
+    serial_printf("capture: %u frames of %u ms\n", (unsigned)frames, (unsigned)FRAME_MS);
+    for (uint32_t f = 0; f < frames; f++) {
+        feed_keys(f);
+        lv_tick_inc(FRAME_MS);
+        lv_timer_handler();
+        pacer_refresh_now();
+
+        serial_printf("capture: frame %u %08x\n", (unsigned)f, (unsigned)capture_hash());
+        for (uint32_t i = 0; i < dump_count; i++) {
+            if (dumps[i] == f)
+                dump_frame(f);
+        }
+    }
+    serial_puts("capture: done\n");
+
+    outb(0xf4, 0);
+    for (;;)
+        asm volatile ("hlt");
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * Framebuffer hashes for golden-image tests. "capture=N" on the kernel
+ * command line replaces the main loop with N frames on virtual time:
+ * each frame advances the LVGL tick by exactly 1000 / PORT_PACER_HZ ms,
+ * feeds the keys of a built-in script, redraws and prints
+ * "capture: frame F HASH". Real keys and serial commands are ignored, so
+ * two runs of the same build print the same hashes. "capture_dump=F,G"
+ * also prints those frames' pixels for capture-tool.py. QEMU exits at
+ * the end through isa-debug-exit on port 0xf4 (make golden-check).
+ */
+
+#if PORT_CAPTURE
+/* Frames requested with "capture=N", 0 if none */
+uint32_t capture_requested(void *mboot_info);
+/* Runs the capture and leaves QEMU; does not return */
+void capture_run(void *mboot_info, uint32_t frames);
+/* FNV-1a over the visible pixels as 32-bit words, alpha ignored */
+uint32_t capture_hash(void);
+/* Prints the current hash ('h' command) */
+void capture_print(void);
+/* Prints the current framebuffer ('d' command) */
+void capture_dump(void);
+#else
+static inline uint32_t capture_requested(void *mboot_info) { (void)mboot_info; return 0; }
+static inline void capture_run(void *mboot_info, uint32_t frames) { (void)mboot_info; (void)frames; }
+static inline uint32_t capture_hash(void) { return 0; }
+static inline void capture_print(void) {}
+static inline void capture_dump(void) {}
+#endif
+
+#endif
@@ -0,0 +1,46 @@
+#include <stddef.h>
+#include "cmdline.h"
+#include "multiboot.h"
+
+int strncmp(const char *s1, const char *s2, size_t n);
+
+static size_t length(const char *s) {
+    size_t n = 0;
+    while (s[n])
+        n++;
+    return n;
+}
+
+const char *cmdline_value(void *mboot_info, const char *name) {
+    multiboot_info_t *mb = mboot_info;
+    size_t len = length(name);
+
+    if (!mb || !(mb->flags & MULTIBOOT_INFO_CMDLINE))
+        return NULL;
+
+    /* Whole words only; GRUB puts the kernel path first */
+    const char *p = (const char *)mb->cmdline;
+    while (*p) {
+        while (*p == ' ')
+            p++;
+        if (strncmp(p, name, len) == 0 && p[len] == '=')
+            return p + len + 1;
+        while (*p && *p != ' ')
+            p++;
+    }
+    return NULL;
+}
+
+int cmdline_is(void *mboot_info, const char *name, const char *value) {
+    const char *v = cmdline_value(mboot_info, name);
+    size_t len = length(value);
+
+    return v && strncmp(v, value, len) == 0 && (v[len] == ' ' || v[len] == '\0');
+}
+
+uint32_t cmdline_parse_uint(const char **p) {
+    uint32_t v = 0;
+    while (**p >= '0' && **p <= '9')
+        v = v * 10 + (uint32_t)(*(*p)++ - '0');
+    return v;
+}
@@ -0,0 +1,14 @@
+#ifndef CMDLINE_H
+#define CMDLINE_H
+
+#include <stdint.h>
+
+/* Value of "name=value" on the kernel command line, NULL if absent. The
+ * value runs to the next space or the end of the line. */
+const char *cmdline_value(void *mboot_info, const char *name);
+/* Nonzero if the command line has exactly "name=value" */
+int cmdline_is(void *mboot_info, const char *name, const char *value);
+/* Decimal number at *p; *p is left on the first other character */
+uint32_t cmdline_parse_uint(const char **p);
+
+#endif
@@ -0,0 +1,377 @@
+#include "console.h"
+
+#if PORT_CONSOLE
+
+#include "scroll_accel.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "trace.h"
+#include "tsc.h"
+
+#define COLS        PORT_CONSOLE_COLS
+#define ROWS        PORT_CONSOLE_ROWS
+#define FIRST_CHAR  32
+#define LAST_CHAR   126
+#define GLYPHS      (LAST_CHAR - FIRST_CHAR + 1)
+#define TAB_WIDTH   8
+#define PIXEL_CF    LV_COLOR_FORMAT_XRGB8888
+
+typedef struct {
+    lv_obj_t *obj;
+    const lv_font_t *font;
+    lv_color_t fg;
+    lv_color_t bg;
+    int32_t cell_w;
+    int32_t cell_h;
+    uint32_t line;          /* Absolute number of the line being written */
+    uint32_t col;
+    uint32_t shown_top;     /* Line at the top of the pixel buffer */
+    int dirty;              /* Cells changed since the last sync */
+} console_t;
+
+static console_t con;
+static console_stats_t stats;
+static lv_display_t *hooked_disp;
+static lv_image_decoder_t *decoder;
+
+/* Line n lives in cells[n % ROWS]; only the last ROWS lines are shown */
+static char cells[ROWS][COLS];
+
+/* Pixels are rebuilt from the cells, so a warm-boot snapshot leaves them
+ * out. After a restore pixels_ready reads 0 and everything is redrawn */
+static uint8_t pixels[PORT_CONSOLE_BUF_SIZE] __attribute__((aligned(16))) SNAPSHOT_SKIP;
+static char shown[ROWS][COLS] SNAPSHOT_SKIP;    /* 0: cell not drawn */
+static int pixels_ready SNAPSHOT_SKIP;
+static lv_draw_buf_t atlas SNAPSHOT_SKIP;       /* GLYPHS cells in one row */
+static lv_draw_buf_t grid SNAPSHOT_SKIP;        /* What the console shows */
+
+static uint32_t atlas_size(int32_t cell_w, int32_t cell_h) {
+    return lv_draw_buf_width_to_stride(GLYPHS * cell_w, LV_COLOR_FORMAT_ARGB8888) * cell_h;
+}
+
+static uint32_t grid_size(int32_t cell_w, int32_t cell_h) {
+    return lv_draw_buf_width_to_stride(COLS * cell_w, PIXEL_CF) * ROWS * cell_h;
+}
+
+/* Renders the printable characters once through a throwaway label */
+static int build_atlas(void) {
+    char text[GLYPHS + 1];
+    for (int i = 0; i < GLYPHS; i++)
+        text[i] = (char)(FIRST_CHAR + i);
+    text[GLYPHS] = '\0';
+
+    int32_t w = GLYPHS * con.cell_w;
+    uint32_t stride = lv_draw_buf_width_to_stride(w, LV_COLOR_FORMAT_ARGB8888);
+    uint32_t asize = atlas_size(con.cell_w, con.cell_h);
+    lv_draw_buf_init(&atlas, w, con.cell_h, LV_COLOR_FORMAT_ARGB8888, stride, pixels, asize);
+    lv_draw_buf_init(&grid, COLS * con.cell_w, ROWS * con.cell_h, PIXEL_CF,
+                     lv_draw_buf_width_to_stride(COLS * con.cell_w, PIXEL_CF), pixels + asize,
+                     grid_size(con.cell_w, con.cell_h));
+
+    lv_obj_t *label = lv_label_create(con.obj);
+    lv_obj_remove_style_all(label);
+    lv_obj_set_style_text_font(label, con.font, 0);
+    lv_obj_set_style_text_color(label, con.fg, 0);
+    lv_obj_set_style_text_letter_space(label, 0, 0);
+    lv_obj_set_style_bg_color(label, con.bg, 0);
+    lv_obj_set_style_bg_opa(label, LV_OPA_COVER, 0);
+    lv_obj_set_size(label, w, con.cell_h);
+    lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+    lv_label_set_text_static(label, text);
+    lv_obj_update_layout(label);
+
+    trace_begin("console_atlas");
+    lv_result_t res = lv_snapshot_take_to_draw_buf(label, LV_COLOR_FORMAT_ARGB8888, &atlas);
+    trace_end("console_atlas");
+    lv_obj_delete(label);
+    return res == LV_RESULT_OK ? 0 : -1;
+}
+
+static void blit_cell(int32_t row, int32_t col, char c) {
+    uint32_t bytes = (uint32_t)con.cell_w * 4;
+    const uint8_t *src = (const uint8_t *)atlas.data + (c - FIRST_CHAR) * bytes;
+    uint8_t *dst = (uint8_t *)grid.data + (uint32_t)row * con.cell_h * grid.header.stride +
+                   (uint32_t)col * bytes;
+
+    for (int32_t y = 0; y < con.cell_h; y++) {
+        lv_memcpy(dst, src, bytes);
+        src += atlas.header.stride;
+        dst += grid.header.stride;
+    }
+}
+
+static void cell_area(int32_t row, int32_t col1, int32_t col2, lv_area_t *a) {
+    lv_obj_get_coords(con.obj, a);
+    a->x1 += col1 * con.cell_w;
+    a->x2 = a->x1 + (col2 - col1 + 1) * con.cell_w - 1;
+    a->y1 += row * con.cell_h;
+    a->y2 = a->y1 + con.cell_h - 1;
+}
+
+/* Moves the pixel buffer and the screen up by n text rows. 0 if the
+ * screen could not be moved and the console needs a full redraw */
+static int scroll_pixels(uint32_t n) {
+    uint32_t row_bytes = grid.header.stride * (uint32_t)con.cell_h;
+    uint8_t *data = grid.data;
+
+    lv_memmove(data, data + n * row_bytes, (ROWS - n) * row_bytes);
+    lv_memmove(shown, shown[n], (ROWS - n) * COLS);
+    lv_memset(shown[ROWS - n], 0, n * COLS);
+
+    lv_area_t a;
+    lv_obj_get_coords(con.obj, &a);
+    if (!scroll_accel_move_area(con.obj, &a, 0, -(int32_t)n * con.cell_h))
+        return 0;
+    stats.fast_scrolls++;
+    return 1;
+}
+
+/* Brings the pixel buffer up to date with the cells and invalidates what
+ * changed on screen. Runs before each refresh */
+static void sync(void) {
+    uint64_t t0 = rdtsc();
+    int full = 0;
+
+    if (!pixels_ready) {
+        if (build_atlas() != 0)
+            return;
+        pixels_ready = 1;
+        lv_memset(shown, 0, sizeof(shown));
+        full = 1;
+    }
+
+    uint32_t top = con.line + 1 > ROWS ? con.line + 1 - ROWS : 0;
+    uint32_t delta = top - con.shown_top;
+    con.shown_top = top;
+    if (delta >= ROWS) {
+        lv_memset(shown, 0, sizeof(shown));
+        full = 1;
+    } else if (delta && !full && !scroll_pixels(delta)) {
+        full = 1;
+    }
+
+    for (int32_t r = 0; r < ROWS; r++) {
+        uint32_t line = top + (uint32_t)r;
+        int32_t x1 = -1, x2 = -1;
+        for (int32_t c = 0; c < COLS; c++) {
+            char ch = line <= con.line ? cells[line % ROWS][c] : ' ';
+            if (shown[r][c] == ch)
+                continue;
+            blit_cell(r, c, ch);
+            shown[r][c] = ch;
+            stats.cells_drawn++;
+            if (x1 < 0)
+                x1 = c;
+            x2 = c;
+        }
+        if (x1 >= 0 && !full) {
+            lv_area_t a;
+            cell_area(r, x1, x2, &a);
+            lv_obj_invalidate_area(con.obj, &a);
+        }
+    }
+
+    if (full) {
+        lv_obj_invalidate(con.obj);
+        stats.full_redraws++;
+    }
+    con.dirty = 0;
+
+    uint32_t frac;
+    uint32_t us = (uint32_t)tsc_to_us(rdtsc() - t0, &frac);
+    stats.syncs++;
+    stats.sync_total_us += us;
+    if (us > stats.sync_max_us)
+        stats.sync_max_us = us;
+    trace_counter("console_sync_us", (int32_t)us);
+}
+
+static void refr_start_cb(lv_event_t *e) {
+    (void)e;
+    if (con.obj && (con.dirty || !pixels_ready))
+        sync();
+}
+
+/* The bin decoder is stubbed out (stdlib.c); the pixel buffer comes with
+ * a decoder that hands it out as is */
+static lv_result_t decoder_info(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc,
+                                lv_image_header_t *header) {
+    (void)dec;
+    if (dsc->src_type != LV_IMAGE_SRC_VARIABLE || dsc->src != &grid || !pixels_ready)
+        return LV_RESULT_INVALID;
+    *header = grid.header;
+    return LV_RESULT_OK;
+}
+
+static lv_result_t decoder_open(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc) {
+    (void)dec;
+    if (dsc->src != &grid || !pixels_ready)
+        return LV_RESULT_INVALID;
+    dsc->decoded = &grid;
+    return LV_RESULT_OK;
+}
+
+static void event_cb(lv_event_t *e) {
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_DRAW_MAIN: {
+            if (!pixels_ready)
+                break;
+            lv_draw_image_dsc_t dsc;
+            lv_area_t a;
+            lv_draw_image_dsc_init(&dsc);
+            dsc.src = &grid;
+            lv_obj_get_coords(con.obj, &a);
+            lv_draw_image(lv_event_get_layer(e), &dsc, &a);
+            break;
+        }
+        case LV_EVENT_DELETE:
+            lv_display_remove_event_cb_with_user_data(hooked_disp, refr_start_cb, NULL);
+            hooked_disp = NULL;
+            con.obj = NULL;
+            break;
+        default:
+            break;
+    }
+}
+
+lv_obj_t *console_create(lv_obj_t *parent, const lv_font_t *font, lv_color_t fg, lv_color_t bg) {
+    if (con.obj)
+        return NULL;
+
+    int32_t cell_w = lv_font_get_glyph_width(font, 'M', 0);
+    int32_t cell_h = lv_font_get_line_height(font);
+    if (atlas_size(cell_w, cell_h) + grid_size(cell_w, cell_h) > PORT_CONSOLE_BUF_SIZE)
+        return NULL;
+
+    if (!decoder) {
+        decoder = lv_image_decoder_create();
+        lv_image_decoder_set_info_cb(decoder, decoder_info);
+        lv_image_decoder_set_open_cb(decoder, decoder_open);
+    }
+
+    lv_memset(&con, 0, sizeof(con));
+    con.font = font;
+    con.fg = fg;
+    con.bg = bg;
+    con.cell_w = cell_w;
+    con.cell_h = cell_h;
+    lv_memset(cells, ' ', sizeof(cells));
+    pixels_ready = 0;
+
+    con.obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(con.obj);
+    lv_obj_set_size(con.obj, COLS * cell_w, ROWS * cell_h);
+    lv_obj_remove_flag(con.obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(con.obj, event_cb, LV_EVENT_ALL, NULL);
+
+    hooked_disp = lv_obj_get_display(con.obj);
+    lv_display_add_event_cb(hooked_disp, refr_start_cb, LV_EVENT_REFR_START, NULL);
+    return con.obj;
+}
+
+static void new_line(void) {
+    con.line++;
+    con.col = 0;
+    lv_memset(cells[con.line % ROWS], ' ', COLS);
+    stats.lines++;
+}
+
+void console_write(lv_obj_t *obj, const char *text, uint32_t len) {
+    if (!obj || obj != con.obj)
+        return;
+
+    for (uint32_t i = 0; i < len; i++) {
+        char c = text[i];
+        if (c == '\n') {
+            new_line();
+            continue;
+        }
+        if (c == '\r') {
+            con.col = 0;
+            continue;
+        }
+        if (con.col >= COLS)
+            new_line();
+        if (c == '\t') {
+            uint32_t next = (con.col / TAB_WIDTH + 1) * TAB_WIDTH;
+            con.col = next < COLS ? next : COLS;
+            continue;
+        }
+        if (c < FIRST_CHAR || c > LAST_CHAR)
+            c = '?';
+        cells[con.line % ROWS][con.col++] = c;
+    }
+    stats.bytes += len;
+    con.dirty = 1;
+}
+
+void console_puts(lv_obj_t *obj, const char *text) {
+    console_write(obj, text, lv_strlen(text));
+}
+
+void console_clear(lv_obj_t *obj) {
+    if (!obj || obj != con.obj)
+        return;
+    lv_memset(cells, ' ', sizeof(cells));
+    con.col = 0;
+    /* Start on a fresh screen: the next sync sees every row scrolled out */
+    con.line += ROWS;
+    con.dirty = 1;
+}
+
+void console_get_stats(console_stats_t *out) {
+    *out = stats;
+}
+
+/* Log flood for the 'L' command */
+static lv_timer_t *flood_timer;
+static uint32_t flood_start;
+static uint32_t flood_seq;
+
+static void flood_cb(lv_timer_t *t) {
+    char line[80];
+    (void)t;
+    for (int i = 0; i < PORT_CONSOLE_FLOOD_LINES; i++) {
+        int n = lv_snprintf(line, sizeof(line), "%08u t=%u sensor=%u status=ok\tqueue=%u\n",
+                            (unsigned)flood_seq, (unsigned)lv_tick_get(),
+                            (unsigned)(flood_seq * 2654435761u >> 22), (unsigned)(flood_seq % 97));
+        console_write(con.obj, line, (uint32_t)n);
+        flood_seq++;
+    }
+}
+
+void console_flood_toggle(void) {
+    if (!flood_timer) {
+        lv_obj_t *obj = console_create(lv_layer_top(), &lv_font_unscii_8,
+                                       lv_color_hex(0xC0C0C0), lv_color_hex(0x101010));
+        if (!obj) {
+            serial_puts("console: no room for the grid, raise PORT_CONSOLE_BUF_SIZE\n");
+            return;
+        }
+        lv_obj_align(obj, LV_ALIGN_BOTTOM_MID, 0, 0);
+        lv_memset(&stats, 0, sizeof(stats));
+        flood_seq = 0;
+        flood_start = lv_tick_get();
+        flood_timer = lv_timer_create(flood_cb, 1, NULL);
+        serial_puts("console flood started\n");
+        return;
+    }
+
+    uint32_t ms = lv_tick_elaps(flood_start);
+    lv_timer_delete(flood_timer);
+    flood_timer = NULL;
+    lv_obj_delete(con.obj);
+
+    serial_printf("console: %u lines, %u bytes in %u ms (%u lines/s)\n",
+                  (unsigned)stats.lines, (unsigned)stats.bytes, (unsigned)ms,
+                  (unsigned)(ms ? (uint64_t)stats.lines * 1000 / ms : 0));
+    serial_printf("  %u frames, sync avg %u us max %u us, %u cells drawn\n",
+                  (unsigned)stats.syncs,
+                  (unsigned)(stats.syncs ? stats.sync_total_us / stats.syncs : 0),
+                  (unsigned)stats.sync_max_us, (unsigned)stats.cells_drawn);
+    serial_printf("  %u fast scrolls, %u full redraws, %u KiB static\n",
+                  (unsigned)stats.fast_scrolls, (unsigned)stats.full_redraws,
+                  (unsigned)((sizeof(pixels) + sizeof(cells) + sizeof(shown)) / 1024));
+}
+
+#endif
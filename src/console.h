@@ -0,0 +1,55 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Text console for streaming logs: a PORT_CONSOLE_COLS x PORT_CONSOLE_ROWS
+ * grid of character cells in a monospace font. Writes only update a ring
+ * of cells. Once per frame the console compares the cells with what its
+ * pixel buffer shows. It blits changed cells from a glyph atlas rendered
+ * once at startup, and invalidates just those cells. When lines scroll,
+ * the buffer and the screen pixels are moved instead of redrawn. Memory
+ * is static (PORT_CONSOLE_BUF_SIZE for pixels), and a frame's work is
+ * bounded by the grid size however many lines arrived. Only printable
+ * ASCII is drawn; '\n', '\r' and '\t' are handled, other bytes show as
+ * '?'. There is one console at a time.
+ */
+typedef struct {
+    uint32_t lines;         /* Lines started */
+    uint32_t bytes;         /* Bytes written */
+    uint32_t syncs;         /* Frames that updated the pixel buffer */
+    uint32_t cells_drawn;   /* Cells blitted from the atlas */
+    uint32_t fast_scrolls;  /* Scrolls done by moving screen pixels */
+    uint32_t full_redraws;  /* Syncs that invalidated the whole console */
+    uint32_t sync_max_us;   /* Longest per-frame update */
+    uint64_t sync_total_us;
+} console_stats_t;
+
+#if PORT_CONSOLE
+/* NULL if a console exists already or the font's cells do not fit in
+ * PORT_CONSOLE_BUF_SIZE */
+lv_obj_t *console_create(lv_obj_t *parent, const lv_font_t *font, lv_color_t fg, lv_color_t bg);
+void console_write(lv_obj_t *con, const char *text, uint32_t len);
+void console_puts(lv_obj_t *con, const char *text);
+void console_clear(lv_obj_t *con);
+void console_get_stats(console_stats_t *stats);
+/* Starts or stops a console on the top layer that is fed
+ * PORT_CONSOLE_FLOOD_LINES lines per timer tick; stopping prints the
+ * ingestion rate and per-frame update times ('L' command) */
+void console_flood_toggle(void);
+#else
+static inline lv_obj_t *console_create(lv_obj_t *parent, const lv_font_t *font, lv_color_t fg, lv_color_t bg) {
+    (void)parent; (void)font; (void)fg; (void)bg;
+    return NULL;
+}
+static inline void console_write(lv_obj_t *con, const char *text, uint32_t len) { (void)con; (void)text; (void)len; }
+static inline void console_puts(lv_obj_t *con, const char *text) { (void)con; (void)text; }
+static inline void console_clear(lv_obj_t *con) { (void)con; }
+static inline void console_get_stats(console_stats_t *stats) { lv_memset(stats, 0, sizeof(*stats)); }
+static inline void console_flood_toggle(void) {}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+#include "cpu.h"
+#include "snapshot.h"
+
+/* CPUID.1:EDX, CPUID.1:ECX, CPUID.7.0:EBX */
+#define CPUID_FXSR     (1u << 24)
+#define CPUID_SSE2     (1u << 26)
+#define CPUID_XSAVE    (1u << 26)
+#define CPUID_AVX      (1u << 28)
+#define CPUID_AVX2     (1u << 5)
+
+#define CR0_MP         (1u << 1)
+#define CR0_EM         (1u << 2)
+#define CR4_OSFXSR     (1u << 9)
+#define CR4_OSXMMEXCPT (1u << 10)
+#define CR4_OSXSAVE    (1u << 18)
+
+/* x87, SSE and AVX state components */
+#define XCR0_AVX       0x7
+
+static uint32_t features SNAPSHOT_SKIP;
+
+static void cpuid(uint32_t leaf, uint32_t sub, uint32_t r[4]) {
+    asm volatile ("cpuid" : "=a"(r[0]), "=b"(r[1]), "=c"(r[2]), "=d"(r[3])
+                  : "a"(leaf), "c"(sub));
+}
+
+static uint32_t read_cr0(void) {
+    uint32_t v;
+    asm volatile ("mov %%cr0, %0" : "=r"(v));
+    return v;
+}
+
+static void write_cr0(uint32_t v) {
+    asm volatile ("mov %0, %%cr0" : : "r"(v));
+}
+
+static uint32_t read_cr4(void) {
+    uint32_t v;
+    asm volatile ("mov %%cr4, %0" : "=r"(v));
+    return v;
+}
+
+static void write_cr4(uint32_t v) {
+    asm volatile ("mov %0, %%cr4" : : "r"(v));
+}
+
+void cpu_init(void) {
+    uint32_t r[4];
+
+    features = 0;
+
+    cpuid(0, 0, r);
+    uint32_t max_leaf = r[0];
+
+    cpuid(1, 0, r);
+    uint32_t ecx1 = r[2], edx1 = r[3];
+    if (!(edx1 & CPUID_FXSR) || !(edx1 & CPUID_SSE2))
+        return;
+
+    write_cr0((read_cr0() & ~CR0_EM) | CR0_MP);
+    write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+    asm volatile ("fninit");
+    features |= CPU_SSE2;
+
+    if (!(ecx1 & CPUID_XSAVE) || !(ecx1 & CPUID_AVX) || max_leaf < 0xD)
+        return;
+    cpuid(7, 0, r);
+    if (!(r[1] & CPUID_AVX2))
+        return;
+    /* XCR0 bits the CPU can enable */
+    cpuid(0xD, 0, r);
+    if ((r[0] & XCR0_AVX) != XCR0_AVX)
+        return;
+
+    write_cr4(read_cr4() | CR4_OSXSAVE);
+    asm volatile ("xsetbv" : : "c"(0), "a"(XCR0_AVX), "d"(0));
+    features |= CPU_AVX2;
+}
+
+uint32_t cpu_features(void) {
+    return features;
+}
@@ -0,0 +1,16 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+#define CPU_SSE2  (1u << 0)
+#define CPU_AVX2  (1u << 1)
+
+/* Detects SIMD support with CPUID and turns it on: SSE through CR0/CR4,
+ * AVX through XCR0. Nothing here saves SSE state on interrupts, so only
+ * code that never runs in an IRQ handler may use it. */
+void cpu_init(void);
+/* CPU_* bits that cpu_init() enabled */
+uint32_t cpu_features(void);
+
+#endif
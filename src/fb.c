@@ -0,0 +1,87 @@
+#include <stddef.h>
+#include "fb.h"
+
+void *memcpy(void *dest, const void *src, size_t n);
+void *memmove(void *dest, const void *src, size_t n);
+
+void fb_blit(vbe_info_t *vbe, int32_t x, int32_t y, int32_t w, int32_t h,
+             const uint32_t *src) {
+    int32_t src_stride = w;
+
+    /* Clip against the framebuffer, keeping src aligned with the visible part */
+    if (x < 0) {
+        src -= x;
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        src -= y * src_stride;
+        h += y;
+        y = 0;
+    }
+    if (x + w > (int32_t)vbe->width)
+        w = (int32_t)vbe->width - x;
+    if (y + h > (int32_t)vbe->height)
+        h = (int32_t)vbe->height - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    uint32_t fb_stride = vbe->pitch / 4;
+    uint32_t *dst = vbe->framebuffer + y * fb_stride + x;
+    size_t row_bytes = (size_t)w * 4;
+
+    for (int32_t row = 0; row < h; row++) {
+        memcpy(dst, src, row_bytes);
+        dst += fb_stride;
+        src += src_stride;
+    }
+}
+
+void fb_move(vbe_info_t *vbe, int32_t x, int32_t y, int32_t w, int32_t h,
+             int32_t dx, int32_t dy) {
+    int32_t fw = (int32_t)vbe->width;
+    int32_t fh = (int32_t)vbe->height;
+
+    /* Clip so that both the source and the destination are on screen */
+    int32_t x1 = x, x2 = x + w, y1 = y, y2 = y + h;
+    if (x1 < 0) x1 = 0;
+    if (x1 + dx < 0) x1 = -dx;
+    if (x2 > fw) x2 = fw;
+    if (x2 + dx > fw) x2 = fw - dx;
+    if (y1 < 0) y1 = 0;
+    if (y1 + dy < 0) y1 = -dy;
+    if (y2 > fh) y2 = fh;
+    if (y2 + dy > fh) y2 = fh - dy;
+    if (x2 <= x1 || y2 <= y1)
+        return;
+
+    int32_t stride = (int32_t)(vbe->pitch / 4);
+    size_t row_bytes = (size_t)(x2 - x1) * 4;
+    uint32_t *src = vbe->framebuffer + y1 * stride + x1;
+    uint32_t *dst = src + dy * stride + dx;
+    int32_t rows = y2 - y1;
+
+    if (dy == 0) {
+        /* Rows overlap themselves only on a horizontal move */
+        for (int32_t row = 0; row < rows; row++) {
+            memmove(dst, src, row_bytes);
+            src += stride;
+            dst += stride;
+        }
+    } else if (dy < 0) {
+        for (int32_t row = 0; row < rows; row++) {
+            memcpy(dst, src, row_bytes);
+            src += stride;
+            dst += stride;
+        }
+    } else {
+        /* Moving down: copy bottom-up so no source row is overwritten first */
+        src += (rows - 1) * stride;
+        dst += (rows - 1) * stride;
+        for (int32_t row = 0; row < rows; row++) {
+            memcpy(dst, src, row_bytes);
+            src -= stride;
+            dst -= stride;
+        }
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef FB_H
+#define FB_H
+
+#include <stdint.h>
+#include "vbe.h"
+
+/* Copy a w*h block of 32-bit pixels (rows packed, stride = w) to the
+ * framebuffer at (x, y), clipped to the visible mode. */
+void fb_blit(vbe_info_t *vbe, int32_t x, int32_t y, int32_t w, int32_t h,
+             const uint32_t *src);
+
+/* Move the w*h block at (x, y) by (dx, dy) within the framebuffer. Source
+ * and destination may overlap; both are clipped to the visible mode. */
+void fb_move(vbe_info_t *vbe, int32_t x, int32_t y, int32_t w, int32_t h,
+             int32_t dx, int32_t dy);
+
+#endif
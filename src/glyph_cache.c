@@ -0,0 +1,358 @@
+#include "glyph_cache.h"
+
+#if PORT_GLYPH_CACHE
+
+/* Written against LVGL v9.2 (setup.sh checks out release/v9.2). The draw
+ * unit interface, the task fields and lv_draw_label_iterate_characters()
+ * are private API and changed between 9.x releases */
+#include "lvgl/lvgl.h"
+#include "lvgl/src/core/lv_global.h"
+#include "lvgl/src/draw/lv_draw_private.h"
+#include "lvgl/src/draw/lv_draw_label_private.h"
+#include "lvgl/src/draw/sw/lv_draw_sw.h"
+#include "serial.h"
+#include "snapshot.h"
+
+/* 9.2 has no id allocator: each renderer hard-codes a small id (software
+ * 1, VG-Lite and VGLite 2, PXP 3, Dave2D 4, SDL 100). Only the software
+ * one is built here, so the unit takes its position in LVGL's unit list */
+#if LV_USE_DRAW_VGLITE || LV_USE_DRAW_PXP || LV_USE_DRAW_DAVE2D || LV_USE_DRAW_SDL || \
+    LV_USE_DRAW_VG_LITE
+#error "glyph_cache.c: unit ids may clash with another renderer"
+#endif
+
+#define WAYS        4
+#define SETS        (PORT_GLYPH_CACHE_ENTRIES / WAYS)
+#define ARENA_PX    (PORT_GLYPH_CACHE_SIZE / 4)
+#define RUN_MAX     64      /* Glyphs of one label looked up before drawing */
+
+typedef struct {
+    const lv_font_t *font;
+    uint32_t gid;
+    uint32_t fg;
+    uint32_t bg;
+    uint16_t w;
+    uint16_t h;
+    uint32_t offset;        /* First pixel in the arena */
+    uint32_t last_use;
+    uint8_t valid;
+} entry_t;
+
+typedef struct {
+    lv_draw_unit_t base;
+    lv_draw_task_t *task_act;
+} glyph_unit_t;
+
+/* One glyph of the label being drawn */
+typedef struct {
+    const lv_font_t *font;
+    uint32_t gid;
+    uint32_t fg;
+    uint32_t bg;
+    lv_area_t coords;
+    lv_area_t vis;          /* Part inside the clip area */
+    entry_t *hit;
+    uint8_t keep;           /* Cache the pixels once LVGL has drawn them */
+} glyph_t;
+
+static struct {
+    glyph_t g[RUN_MAX];
+    uint32_t n;
+    uint8_t live;           /* LVGL draws the label */
+} run;
+
+static uint8_t unit_id;
+
+/* Pixels are cheap to rebuild, so none of this goes into a warm-boot
+ * snapshot; a restored kernel starts with an empty cache */
+static entry_t entries[SETS][WAYS] SNAPSHOT_SKIP;
+static uint32_t arena[ARENA_PX] SNAPSHOT_SKIP;
+static uint32_t head SNAPSHOT_SKIP;     /* Next free pixel in the ring */
+static uint32_t use_clock SNAPSHOT_SKIP;
+static glyph_cache_stats_t stats SNAPSHOT_SKIP;
+
+static uint32_t mix(uint32_t h, uint32_t v) {
+    return (h ^ v) * 16777619u;
+}
+
+static entry_t *set_of(const lv_font_t *font, uint32_t gid, uint32_t fg, uint32_t bg) {
+    uint32_t h = 2166136261u;
+    h = mix(h, (uint32_t)(uintptr_t)font);
+    h = mix(h, gid);
+    h = mix(h, fg);
+    h = mix(h, bg);
+    return entries[(h ^ (h >> 16)) % SETS];
+}
+
+static void drop(entry_t *e) {
+    if (!e->valid)
+        return;
+    e->valid = 0;
+    stats.entries--;
+    stats.evictions++;
+}
+
+/* Room for npx pixels at the ring head. Whatever was stored there is
+ * the oldest content, so it goes */
+static int alloc(uint32_t npx, uint32_t *offset) {
+    if (npx > ARENA_PX)
+        return -1;
+    if (head + npx > ARENA_PX)
+        head = 0;
+
+    for (uint32_t s = 0; s < SETS; s++) {
+        for (uint32_t i = 0; i < WAYS; i++) {
+            entry_t *e = &entries[s][i];
+            if (e->valid && e->offset < head + npx &&
+                e->offset + (uint32_t)e->w * e->h > head)
+                drop(e);
+        }
+    }
+    *offset = head;
+    head += npx;
+    return 0;
+}
+
+static uint32_t *layer_px(lv_layer_t *layer, int32_t x, int32_t y) {
+    return lv_draw_layer_go_to_xy(layer, x - layer->buf_area.x1, y - layer->buf_area.y1);
+}
+
+/* The background color if every visible pixel of the glyph box is the
+ * same opaque color, else 0 (transparent black is never opaque) */
+static uint32_t solid_bg(lv_layer_t *layer, const lv_area_t *a) {
+    uint32_t stride = layer->draw_buf->header.stride;
+    int32_t w = lv_area_get_width(a);
+    uint8_t *row = (uint8_t *)layer_px(layer, a->x1, a->y1);
+    uint32_t bg = *(uint32_t *)row;
+
+    if ((bg >> 24) != 0xFF)
+        return 0;
+    for (int32_t y = a->y1; y <= a->y2; y++, row += stride) {
+        const uint32_t *px = (const uint32_t *)row;
+        for (int32_t x = 0; x < w; x++) {
+            if (px[x] != bg)
+                return 0;
+        }
+    }
+    return bg;
+}
+
+/* Copies rect a of the layer to or from a buffer buf_w pixels wide */
+static void copy_rect(lv_layer_t *layer, const lv_area_t *a, uint32_t *buf, uint32_t buf_w,
+                      int to_layer) {
+    uint32_t stride = layer->draw_buf->header.stride;
+    uint32_t bytes = (uint32_t)lv_area_get_width(a) * 4;
+    uint8_t *row = (uint8_t *)layer_px(layer, a->x1, a->y1);
+
+    for (int32_t y = a->y1; y <= a->y2; y++, row += stride, buf += buf_w) {
+        if (to_layer)
+            lv_memcpy(row, buf, bytes);
+        else
+            lv_memcpy(buf, row, bytes);
+    }
+}
+
+static int cacheable(lv_draw_unit_t *u, const lv_draw_glyph_dsc_t *g) {
+    lv_color_format_t cf = u->target_layer->color_format;
+    return g->format > LV_FONT_GLYPH_FORMAT_NONE && g->format <= LV_FONT_GLYPH_FORMAT_A8 &&
+           g->opa >= LV_OPA_MAX && g->g && g->g->resolved_font &&
+           (cf == LV_COLOR_FORMAT_ARGB8888 || cf == LV_COLOR_FORMAT_XRGB8888);
+}
+
+static entry_t *lookup(const glyph_t *r) {
+    entry_t *set = set_of(r->font, r->gid, r->fg, r->bg);
+    uint32_t w = (uint32_t)lv_area_get_width(&r->coords);
+    uint32_t h = (uint32_t)lv_area_get_height(&r->coords);
+
+    for (uint32_t i = 0; i < WAYS; i++) {
+        entry_t *e = &set[i];
+        if (e->valid && e->font == r->font && e->gid == r->gid && e->fg == r->fg &&
+            e->bg == r->bg && e->w == w && e->h == h)
+            return e;
+    }
+    return NULL;
+}
+
+/* First pass over the label: samples each glyph's background before
+ * anything is drawn and looks it up. Anything that cannot be copied
+ * hands the whole label to LVGL */
+static void probe_cb(lv_draw_unit_t *u, lv_draw_glyph_dsc_t *g, lv_draw_fill_dsc_t *fill,
+                     const lv_area_t *fill_area) {
+    /* Underline, strikethrough and the selection background */
+    if (fill && fill_area)
+        run.live = 1;
+
+    lv_area_t a;
+    if (!g || !lv_area_intersect(&a, g->letter_coords, u->clip_area))
+        return;
+    if (!cacheable(u, g) || run.n == RUN_MAX) {
+        run.live = 1;
+        return;
+    }
+    uint32_t bg = solid_bg(u->target_layer, &a);
+    if (!bg) {
+        stats.not_solid++;
+        run.live = 1;
+        return;
+    }
+
+    glyph_t *r = &run.g[run.n++];
+    r->font = g->g->resolved_font;
+    r->gid = g->g->gid.index;
+    r->fg = lv_color_to_u32(g->color);
+    r->bg = bg;
+    r->coords = *g->letter_coords;
+    r->vis = a;
+    /* Only a fully visible glyph leaves a complete copy in the layer */
+    r->keep = lv_area_is_in(&r->coords, &a, 0);
+    r->hit = lookup(r);
+    if (!r->hit)
+        run.live = 1;
+
+    /* Overlapping neighbours (kerning, italics) would end up in each
+     * other's pixels */
+    if (run.n > 1 && lv_area_is_on(&r[-1].coords, &r->coords)) {
+        r[-1].keep = 0;
+        r->keep = 0;
+        run.live = 1;
+    }
+}
+
+static void copy_hits(lv_layer_t *layer) {
+    for (uint32_t i = 0; i < run.n; i++) {
+        glyph_t *r = &run.g[i];
+        uint32_t w = (uint32_t)lv_area_get_width(&r->coords);
+        uint32_t skip = (uint32_t)(r->vis.y1 - r->coords.y1) * w +
+                        (uint32_t)(r->vis.x1 - r->coords.x1);
+        copy_rect(layer, &r->vis, arena + r->hit->offset + skip, w, 1);
+        r->hit->last_use = ++use_clock;
+    }
+    stats.hits += run.n;
+}
+
+/* After LVGL has drawn the label, keeps the glyphs that were missing */
+static void insert_misses(lv_layer_t *layer) {
+    for (uint32_t i = 0; i < run.n; i++) {
+        glyph_t *r = &run.g[i];
+        if (r->hit || !r->keep || lookup(r))
+            continue;
+
+        entry_t *set = set_of(r->font, r->gid, r->fg, r->bg);
+        entry_t *victim = &set[0];
+        for (uint32_t j = 0; j < WAYS; j++) {
+            if (!set[j].valid) {
+                victim = &set[j];
+                break;
+            }
+            if (set[j].last_use < victim->last_use)
+                victim = &set[j];
+        }
+        drop(victim);
+
+        uint32_t w = (uint32_t)lv_area_get_width(&r->coords);
+        uint32_t h = (uint32_t)lv_area_get_height(&r->coords);
+        uint32_t offset;
+        if (alloc(w * h, &offset) != 0)
+            continue;
+        copy_rect(layer, &r->vis, arena + offset, w, 0);
+        *victim = (entry_t){ r->font, r->gid, r->fg, r->bg, (uint16_t)w, (uint16_t)h,
+                             offset, ++use_clock, 1 };
+        stats.entries++;
+        stats.inserts++;
+    }
+    stats.misses += run.n;
+}
+
+/* Copies the label from the cache if every glyph is there; otherwise
+ * LVGL's software renderer draws it and the new glyphs are kept */
+static void draw_label(lv_draw_unit_t *u, const lv_draw_label_dsc_t *dsc,
+                       const lv_area_t *coords) {
+    run.n = 0;
+    run.live = 0;
+    lv_draw_label_iterate_characters(u, dsc, coords, probe_cb);
+
+    if (!run.live) {
+        copy_hits(u->target_layer);
+        return;
+    }
+    lv_draw_sw_label(u, dsc, coords);
+    insert_misses(u->target_layer);
+}
+
+/* The newest unit is asked first, while the task still has the default
+ * score; the software renderer only claims tasks at that score, so one
+ * point better keeps it here */
+static int32_t evaluate_cb(lv_draw_unit_t *u, lv_draw_task_t *t) {
+    (void)u;
+    if (t->type != LV_DRAW_TASK_TYPE_LABEL)
+        return 0;
+
+    const lv_draw_label_dsc_t *dsc = t->draw_dsc;
+    if (dsc->opa >= LV_OPA_MAX && dsc->blend_mode == LV_BLEND_MODE_NORMAL &&
+        t->preference_score > 0) {
+        t->preference_score--;
+        t->preferred_draw_unit_id = unit_id;
+    }
+    return 0;
+}
+
+static int32_t dispatch_cb(lv_draw_unit_t *draw_unit, lv_layer_t *layer) {
+    glyph_unit_t *u = (glyph_unit_t *)draw_unit;
+    if (u->task_act)
+        return 0;
+
+    lv_draw_task_t *t = lv_draw_get_next_available_task(layer, NULL, unit_id);
+    if (!t || t->preferred_draw_unit_id != unit_id)
+        return LV_DRAW_UNIT_IDLE;
+    if (!lv_draw_layer_alloc_buf(layer))
+        return LV_DRAW_UNIT_IDLE;
+
+    t->state = LV_DRAW_TASK_STATE_IN_PROGRESS;
+    u->task_act = t;
+    draw_unit->target_layer = layer;
+    draw_unit->clip_area = &t->clip_area;
+
+    lv_area_t draw_area;
+    if (lv_area_intersect(&draw_area, &t->area, &t->clip_area))
+        draw_label(draw_unit, t->draw_dsc, &t->area);
+
+    t->state = LV_DRAW_TASK_STATE_READY;
+    u->task_act = NULL;
+    lv_draw_dispatch_request();
+    return 1;
+}
+
+void glyph_cache_init(void) {
+    glyph_unit_t *u = lv_draw_create_unit(sizeof(glyph_unit_t));
+    u->base.evaluate_cb = evaluate_cb;
+    u->base.dispatch_cb = dispatch_cb;
+    /* The software units are made in lv_init(), so this is at least 2 */
+    unit_id = (uint8_t)LV_GLOBAL_DEFAULT()->draw_info.unit_cnt;
+}
+
+void glyph_cache_flush(void) {
+    for (uint32_t s = 0; s < SETS; s++) {
+        for (uint32_t i = 0; i < WAYS; i++)
+            entries[s][i].valid = 0;
+    }
+    stats.entries = 0;
+    head = 0;
+}
+
+void glyph_cache_get_stats(glyph_cache_stats_t *out) {
+    *out = stats;
+}
+
+void glyph_cache_dump(void) {
+    uint32_t lookups = stats.hits + stats.misses;
+
+    serial_printf("glyph cache: %u/%u entries, %u KiB ring\n", (unsigned)stats.entries,
+                  (unsigned)PORT_GLYPH_CACHE_ENTRIES, (unsigned)(PORT_GLYPH_CACHE_SIZE / 1024));
+    serial_printf("  hits %u misses %u (%u%% hit), inserts %u, evictions %u, not solid %u\n",
+                  (unsigned)stats.hits, (unsigned)stats.misses,
+                  (unsigned)(lookups ? (uint64_t)stats.hits * 100 / lookups : 0),
+                  (unsigned)stats.inserts, (unsigned)stats.evictions,
+                  (unsigned)stats.not_solid);
+}
+
+#endif
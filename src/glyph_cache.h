@@ -0,0 +1,41 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * Pre-blended glyphs. Label draw tasks run on a draw unit of their own.
+ * If every glyph of a label sits on a solid opaque background and is in
+ * the cache, the pixels are copied instead of blending the coverage
+ * masks; otherwise LVGL's software renderer draws the label and the new
+ * glyphs are kept. Entries are keyed by (font, glyph, text color,
+ * background color). Depends on LVGL v9.2 draw unit internals.
+ * Pixels live in a ring of PORT_GLYPH_CACHE_SIZE bytes; new glyphs
+ * overwrite the oldest ones.
+ */
+typedef struct {
+    uint32_t hits;          /* Glyphs copied from the cache */
+    uint32_t misses;        /* Cacheable glyphs in labels LVGL drew */
+    uint32_t inserts;
+    uint32_t evictions;     /* Entries overwritten in the ring or their set */
+    uint32_t not_solid;     /* Glyphs over a non-uniform or translucent background */
+    uint32_t entries;       /* Valid entries */
+} glyph_cache_stats_t;
+
+#if PORT_GLYPH_CACHE
+/* Registers the draw unit; call after lv_init() */
+void glyph_cache_init(void);
+/* Drops every entry (e.g. after changing a font's glyph data) */
+void glyph_cache_flush(void);
+void glyph_cache_get_stats(glyph_cache_stats_t *stats);
+/* Prints the stats on serial ('g' command) */
+void glyph_cache_dump(void);
+#else
+static inline void glyph_cache_init(void) {}
+static inline void glyph_cache_flush(void) {}
+static inline void glyph_cache_get_stats(glyph_cache_stats_t *stats) { *stats = (glyph_cache_stats_t){ 0 }; }
+static inline void glyph_cache_dump(void) {}
+#endif
+
+#endif
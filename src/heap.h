@@ -0,0 +1,47 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Statistics of the kernel heap in stdlib.c */
+typedef struct {
+    uint32_t total_size;
+    uint32_t used_size;         /* Including block headers */
+    uint32_t free_size;
+    uint32_t largest_free;
+    uint32_t used_cnt;
+    uint32_t free_cnt;
+    uint32_t peak_used;         /* High-water mark of used_size */
+    uint8_t frag_pct;           /* 100 - largest_free / free_size */
+    uint32_t alloc_total;       /* Cumulative malloc/calloc/moving realloc calls */
+    uint32_t free_total;
+    uint64_t alloc_bytes;       /* Cumulative bytes handed out */
+} heap_stats_t;
+
+/* Bytes and blocks allocated from one call site (return address) */
+typedef struct {
+    uint32_t caller;
+    uint32_t allocs;
+    uint64_t bytes;
+    uint32_t live_blocks;
+    uint32_t live_bytes;
+} heap_callsite_t;
+
+void heap_get_stats(heap_stats_t *stats);
+
+/* Copies the call-site table (PORT_MEM_CALLSITES builds only); returns the
+ * number of entries written */
+int heap_get_callsites(heap_callsite_t *out, int max);
+void heap_reset_callsites(void);
+
+/* Called on every lv_malloc/lv_realloc/lv_free while set, NULL stops it.
+ * Blocks are named by their offset in the heap / 8. For 'r', id is the
+ * block passed in and new_id the one returned; 'f' has no size. */
+typedef void (*heap_trace_cb_t)(char op, uint32_t id, uint32_t size, uint32_t new_id);
+void heap_set_trace(heap_trace_cb_t cb);
+
+/* Walks every block and checks the headers and free list; 0 if intact */
+int heap_check(void);
+
+#endif
@@ -0,0 +1,120 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bench.h"
+
+#define BENCH_MIN_NS  (50ull * 1000 * 1000)
+#define BENCH_REPEATS 3
+
+volatile uintptr_t bench_sink;
+
+static const bench_group_t groups[] = {
+    { "mem",   bench_mem },
+    { "alloc", bench_alloc },
+    { "fmt",   bench_fmt },
+    { "flush", bench_flush },
+    { "kbd",   bench_kbd },
+    { "div64", bench_div64 },
+    { "blend", bench_blend },
+};
+
+uint64_t bench_cycles(void) {
+#if defined(__i386__) || defined(__x86_64__)
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return 0;
+#endif
+}
+
+uint64_t bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void bench_case(const char *name, bench_fn fn, void *ctx, double bytes_per_op) {
+    uint64_t iters = 1;
+    uint64_t elapsed;
+    uint64_t cycles;
+
+    /* Grow the batch until a single run is long enough to time reliably */
+    for (;;) {
+        uint64_t start = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        fn(ctx, iters);
+        cycles = bench_cycles() - c0;
+        elapsed = bench_now_ns() - start;
+        if (elapsed >= BENCH_MIN_NS || iters >= (1ull << 40))
+            break;
+        iters *= 2;
+    }
+
+    for (int i = 1; i < BENCH_REPEATS; i++) {
+        uint64_t start = bench_now_ns();
+        uint64_t c0 = bench_cycles();
+        fn(ctx, iters);
+        uint64_t c = bench_cycles() - c0;
+        uint64_t t = bench_now_ns() - start;
+        if (t < elapsed) {
+            elapsed = t;
+            cycles = c;
+        }
+    }
+
+    double ns_per_op = (double)elapsed / (double)iters;
+    double cyc_per_op = (double)cycles / (double)iters;
+    if (bytes_per_op > 0)
+        printf("  %-40s %12.2f ns/op %10.1f tsc/op %10.2f MB/s\n", name, ns_per_op,
+               cyc_per_op, bytes_per_op * 1e3 / ns_per_op);
+    else
+        printf("  %-40s %12.2f ns/op %10.1f tsc/op\n", name, ns_per_op, cyc_per_op);
+}
+
+void bench_note(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    printf("  ");
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+/*
+ * Usage: bench [group...] [-- group options]
+ * With no group names every group runs. Options after "--" are passed to
+ * the groups (e.g. "bench alloc -- trace.txt").
+ */
+int main(int argc, char **argv) {
+    int ngroups = sizeof(groups) / sizeof(groups[0]);
+    int nsel = argc - 1;
+    int gargc = 0;
+    char **gargv = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--") == 0) {
+            nsel = i - 1;
+            gargc = argc - i - 1;
+            gargv = argv + i + 1;
+            break;
+        }
+    }
+
+    for (int g = 0; g < ngroups; g++) {
+        int selected = nsel == 0;
+        for (int i = 1; i <= nsel; i++) {
+            if (strcmp(argv[i], groups[g].name) == 0)
+                selected = 1;
+        }
+        if (!selected)
+            continue;
+
+        printf("[%s]\n", groups[g].name);
+        groups[g].run(gargc, gargv);
+        fflush(stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Tiny microbenchmark harness for the host build of the port layer.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+/* Runs the measured operation `iters` times */
+typedef void (*bench_fn)(void *ctx, uint64_t iters);
+
+typedef struct {
+    const char *name;
+    void (*run)(int argc, char **argv);
+} bench_group_t;
+
+uint64_t bench_now_ns(void);
+
+/* Raw time-stamp counter (0 where unavailable) */
+uint64_t bench_cycles(void);
+
+/* Calibrates an iteration count, keeps the best of several runs and prints
+ * ns/op and TSC ticks/op (plus throughput when bytes_per_op is non-zero). */
+void bench_case(const char *name, bench_fn fn, void *ctx, double bytes_per_op);
+
+/* Print a free-form result line under the current group */
+void bench_note(const char *fmt, ...);
+
+/* Defeats dead-code elimination of benchmarked results */
+extern volatile uintptr_t bench_sink;
+
+void bench_mem(int argc, char **argv);
+void bench_alloc(int argc, char **argv);
+void bench_fmt(int argc, char **argv);
+void bench_flush(int argc, char **argv);
+void bench_kbd(int argc, char **argv);
+void bench_div64(int argc, char **argv);
+void bench_blend(int argc, char **argv);
+
+#endif
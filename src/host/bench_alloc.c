@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "port_host.h"
+#include "port_conf.h"
+#include "heap.h"
+
+/*
+ * Replays allocator traces against the port heap.
+ *
+ * Trace format, one operation per line:
+ *   m <id> <size>            malloc, result stored in slot <id>
+ *   r <id> <size> [<new>]    realloc slot <id>, result in slot <new>
+ *   f <id>                   free slot <id>
+ *
+ * The kernel writes real LVGL traffic in this format with the 'a' serial
+ * command; its ids are heap offsets / 8, so any id below the heap size
+ * / 8 is accepted. Without a trace file a synthetic mix shaped like
+ * create_ui() (small object/style allocations, growing style arrays,
+ * short label strings) is used.
+ */
+#define MAX_SLOTS (PORT_HEAP_SIZE / 8)
+
+/* Live payload the synthetic mix stays under. Past it, allocations and
+ * growing reallocs turn into frees, so the mix settles like a UI that is
+ * built and torn down in turns. Half the heap leaves room for headers
+ * and fragmentation. */
+#define SYNTH_BUDGET (PORT_HEAP_SIZE / 2)
+#define SYNTH_MAX_SIZE 2048
+
+typedef struct {
+    char op;
+    uint32_t id;
+    uint32_t size;
+    uint32_t new_id;
+} alloc_op_t;
+
+typedef struct {
+    alloc_op_t *ops;
+    size_t count;
+    size_t completed;   /* ops done before the heap ran out, last replay */
+} alloc_trace_t;
+
+static void *slots[MAX_SLOTS];
+
+static int load_trace(const char *path, alloc_trace_t *t) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    size_t cap = 1024;
+    t->ops = malloc(cap * sizeof(*t->ops));
+    t->count = 0;
+
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        alloc_op_t op = { 0, 0, 0, 0 };
+        int n = sscanf(line, " %c %u %u %u", &op.op, &op.id, &op.size, &op.new_id);
+        if (n < 2 || op.id >= MAX_SLOTS || (op.op != 'f' && n < 3))
+            continue;
+        if (op.op != 'm' && op.op != 'r' && op.op != 'f')
+            continue;
+        if (n < 4)
+            op.new_id = op.id;
+        else if (op.new_id >= MAX_SLOTS)
+            continue;
+        if (t->count == cap) {
+            cap *= 2;
+            t->ops = realloc(t->ops, cap * sizeof(*t->ops));
+        }
+        t->ops[t->count++] = op;
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static void synth_trace(alloc_trace_t *t, size_t count) {
+    static const uint32_t sizes[] = { 16, 24, 32, 48, 64, 96, 128, 256, 512 };
+    static uint32_t live[MAX_SLOTS];
+    static uint32_t live_sizes[MAX_SLOTS];
+    static uint32_t free_ids[MAX_SLOTS];
+    size_t nlive = 0;
+    size_t nfree = 0;
+    uint32_t live_bytes = 0;
+    uint32_t seed = 12345;
+
+    for (uint32_t id = MAX_SLOTS; id > 0; id--)
+        free_ids[nfree++] = id - 1;
+
+    t->ops = malloc(count * sizeof(*t->ops));
+    t->count = 0;
+
+    while (t->count < count) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t r = (seed >> 16) % 100;
+        uint32_t size = sizes[(seed >> 8) % (sizeof(sizes) / sizeof(sizes[0]))];
+        size_t k = nlive ? (seed >> 4) % nlive : 0;
+        alloc_op_t op = { 0, 0, 0, 0 };
+
+        if (r >= 90 && nlive) {
+            size = live_sizes[k] + 8 + (seed >> 12) % 57;
+            if (size > SYNTH_MAX_SIZE || live_bytes - live_sizes[k] + size > SYNTH_BUDGET)
+                r = 60;
+        }
+
+        if (nlive == 0 || (r < 60 && nfree && live_bytes + size <= SYNTH_BUDGET)) {
+            op.op = 'm';
+            op.id = free_ids[--nfree];
+            op.size = size;
+            live[nlive] = op.id;
+            live_sizes[nlive++] = size;
+            live_bytes += size;
+        } else if (r < 90) {
+            op.op = 'f';
+            op.id = live[k];
+            live_bytes -= live_sizes[k];
+            free_ids[nfree++] = live[k];
+            live[k] = live[--nlive];
+            live_sizes[k] = live_sizes[nlive];
+        } else {
+            op.op = 'r';
+            op.id = live[k];
+            op.size = size;
+            live_bytes += size - live_sizes[k];
+            live_sizes[k] = size;
+        }
+        op.new_id = op.id;
+        t->ops[t->count++] = op;
+    }
+}
+
+static void replay(alloc_trace_t *t) {
+    jmp_buf env;
+    volatile size_t i = 0;
+
+    lv_mem_init();
+    memset(slots, 0, sizeof(slots));
+
+    host_panic_jmp = &env;
+    if (setjmp(env) == 0) {
+        for (; i < t->count; i++) {
+            alloc_op_t *op = &t->ops[i];
+            switch (op->op) {
+                case 'm':
+                    slots[op->id] = port_malloc(op->size);
+                    break;
+                case 'r': {
+                    void *p = port_realloc(slots[op->id], op->size);
+                    slots[op->id] = NULL;
+                    slots[op->new_id] = p;
+                    break;
+                }
+                case 'f':
+                    port_free(slots[op->id]);
+                    slots[op->id] = NULL;
+                    break;
+            }
+        }
+    }
+    host_panic_jmp = NULL;
+
+    t->completed = i;
+}
+
+static void run_replay(void *ctx, uint64_t iters) {
+    alloc_trace_t *t = ctx;
+    for (uint64_t i = 0; i < iters; i++)
+        replay(t);
+}
+
+void bench_alloc(int argc, char **argv) {
+    alloc_trace_t trace;
+    char name[64];
+
+    if (argc > 0) {
+        if (load_trace(argv[0], &trace) != 0)
+            return;
+        snprintf(name, sizeof(name), "replay/%s", argv[0]);
+    } else {
+        synth_trace(&trace, 4000);
+        snprintf(name, sizeof(name), "replay/synthetic");
+    }
+
+    heap_stats_t st;
+    replay(&trace);
+    size_t completed = trace.completed;
+    heap_get_stats(&st);
+    int check = heap_check();
+    bench_case(name, run_replay, &trace, 0);
+    if (completed < trace.count)
+        bench_note("%zu ops in trace, heap exhausted after %zu", trace.count, completed);
+    else
+        bench_note("%zu ops in trace, all completed", trace.count);
+    bench_note("peak %u of %u bytes, %u live blocks, %u free blocks, "
+               "largest free %u, frag %u%%, heap check %d",
+               st.peak_used, st.total_size, st.used_cnt, st.free_cnt,
+               st.largest_free, st.frag_pct, check);
+
+    free(trace.ops);
+}
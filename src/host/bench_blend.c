@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "blend_sw.h"
+#ifdef HOST_LVGL_BLEND
+#include "lvgl_blend_ref.h"
+#define REF_NAME "lvgl"
+#else
+#define REF_NAME "c"
+#endif
+
+/* One partial buffer band at 640x480, the area LVGL blends into */
+#define BAND_W 640
+#define BAND_H 24
+#define BAND_PX (BAND_W * BAND_H)
+#define STRIDE (BAND_W * 4)
+
+typedef enum {
+    OP_FILL,
+    OP_COLOR_OPA,
+    OP_COLOR_MASK,
+    OP_COLOR_MASK_OPA,
+    OP_ARGB,
+    OP_ARGB_OPA,
+    OP_ARGB_LAYER,
+    OP_XRGB,
+    OP_COUNT
+} blend_op_t;
+
+static const char *const op_names[OP_COUNT] = {
+    "fill", "color_opa", "color_mask", "color_mask_opa",
+    "argb", "argb_opa", "argb_layer", "xrgb",
+};
+
+typedef struct {
+    uint32_t dest[BAND_PX];
+    uint32_t dest_init[BAND_PX];
+    uint32_t layer_init[BAND_PX];   /* Translucent, like a layer being built */
+    uint32_t ref[BAND_PX];
+    uint32_t src[BAND_PX];
+    uint8_t mask[BAND_PX];
+    blend_op_t op;
+} blend_ctx_t;
+
+static void do_op(blend_ctx_t *c) {
+    switch (c->op) {
+        case OP_FILL:
+            blend_sw_fill(c->dest, BAND_W, BAND_H, STRIDE, 0xFF2196F3u);
+            break;
+        case OP_COLOR_OPA:
+            blend_sw_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFF2196F3u, 128, NULL, 0);
+            break;
+        case OP_COLOR_MASK:
+            blend_sw_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFFFFFFFFu, 255, c->mask, BAND_W);
+            break;
+        case OP_COLOR_MASK_OPA:
+            blend_sw_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFFFFFFFFu, 160, c->mask, BAND_W);
+            break;
+        case OP_ARGB:
+        case OP_ARGB_LAYER:
+            blend_sw_argb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE, 255, NULL, 0);
+            break;
+        case OP_ARGB_OPA:
+            blend_sw_argb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE, 100, NULL, 0);
+            break;
+        default:
+            blend_sw_xrgb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE, 4);
+            break;
+    }
+}
+
+#ifdef HOST_LVGL_BLEND
+/* The same operation through LVGL's C loops */
+static void do_lvgl(blend_ctx_t *c) {
+    switch (c->op) {
+        case OP_FILL:
+            lvgl_ref_fill(c->dest, BAND_W, BAND_H, STRIDE, 0xFF2196F3u);
+            break;
+        case OP_COLOR_OPA:
+            lvgl_ref_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFF2196F3u, 128, NULL, 0);
+            break;
+        case OP_COLOR_MASK:
+            lvgl_ref_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFFFFFFFFu, 255, c->mask, BAND_W);
+            break;
+        case OP_COLOR_MASK_OPA:
+            lvgl_ref_color(c->dest, BAND_W, BAND_H, STRIDE, 0xFFFFFFFFu, 160, c->mask, BAND_W);
+            break;
+        case OP_ARGB:
+        case OP_ARGB_LAYER:
+            lvgl_ref_argb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE, 255, NULL, 0);
+            break;
+        case OP_ARGB_OPA:
+            lvgl_ref_argb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE, 100, NULL, 0);
+            break;
+        default:
+            lvgl_ref_xrgb(c->dest, BAND_W, BAND_H, STRIDE, c->src, STRIDE);
+            break;
+    }
+}
+
+static void run_lvgl(void *ctx, uint64_t iters) {
+    blend_ctx_t *c = ctx;
+    for (uint64_t i = 0; i < iters; i++) {
+        do_lvgl(c);
+        bench_sink += c->dest[i % BAND_PX];
+    }
+}
+#endif
+
+static void reset(blend_ctx_t *c) {
+    memcpy(c->dest, c->op == OP_ARGB_LAYER ? c->layer_init : c->dest_init, sizeof(c->dest));
+}
+
+static void run_blend(void *ctx, uint64_t iters) {
+    blend_ctx_t *c = ctx;
+    for (uint64_t i = 0; i < iters; i++) {
+        do_op(c);
+        bench_sink += c->dest[i % BAND_PX];
+    }
+}
+
+static void fill_inputs(blend_ctx_t *c) {
+    uint32_t s = 0x2545F491u;
+    for (int i = 0; i < BAND_PX; i++) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        int x = i % BAND_W;
+        c->dest_init[i] = 0xFF000000u | (s & 0xFFFFFF);
+        c->layer_init[i] = s;
+        /* Image with opaque, clear and antialiased runs */
+        uint32_t a = (x / 32) % 3 == 0 ? 255 : (x / 32) % 3 == 1 ? 0 : (s >> 24);
+        c->src[i] = a << 24 | ((s >> 5) & 0xFFFFFF);
+        /* Glyph-like coverage: mostly empty or solid, edges in between */
+        int cell = x % 12;
+        c->mask[i] = cell < 3 ? 0 : cell < 5 ? (uint8_t)(s >> 8) : cell < 10 ? 255 : 0;
+    }
+}
+
+void bench_blend(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static blend_ctx_t c;
+    char name[64];
+    fill_inputs(&c);
+
+    int avail[BLEND_SW_IMPL_COUNT] = { 1, 0, 0 };
+#if defined(__i386__) || defined(__x86_64__)
+    avail[BLEND_SW_SSE2] = __builtin_cpu_supports("sse2");
+    avail[BLEND_SW_AVX2] = __builtin_cpu_supports("avx2");
+#endif
+
+#ifndef HOST_LVGL_BLEND
+    bench_note("no LVGL checkout: pixels are compared with the c kernels");
+#endif
+
+    for (int op = 0; op < OP_COUNT; op++) {
+        c.op = op;
+
+        /* Reference pixels, and the time LVGL itself takes */
+        reset(&c);
+#ifdef HOST_LVGL_BLEND
+        do_lvgl(&c);
+        memcpy(c.ref, c.dest, sizeof(c.ref));
+        reset(&c);
+        snprintf(name, sizeof(name), "blend/%s/lvgl", op_names[op]);
+        bench_case(name, run_lvgl, &c, (double)BAND_PX * 4);
+#else
+        blend_sw_select(BLEND_SW_C);
+        do_op(&c);
+        memcpy(c.ref, c.dest, sizeof(c.ref));
+#endif
+
+        for (int impl = 0; impl < BLEND_SW_IMPL_COUNT; impl++) {
+            if (!avail[impl] || blend_sw_select(impl) != 0) {
+                bench_note("%s/%s: not supported here", op_names[op],
+                           blend_sw_name(impl));
+                continue;
+            }
+
+            reset(&c);
+            do_op(&c);
+            int bad = 0;
+            for (int i = 0; i < BAND_PX; i++)
+                bad += c.dest[i] != c.ref[i];
+            if (bad)
+                bench_note("%s/%s: %d pixels differ from " REF_NAME, op_names[op],
+                           blend_sw_name(impl), bad);
+
+            reset(&c);
+            snprintf(name, sizeof(name), "blend/%s/%s", op_names[op], blend_sw_name(impl));
+            bench_case(name, run_blend, &c, (double)BAND_PX * 4);
+        }
+    }
+
+    blend_sw_select(BLEND_SW_C);
+}
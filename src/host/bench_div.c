@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include "bench.h"
+#include "port_host.h"
+
+/* The original bit-serial __divdi3 from stdlib.c, kept as the baseline */
+static int64_t legacy_divdi3(int64_t a, int64_t b) {
+    int neg = 0;
+    if (a < 0) {
+        a = -a;
+        neg = !neg;
+    }
+    if (b < 0) {
+        b = -b;
+        neg = !neg;
+    }
+
+    int64_t quot = 0;
+    int64_t rem = 0;
+
+    for (int i = 63; i >= 0; i--) {
+        rem = (rem << 1) | ((a >> i) & 1);
+        if (rem >= b) {
+            rem -= b;
+            quot |= ((int64_t)1 << i);
+        }
+    }
+
+    return neg ? -quot : quot;
+}
+
+/* Operand shapes LVGL produces: tick deltas and scaled coordinates (both
+ * halves small), 64-bit timestamps over 32-bit divisors, and full-width
+ * divisors (e.g. ratios of two accumulated 64-bit values) */
+#define NOPS 256
+
+typedef struct {
+    int64_t n[NOPS];
+    int64_t d[NOPS];
+} div_ctx_t;
+
+typedef int64_t (*div_fn)(int64_t, int64_t);
+
+static int64_t native_divdi3(int64_t n, int64_t d) {
+    return n / d;
+}
+
+typedef struct {
+    div_ctx_t *ops;
+    div_fn fn;
+} div_run_t;
+
+static void run_div(void *ctx, uint64_t iters) {
+    div_run_t *r = ctx;
+    int64_t acc = 0;
+    for (uint64_t i = 0; i < iters; i++) {
+        unsigned k = i % NOPS;
+        acc += r->fn(r->ops->n[k], r->ops->d[k]);
+    }
+    bench_sink += (uintptr_t)acc;
+}
+
+static void fill(div_ctx_t *c, int shape) {
+    uint64_t s = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < NOPS; i++) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        switch (shape) {
+            case 0: /* 32/32 */
+                c->n[i] = (int32_t)s;
+                c->d[i] = (int32_t)(s >> 40) | 1;
+                break;
+            case 1: /* 64/32 */
+                c->n[i] = (int64_t)(s >> 1);
+                c->d[i] = (int64_t)((s >> 33) | 1);
+                break;
+            default: /* 64/64 */
+                c->n[i] = (int64_t)s;
+                c->d[i] = (int64_t)(s >> (8 + (s & 15))) | 1;
+                break;
+        }
+    }
+}
+
+void bench_div64(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const char *shapes[] = { "32_32", "64_32", "64_64" };
+    static const struct { const char *name; div_fn fn; } impls[] = {
+        { "legacy", legacy_divdi3 },
+        { "port", port_divdi3 },
+        { "native", native_divdi3 },
+    };
+
+    static div_ctx_t ops;
+    char name[64];
+    for (int s = 0; s < 3; s++) {
+        fill(&ops, s);
+        for (unsigned i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+            div_run_t r = { &ops, impls[i].fn };
+            snprintf(name, sizeof(name), "divdi3/%s/%s", impls[i].name, shapes[s]);
+            bench_case(name, run_div, &r, 0);
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "port_host.h"
+#include "fb.h"
+
+typedef struct {
+    int32_t x, y, w, h;
+    uint32_t *px;
+} flush_ctx_t;
+
+static void run_flush(void *ctx, uint64_t iters) {
+    flush_ctx_t *f = ctx;
+    vbe_info_t *vbe = vbe_get_info();
+    for (uint64_t i = 0; i < iters; i++) {
+        fb_blit(vbe, f->x, f->y, f->w, f->h, f->px);
+        bench_sink += vbe->framebuffer[0];
+    }
+}
+
+/* One scroll step of the full-screen list by a partial buffer's height */
+static void run_scroll_move(void *ctx, uint64_t iters) {
+    flush_ctx_t *f = ctx;
+    vbe_info_t *vbe = vbe_get_info();
+    for (uint64_t i = 0; i < iters; i++) {
+        fb_move(vbe, f->x, f->y, f->w, f->h, 0, (i & 1) ? f->h - (int32_t)vbe->height
+                                                         : (int32_t)vbe->height - f->h);
+        bench_sink += vbe->framebuffer[0];
+    }
+}
+
+/* Full screen pushed through the 1/20 partial buffer, as lvgl_port.c does */
+static void run_full_screen(void *ctx, uint64_t iters) {
+    flush_ctx_t *f = ctx;
+    vbe_info_t *vbe = vbe_get_info();
+    for (uint64_t i = 0; i < iters; i++) {
+        for (int32_t y = 0; y < (int32_t)vbe->height; y += f->h)
+            fb_blit(vbe, 0, y, f->w, f->h, f->px);
+        bench_sink += vbe->framebuffer[0];
+    }
+}
+
+void bench_flush(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    vbe_init(NULL);
+    vbe_info_t *vbe = vbe_get_info();
+
+    flush_ctx_t f;
+    f.px = malloc((size_t)vbe->width * vbe->height / 20 * 4);
+    for (uint32_t i = 0; i < vbe->width * vbe->height / 20; i++)
+        f.px[i] = 0xFF000000u | i;
+
+    /* One partial buffer band (640x24 at 640x480) */
+    f.x = 0;
+    f.y = 100;
+    f.w = (int32_t)vbe->width;
+    f.h = (int32_t)(vbe->height / 20);
+    bench_case("fb_blit/band", run_flush, &f, (double)f.w * f.h * 4);
+
+    /* A list button: small, not row aligned */
+    f.x = 13;
+    f.y = 57;
+    f.w = 600;
+    f.h = 40;
+    bench_case("fb_blit/button", run_flush, &f, (double)f.w * f.h * 4);
+
+    /* Area hanging off the bottom-right corner */
+    f.x = (int32_t)vbe->width - 100;
+    f.y = (int32_t)vbe->height - 10;
+    f.w = 200;
+    f.h = 20;
+    bench_case("fb_blit/clipped", run_flush, &f, 100.0 * 10 * 4);
+
+    f.w = (int32_t)vbe->width;
+    f.h = (int32_t)(vbe->height / 20);
+    bench_case("fb_blit/full_screen", run_full_screen, &f,
+               (double)vbe->width * vbe->height * 4);
+
+    /* Compare with full_screen: the scroll fast path moves this much and
+     * renders only one band */
+    f.x = 0;
+    f.y = (int32_t)(vbe->height / 20);
+    f.w = (int32_t)vbe->width;
+    f.h = (int32_t)(vbe->height - vbe->height / 20);
+    bench_case("fb_move/scroll", run_scroll_move, &f, (double)f.w * f.h * 4);
+
+    free(f.px);
+}
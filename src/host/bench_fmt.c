@@ -0,0 +1,152 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "bench.h"
+#include "port_host.h"
+
+/*
+ * The original stdlib.c formatter (%d %s %c %% only, per-digit % 10 loop
+ * plus a temp copy), kept as the baseline for the vsnprintf rewrite.
+ */
+static void legacy_int_to_str(int value, char *buf, int *pos) {
+    if (value < 0) {
+        buf[(*pos)++] = '-';
+        value = -value;
+    }
+    if (value == 0) {
+        buf[(*pos)++] = '0';
+        return;
+    }
+
+    char temp[12];
+    int temp_pos = 0;
+    while (value > 0) {
+        temp[temp_pos++] = '0' + (value % 10);
+        value /= 10;
+    }
+    while (temp_pos > 0)
+        buf[(*pos)++] = temp[--temp_pos];
+}
+
+static int legacy_vsnprintf(char *buf, size_t size, const char *format, va_list args) {
+    size_t pos = 0;
+
+    while (*format && pos < size - 1) {
+        if (*format == '%') {
+            format++;
+            if (*format == 'd') {
+                int value = va_arg(args, int);
+                int temp_pos = 0;
+                char temp[32];
+                legacy_int_to_str(value, temp, &temp_pos);
+                for (int i = 0; i < temp_pos && pos < size - 1; i++)
+                    buf[pos++] = temp[i];
+            } else if (*format == 's') {
+                char *str = va_arg(args, char *);
+                while (*str && pos < size - 1)
+                    buf[pos++] = *str++;
+            } else if (*format == 'c') {
+                buf[pos++] = (char)va_arg(args, int);
+            } else if (*format == '%') {
+                buf[pos++] = '%';
+            }
+            format++;
+        } else {
+            buf[pos++] = *format++;
+        }
+    }
+
+    buf[pos] = '\0';
+    return pos;
+}
+
+static int legacy_snprintf(char *buf, size_t size, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int result = legacy_vsnprintf(buf, size, format, args);
+    va_end(args);
+    return result;
+}
+
+typedef int (*fmt_fn)(char *buf, size_t size, const char *format, ...);
+
+typedef struct {
+    fmt_fn fmt;
+    const char *format;
+} fmt_ctx_t;
+
+/* Mix of small and large magnitudes, like counters next to tick values */
+static inline int sample_int(uint64_t i) {
+    return (i & 1) ? (int)(i * 2654435761u) : (int)(i & 0xFFF);
+}
+
+static void run_int(void *ctx, uint64_t iters) {
+    fmt_ctx_t *f = ctx;
+    char buf[64];
+    for (uint64_t i = 0; i < iters; i++) {
+        f->fmt(buf, sizeof(buf), f->format, sample_int(i));
+        bench_sink += (uint8_t)buf[0];
+    }
+}
+
+static void run_str(void *ctx, uint64_t iters) {
+    fmt_ctx_t *f = ctx;
+    char buf[64];
+    for (uint64_t i = 0; i < iters; i++) {
+        f->fmt(buf, sizeof(buf), f->format, "List item", sample_int(i));
+        bench_sink += (uint8_t)buf[0];
+    }
+}
+
+static void run_i64(void *ctx, uint64_t iters) {
+    fmt_ctx_t *f = ctx;
+    char buf[64];
+    for (uint64_t i = 0; i < iters; i++) {
+        f->fmt(buf, sizeof(buf), f->format, (long long)(i * 0x9E3779B97F4A7C15ull));
+        bench_sink += (uint8_t)buf[0];
+    }
+}
+
+/* A dashboard line: several numeric fields with width and precision */
+static void run_dash(void *ctx, uint64_t iters) {
+    fmt_ctx_t *f = ctx;
+    char buf[96];
+    for (uint64_t i = 0; i < iters; i++) {
+        f->fmt(buf, sizeof(buf), f->format, (unsigned)i, (int)(i & 0x3FF) - 512,
+               (unsigned)(i * 7919), (int)(i % 100));
+        bench_sink += (uint8_t)buf[0];
+    }
+}
+
+void bench_fmt(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static const struct { const char *name; fmt_fn fn; int full; } impls[] = {
+        { "legacy", legacy_snprintf, 0 },
+        { "port", port_snprintf, 1 },
+        { "libc", snprintf, 1 },
+    };
+
+    char name[64];
+    for (size_t i = 0; i < sizeof(impls) / sizeof(impls[0]); i++) {
+        fmt_ctx_t f = { impls[i].fn, "List item %d" };
+        snprintf(name, sizeof(name), "snprintf/%s/label", impls[i].name);
+        bench_case(name, run_int, &f, 0);
+
+        f.format = "%s %d";
+        snprintf(name, sizeof(name), "snprintf/%s/str_int", impls[i].name);
+        bench_case(name, run_str, &f, 0);
+
+        /* Conversions the legacy formatter silently drops */
+        if (!impls[i].full)
+            continue;
+
+        f.format = "%lld";
+        snprintf(name, sizeof(name), "snprintf/%s/int64", impls[i].name);
+        bench_case(name, run_i64, &f, 0);
+
+        f.format = "t=%08u dx=%+5d id=%#x %3d%%";
+        snprintf(name, sizeof(name), "snprintf/%s/dashboard", impls[i].name);
+        bench_case(name, run_dash, &f, 0);
+    }
+}
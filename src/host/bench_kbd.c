@@ -0,0 +1,25 @@
+#include "bench.h"
+#include "port_host.h"
+#include "keyboard.h"
+
+/* Press+release of 'a' followed by an extended down-arrow press */
+static const uint8_t burst[] = { 0x1E, 0x9E, 0xE0, 0x50, 0xE0, 0xD0 };
+
+static void run_burst(void *ctx, uint64_t iters) {
+    (void)ctx;
+    for (uint64_t i = 0; i < iters; i++) {
+        for (unsigned k = 0; k < sizeof(burst); k++)
+            host_io_push_scancode(burst[k]);
+        keyboard_handler();
+        while (keyboard_has_key())
+            bench_sink += (uint8_t)keyboard_get_key().ascii;
+    }
+}
+
+void bench_kbd(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    keyboard_init();
+    bench_case("keyboard/poll_and_drain", run_burst, NULL, 0);
+}
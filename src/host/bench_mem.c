@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "port_host.h"
+
+/* Candidate replacements for the byte-loop memcpy/memset in stdlib.c */
+
+static void *memcpy_word(void *dest, const void *src, size_t n) {
+    uint32_t *d = dest;
+    const uint32_t *s = src;
+    for (size_t i = 0; i < n / 4; i++)
+        d[i] = s[i];
+    uint8_t *db = (uint8_t *)(d + n / 4);
+    const uint8_t *sb = (const uint8_t *)(s + n / 4);
+    for (size_t i = 0; i < (n & 3); i++)
+        db[i] = sb[i];
+    return dest;
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+static void *memcpy_rep_movsb(void *dest, const void *src, size_t n) {
+    void *d = dest;
+    asm volatile("rep movsb" : "+D"(d), "+S"(src), "+c"(n) : : "memory");
+    return dest;
+}
+
+static void *memcpy_rep_movsl(void *dest, const void *src, size_t n) {
+    void *d = dest;
+    size_t words = n / 4;
+    size_t tail = n & 3;
+    asm volatile("rep movsl\n\t"
+                 "mov %3, %2\n\t"
+                 "rep movsb"
+                 : "+D"(d), "+S"(src), "+c"(words)
+                 : "r"(tail)
+                 : "memory");
+    return dest;
+}
+
+static void *memset_rep_stosb(void *s, int c, size_t n) {
+    void *d = s;
+    asm volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(c) : "memory");
+    return s;
+}
+#endif
+
+static void *memset_word(void *s, int c, size_t n) {
+    uint32_t v = (uint8_t)c * 0x01010101u;
+    uint32_t *d = s;
+    for (size_t i = 0; i < n / 4; i++)
+        d[i] = v;
+    uint8_t *db = (uint8_t *)(d + n / 4);
+    for (size_t i = 0; i < (n & 3); i++)
+        db[i] = (uint8_t)c;
+    return s;
+}
+
+typedef void *(*copy_fn)(void *, const void *, size_t);
+typedef void *(*set_fn)(void *, int, size_t);
+
+typedef struct {
+    copy_fn copy;
+    set_fn set;
+    uint8_t *dst;
+    uint8_t *src;
+    size_t len;
+} mem_ctx_t;
+
+static void run_copy(void *ctx, uint64_t iters) {
+    mem_ctx_t *m = ctx;
+    for (uint64_t i = 0; i < iters; i++) {
+        m->copy(m->dst, m->src, m->len);
+        bench_sink += m->dst[0];
+    }
+}
+
+static void run_set(void *ctx, uint64_t iters) {
+    mem_ctx_t *m = ctx;
+    for (uint64_t i = 0; i < iters; i++) {
+        m->set(m->dst, (int)i, m->len);
+        bench_sink += m->dst[0];
+    }
+}
+
+void bench_mem(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    /* Small LVGL structs, a label string, one 640 px row, one 1/20 draw buffer */
+    static const size_t sizes[] = { 16, 64, 256, 2560, 61440 };
+    static const struct { const char *name; copy_fn fn; } copies[] = {
+        { "port_memcpy", port_memcpy },
+        { "word", memcpy_word },
+#if defined(__i386__) || defined(__x86_64__)
+        { "rep_movsb", memcpy_rep_movsb },
+        { "rep_movsl", memcpy_rep_movsl },
+#endif
+        { "libc", memcpy },
+    };
+    static const struct { const char *name; set_fn fn; } sets[] = {
+        { "port_memset", port_memset },
+        { "word", memset_word },
+#if defined(__i386__) || defined(__x86_64__)
+        { "rep_stosb", memset_rep_stosb },
+#endif
+        { "libc", memset },
+    };
+
+    mem_ctx_t m;
+    m.src = aligned_alloc(64, 65536);
+    m.dst = aligned_alloc(64, 65536);
+    memset(m.src, 0x5A, 65536);
+
+    char name[64];
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        m.len = sizes[s];
+        for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); i++) {
+            m.copy = copies[i].fn;
+            snprintf(name, sizeof(name), "memcpy/%s/%zu", copies[i].name, m.len);
+            bench_case(name, run_copy, &m, (double)m.len);
+        }
+        for (size_t i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+            m.set = sets[i].fn;
+            snprintf(name, sizeof(name), "memset/%s/%zu", sets[i].name, m.len);
+            bench_case(name, run_set, &m, (double)m.len);
+        }
+    }
+
+    free(m.src);
+    free(m.dst);
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "port_host.h"
+
+/* PS/2 controller stand-in: scancodes pushed by the host appear on port
+ * 0x60 with the output-buffer-full bit set in the status port 0x64. */
+#define SCANCODE_FIFO_SIZE 256
+
+static uint8_t scancode_fifo[SCANCODE_FIFO_SIZE];
+static unsigned fifo_head = 0;
+static unsigned fifo_tail = 0;
+
+jmp_buf *host_panic_jmp = NULL;
+
+void host_io_push_scancode(uint8_t scancode) {
+    unsigned next = (fifo_head + 1) % SCANCODE_FIFO_SIZE;
+    if (next != fifo_tail) {
+        scancode_fifo[fifo_head] = scancode;
+        fifo_head = next;
+    }
+}
+
+uint8_t host_inb(uint16_t port) {
+    switch (port) {
+        case 0x64:
+            return fifo_head != fifo_tail ? 0x01 : 0x00;
+        case 0x60:
+            if (fifo_head != fifo_tail) {
+                uint8_t sc = scancode_fifo[fifo_tail];
+                fifo_tail = (fifo_tail + 1) % SCANCODE_FIFO_SIZE;
+                return sc;
+            }
+            return 0;
+        default:
+            return 0xFF;
+    }
+}
+
+void host_outb(uint16_t port, uint8_t val) {
+    (void)port;
+    (void)val;
+}
+
+/* No PCI on the host: configuration reads float high */
+uint32_t host_inl(uint16_t port) {
+    (void)port;
+    return 0xFFFFFFFF;
+}
+
+void host_outl(uint16_t port, uint32_t val) {
+    (void)port;
+    (void)val;
+}
+
+void host_panic(void) {
+    if (host_panic_jmp)
+        longjmp(*host_panic_jmp, 1);
+
+    fprintf(stderr, "kernel_panic() on host\n");
+    abort();
+}
@@ -0,0 +1,78 @@
+#include <string.h>
+#include "lvgl_blend_ref.h"
+#include "lvgl/lvgl.h"
+#include "lvgl/src/draw/sw/blend/lv_draw_sw_blend_private.h"
+#include "lvgl/src/draw/sw/blend/lv_draw_sw_blend_to_argb8888.h"
+
+/* Plain field stores, so only the blend loops themselves are linked in */
+static void whole_area(lv_area_t *a, int32_t w, int32_t h) {
+    a->x1 = 0;
+    a->y1 = 0;
+    a->x2 = w - 1;
+    a->y2 = h - 1;
+}
+
+static void fill_dsc(lv_draw_sw_blend_fill_dsc_t *dsc, void *dest, int32_t w, int32_t h,
+                     int32_t stride, uint32_t color, uint8_t opa, const uint8_t *mask,
+                     int32_t mask_stride) {
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->dest_buf = dest;
+    dsc->dest_w = w;
+    dsc->dest_h = h;
+    dsc->dest_stride = stride;
+    dsc->mask_buf = mask;
+    dsc->mask_stride = mask_stride;
+    dsc->color.red = (uint8_t)(color >> 16);
+    dsc->color.green = (uint8_t)(color >> 8);
+    dsc->color.blue = (uint8_t)color;
+    dsc->opa = opa;
+    whole_area(&dsc->relative_area, w, h);
+}
+
+static void image_dsc(lv_draw_sw_blend_image_dsc_t *dsc, void *dest, int32_t w, int32_t h,
+                      int32_t stride, const void *src, int32_t src_stride,
+                      lv_color_format_t cf, uint8_t opa, const uint8_t *mask,
+                      int32_t mask_stride) {
+    memset(dsc, 0, sizeof(*dsc));
+    dsc->dest_buf = dest;
+    dsc->dest_w = w;
+    dsc->dest_h = h;
+    dsc->dest_stride = stride;
+    dsc->mask_buf = mask;
+    dsc->mask_stride = mask_stride;
+    dsc->src_buf = src;
+    dsc->src_stride = src_stride;
+    dsc->src_color_format = cf;
+    dsc->opa = opa;
+    dsc->blend_mode = LV_BLEND_MODE_NORMAL;
+    whole_area(&dsc->relative_area, w, h);
+    dsc->src_area = dsc->relative_area;
+}
+
+void lvgl_ref_fill(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color) {
+    lvgl_ref_color(dest, w, h, stride, color, LV_OPA_COVER, NULL, 0);
+}
+
+void lvgl_ref_color(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color,
+                    uint8_t opa, const uint8_t *mask, int32_t mask_stride) {
+    lv_draw_sw_blend_fill_dsc_t dsc;
+    fill_dsc(&dsc, dest, w, h, stride, color, opa, mask, mask_stride);
+    lv_draw_sw_blend_color_to_argb8888(&dsc);
+}
+
+void lvgl_ref_argb(void *dest, int32_t w, int32_t h, int32_t stride,
+                   const void *src, int32_t src_stride, uint8_t opa,
+                   const uint8_t *mask, int32_t mask_stride) {
+    lv_draw_sw_blend_image_dsc_t dsc;
+    image_dsc(&dsc, dest, w, h, stride, src, src_stride, LV_COLOR_FORMAT_ARGB8888, opa,
+              mask, mask_stride);
+    lv_draw_sw_blend_image_to_argb8888(&dsc);
+}
+
+void lvgl_ref_xrgb(void *dest, int32_t w, int32_t h, int32_t stride,
+                   const void *src, int32_t src_stride) {
+    lv_draw_sw_blend_image_dsc_t dsc;
+    image_dsc(&dsc, dest, w, h, stride, src, src_stride, LV_COLOR_FORMAT_XRGB8888,
+              LV_OPA_COVER, NULL, 0);
+    lv_draw_sw_blend_image_to_argb8888(&dsc);
+}
@@ -0,0 +1,21 @@
+/*
+ * LVGL's own ARGB8888 blend loops (lv_draw_sw_blend_to_argb8888.c, built
+ * with PORT_BLEND_SW 0 so the blend_sw.h hooks are not compiled in),
+ * behind the argument lists of blend_sw.h. bench_blend uses them as the
+ * reference when the LVGL checkout is there (HOST_LVGL_BLEND).
+ */
+#ifndef LVGL_BLEND_REF_H
+#define LVGL_BLEND_REF_H
+
+#include <stdint.h>
+
+void lvgl_ref_fill(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color);
+void lvgl_ref_color(void *dest, int32_t w, int32_t h, int32_t stride, uint32_t color,
+                    uint8_t opa, const uint8_t *mask, int32_t mask_stride);
+void lvgl_ref_argb(void *dest, int32_t w, int32_t h, int32_t stride,
+                   const void *src, int32_t src_stride, uint8_t opa,
+                   const uint8_t *mask, int32_t mask_stride);
+void lvgl_ref_xrgb(void *dest, int32_t w, int32_t h, int32_t stride,
+                   const void *src, int32_t src_stride);
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * Host-side view of the port layer: prototypes for the renamed libc
+ * replacements from stdlib.c and the stand-in hooks in host/.
+ */
+#ifndef PORT_HOST_H
+#define PORT_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <setjmp.h>
+
+void *port_malloc(size_t size);
+void port_free(void *ptr);
+void *port_realloc(void *ptr, size_t size);
+void *port_calloc(size_t nmemb, size_t size);
+void *port_memset(void *s, int c, size_t n);
+void *port_memcpy(void *dest, const void *src, size_t n);
+void *port_memmove(void *dest, const void *src, size_t n);
+int port_memcmp(const void *s1, const void *s2, size_t n);
+size_t port_strlen(const char *s);
+int port_vsnprintf(char *buf, size_t size, const char *format, va_list args);
+int port_snprintf(char *buf, size_t size, const char *format, ...);
+
+uint64_t port_udivmoddi4(uint64_t n, uint64_t d, uint64_t *rem);
+uint64_t port_udivdi3(uint64_t n, uint64_t d);
+uint64_t port_umoddi3(uint64_t n, uint64_t d);
+int64_t port_divmoddi4(int64_t n, int64_t d, int64_t *rem);
+int64_t port_divdi3(int64_t n, int64_t d);
+int64_t port_moddi3(int64_t n, int64_t d);
+
+void lv_mem_init(void);
+
+/* Software framebuffer stand-in for vbe.c */
+void vbe_host_set_mode(uint32_t width, uint32_t height);
+
+/* Port I/O stand-in: feeds scancodes to keyboard_handler() */
+void host_io_push_scancode(uint8_t scancode);
+
+/* A kernel_panic() inside the port longjmps here when armed, else aborts */
+extern jmp_buf *host_panic_jmp;
+
+#endif
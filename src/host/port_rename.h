@@ -0,0 +1,37 @@
+/*
+ * Force-included (-include) into the port sources for the host build.
+ * Renames the freestanding libc replacements so they can be linked into a
+ * native program next to glibc without interposing on it.
+ */
+#ifndef PORT_RENAME_H
+#define PORT_RENAME_H
+
+#define malloc    port_malloc
+#define free      port_free
+#define realloc   port_realloc
+#define calloc    port_calloc
+#define memset    port_memset
+#define memcpy    port_memcpy
+#define memmove   port_memmove
+#define memcmp    port_memcmp
+#define strlen    port_strlen
+#define strcpy    port_strcpy
+#define strncpy   port_strncpy
+#define strcmp    port_strcmp
+#define strncmp   port_strncmp
+#define strcat    port_strcat
+#define strncat   port_strncat
+#define vsnprintf port_vsnprintf
+#define snprintf  port_snprintf
+
+#define __udivmoddi4 port_udivmoddi4
+#define __udivdi3    port_udivdi3
+#define __umoddi3    port_umoddi3
+#define __divmoddi4  port_divmoddi4
+#define __divdi3     port_divdi3
+#define __moddi3     port_moddi3
+
+/* Called instead of halting the CPU; see host/host_io.c */
+void host_panic(void);
+
+#endif
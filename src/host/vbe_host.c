@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include "vbe.h"
+#include "port_host.h"
+
+/* Software framebuffer stand-in for vbe.c. vbe_init() ignores the multiboot
+ * pointer and sets up the same 640x480x32 mode boot.S requests from GRUB. */
+static vbe_info_t vbe_info;
+
+void vbe_host_set_mode(uint32_t width, uint32_t height) {
+    free(vbe_info.framebuffer);
+
+    vbe_info.framebuffer = calloc((size_t)width * height, 4);
+    vbe_info.width = width;
+    vbe_info.height = height;
+    vbe_info.pitch = width * 4;
+    vbe_info.bpp = 32;
+}
+
+void vbe_init(void* mboot_info) {
+    (void)mboot_info;
+
+    if (!vbe_info.framebuffer)
+        vbe_host_set_mode(640, 480);
+}
+
+vbe_info_t* vbe_get_info(void) {
+    return &vbe_info;
+}
+
+void vbe_put_pixel(int x, int y, uint32_t color) {
+    if (x < 0 || x >= (int)vbe_info.width || y < 0 || y >= (int)vbe_info.height)
+        return;
+
+    vbe_info.framebuffer[y * (vbe_info.pitch / 4) + x] = color;
+}
+
+void vbe_clear(uint32_t color) {
+    for (uint32_t y = 0; y < vbe_info.height; y++) {
+        for (uint32_t x = 0; x < vbe_info.width; x++) {
+            vbe_put_pixel(x, y, color);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include "idt.h"
+#include "io.h"
+#include "serial.h"
+
+#define PIC1_CMD  0x20
+#define PIC1_DATA 0x21
+#define PIC2_CMD  0xA0
+#define PIC2_DATA 0xA1
+#define PIC_EOI   0x20
+
+#define IRQ_BASE  32
+
+#define KERNEL_CS 0x08
+#define KERNEL_DS 0x10
+
+typedef struct {
+    uint16_t offset_lo;
+    uint16_t selector;
+    uint8_t zero;
+    uint8_t type_attr;
+    uint16_t offset_hi;
+} __attribute__((packed)) idt_entry_t;
+
+typedef struct {
+    uint16_t limit;
+    uint32_t base;
+} __attribute__((packed)) table_ptr_t;
+
+extern const uint32_t isr_stub_table[48];
+
+/* Flat 4 GiB code and data segments. GRUB's GDT may live in memory we
+ * reuse, and iret reloads CS from whatever GDTR points at. */
+static const uint64_t gdt[3] __attribute__((aligned(8))) = {
+    0,
+    0x00CF9A000000FFFFull,      /* 0x08: ring 0 code */
+    0x00CF92000000FFFFull,      /* 0x10: ring 0 data */
+};
+
+static idt_entry_t idt[48] __attribute__((aligned(8)));
+static irq_handler_t irq_handlers[16];
+
+static const char *const exception_names[32] = {
+    "divide error", "debug", "NMI", "breakpoint", "overflow", "bound range",
+    "invalid opcode", "device not available", "double fault", "coprocessor overrun",
+    "invalid TSS", "segment not present", "stack fault", "general protection",
+    "page fault", "reserved", "x87 FPU error", "alignment check", "machine check",
+    "SIMD FP exception",
+};
+
+static void load_gdt(void) {
+    table_ptr_t ptr = { sizeof(gdt) - 1, (uint32_t)(uintptr_t)gdt };
+
+    asm volatile ("lgdt %0\n\t"
+                  "ljmp %1, $1f\n"
+                  "1:\n\t"
+                  "movw %w2, %%ax\n\t"
+                  "movw %%ax, %%ds\n\t"
+                  "movw %%ax, %%es\n\t"
+                  "movw %%ax, %%fs\n\t"
+                  "movw %%ax, %%gs\n\t"
+                  "movw %%ax, %%ss"
+                  : : "m"(ptr), "i"(KERNEL_CS), "i"(KERNEL_DS) : "eax", "memory");
+}
+
+static void pic_remap(void) {
+    /* ICW1: init + ICW4 needed; ICW2: vector base; ICW3: cascade on IRQ2;
+     * ICW4: 8086 mode */
+    outb(PIC1_CMD, 0x11);
+    outb(PIC2_CMD, 0x11);
+    outb(PIC1_DATA, IRQ_BASE);
+    outb(PIC2_DATA, IRQ_BASE + 8);
+    outb(PIC1_DATA, 0x04);
+    outb(PIC2_DATA, 0x02);
+    outb(PIC1_DATA, 0x01);
+    outb(PIC2_DATA, 0x01);
+
+    /* Everything masked except the cascade line */
+    outb(PIC1_DATA, 0xFB);
+    outb(PIC2_DATA, 0xFF);
+}
+
+void idt_init(void) {
+    load_gdt();
+
+    for (int i = 0; i < 48; i++) {
+        uint32_t addr = isr_stub_table[i];
+        idt[i].offset_lo = addr & 0xFFFF;
+        idt[i].selector = KERNEL_CS;
+        idt[i].zero = 0;
+        idt[i].type_attr = 0x8E;    /* present, ring 0, 32-bit interrupt gate */
+        idt[i].offset_hi = addr >> 16;
+    }
+
+    table_ptr_t ptr = { sizeof(idt) - 1, (uint32_t)(uintptr_t)idt };
+    asm volatile ("lidt %0" : : "m"(ptr));
+
+    pic_remap();
+}
+
+void irq_install(uint8_t irq, irq_handler_t handler) {
+    irq_handlers[irq] = handler;
+
+    uint16_t port = (irq < 8) ? PIC1_DATA : PIC2_DATA;
+    outb(port, inb(port) & ~(1 << (irq & 7)));
+}
+
+void isr_dispatch(irq_frame_t *frame) {
+    if (frame->vector < IRQ_BASE) {
+        const char *name = exception_names[frame->vector];
+        serial_printf("\nexception %u (%s) err=%#x eip=%#x\n",
+                      (unsigned)frame->vector, name ? name : "reserved",
+                      (unsigned)frame->error, (unsigned)frame->eip);
+        asm volatile ("cli; hlt");
+        return;
+    }
+
+    uint32_t irq = frame->vector - IRQ_BASE;
+    if (irq_handlers[irq])
+        irq_handlers[irq](frame);
+
+    if (irq >= 8)
+        outb(PIC2_CMD, PIC_EOI);
+    outb(PIC1_CMD, PIC_EOI);
+}
@@ -0,0 +1,31 @@
+#ifndef IDT_H
+#define IDT_H
+
+#include <stdint.h>
+
+/* Register state saved by isr_common in isr.S */
+typedef struct {
+    uint32_t edi, esi, ebp, esp, ebx, edx, ecx, eax;   /* pusha */
+    uint32_t vector;
+    uint32_t error;
+    uint32_t eip, cs, eflags;                          /* pushed by the CPU */
+} irq_frame_t;
+
+typedef void (*irq_handler_t)(irq_frame_t *frame);
+
+/* Loads our own GDT and the IDT, remaps the PICs to vectors 32-47 with
+ * every IRQ masked. Interrupts stay disabled until irq_enable(). */
+void idt_init(void);
+
+/* Installs a handler for PIC line irq (0-15) and unmasks it */
+void irq_install(uint8_t irq, irq_handler_t handler);
+
+static inline void irq_enable(void) {
+    asm volatile ("sti");
+}
+
+static inline void irq_disable(void) {
+    asm volatile ("cli");
+}
+
+#endif
@@ -0,0 +1,185 @@
+import struct
+import sys
+import zlib
+
+# Converts a PNG into a tiled, run-length compressed image (tiled_image.c).
+#
+# Usage: python3 image-pack.py image.png image.tim [tile]
+#
+# The image is cut into tile x tile squares (default 64) that are compressed
+# separately, so the kernel can decode only the tiles a redraw touches.
+# Pixels are stored in the display's format, B G R A in memory: opaque
+# images become XRGB8888, whose blend is a plain copy, and images with
+# alpha become ARGB8888 with straight alpha, which is what LVGL's software
+# blender expects. A tile's pixels are stored raw when RLE would not make
+# them smaller. Reads 8-bit, non-interlaced PNGs of any color type.
+
+MAGIC = 0x4954564C
+VERSION = 1
+CF_ARGB8888 = 0x10
+CF_XRGB8888 = 0x11
+HEADER = struct.Struct("<IHHHHBBH")
+MAX_RUN = 128
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, width, height, bpp):
+    stride = width * bpp
+    out = bytearray(stride * height)
+    prev = bytearray(stride)
+    pos = 0
+    for y in range(height):
+        kind = raw[pos]
+        line = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+        if kind == 1:
+            for i in range(bpp, stride):
+                line[i] = (line[i] + line[i - bpp]) & 0xFF
+        elif kind == 2:
+            for i in range(stride):
+                line[i] = (line[i] + prev[i]) & 0xFF
+        elif kind == 3:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + ((left + prev[i]) >> 1)) & 0xFF
+        elif kind == 4:
+            for i in range(stride):
+                left = line[i - bpp] if i >= bpp else 0
+                up_left = prev[i - bpp] if i >= bpp else 0
+                line[i] = (line[i] + paeth(left, prev[i], up_left)) & 0xFF
+        elif kind != 0:
+            sys.exit(f"bad PNG filter {kind}")
+        out[y * stride:(y + 1) * stride] = line
+        prev = line
+    return out
+
+
+def read_png(path):
+    """Returns (width, height, pixels) with pixels as RGBA tuples."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        sys.exit(f"{path}: not a PNG")
+
+    pos = 8
+    idat = []
+    palette = []
+    trns = b""
+    while pos < len(data):
+        length, kind = struct.unpack_from(">I4s", data, pos)
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            width, height, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            trns = body
+        elif kind == b"IDAT":
+            idat.append(body)
+        elif kind == b"IEND":
+            break
+    if depth != 8 or interlace:
+        sys.exit(f"{path}: only 8-bit, non-interlaced PNGs are supported")
+
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    px = unfilter(zlib.decompress(b"".join(idat)), width, height, channels)
+    if color == 0:
+        key = struct.unpack(">H", trns)[0] if trns else -1
+        pixels = [(v, v, v, 0 if v == key else 255) for v in px]
+    elif color == 2:
+        key = struct.unpack(">HHH", trns) if trns else None
+        pixels = []
+        for i in range(0, len(px), 3):
+            rgb = tuple(px[i:i + 3])
+            pixels.append(rgb + (0 if rgb == key else 255,))
+    elif color == 3:
+        alpha = list(trns) + [255] * (len(palette) - len(trns))
+        pixels = [palette[i] + (alpha[i],) for i in px]
+    elif color == 4:
+        pixels = [(px[i], px[i], px[i], px[i + 1]) for i in range(0, len(px), 2)]
+    else:
+        pixels = [tuple(px[i:i + 4]) for i in range(0, len(px), 4)]
+    return width, height, pixels
+
+
+def rle(tile):
+    """Runs of 2+ equal pixels become run packets, the rest literal packets."""
+    out = bytearray()
+    literal = []
+
+    def flush():
+        for i in range(0, len(literal), MAX_RUN):
+            chunk = literal[i:i + MAX_RUN]
+            out.append(len(chunk) - 1)
+            out.extend(struct.pack(f"<{len(chunk)}I", *chunk))
+        literal.clear()
+
+    i = 0
+    while i < len(tile):
+        n = 1
+        while i + n < len(tile) and n < MAX_RUN and tile[i + n] == tile[i]:
+            n += 1
+        if n > 1:
+            flush()
+            out.append(0x80 | (n - 1))
+            out.extend(struct.pack("<I", tile[i]))
+        else:
+            literal.append(tile[i])
+        i += n
+    flush()
+    return bytes(out)
+
+
+def pack(width, height, pixels, size):
+    opaque = all(p[3] == 255 for p in pixels)
+    cf = CF_XRGB8888 if opaque else CF_ARGB8888
+    # Fully transparent pixels all become 0 so they compress into runs
+    words = [b | g << 8 | r << 16 | a << 24 if a else 0 for r, g, b, a in pixels]
+
+    cols = (width + size - 1) // size
+    rows = (height + size - 1) // size
+    tiles = []
+    for ty in range(rows):
+        for tx in range(cols):
+            x, y = tx * size, ty * size
+            w, h = min(size, width - x), min(size, height - y)
+            tile = []
+            for row in range(y, y + h):
+                tile += words[row * width + x:row * width + x + w]
+            packed = rle(tile)
+            if len(packed) >= len(tile) * 4:
+                packed = struct.pack(f"<{len(tile)}I", *tile)
+            tiles.append(packed)
+
+    offsets = [HEADER.size + (len(tiles) + 1) * 4]
+    for t in tiles:
+        offsets.append(offsets[-1] + len(t))
+    head = HEADER.pack(MAGIC, width, height, size, size, cf, VERSION, 0)
+    return cf, head + struct.pack(f"<{len(offsets)}I", *offsets) + b"".join(tiles)
+
+
+def main():
+    if len(sys.argv) not in (3, 4):
+        sys.exit("usage: image-pack.py image.png image.tim [tile]")
+    size = int(sys.argv[3]) if len(sys.argv) == 4 else 64
+    width, height, pixels = read_png(sys.argv[1])
+    if width > 0xFFFF or height > 0xFFFF or not 0 < size <= 0xFFFF:
+        sys.exit("image or tile too large")
+    cf, data = pack(width, height, pixels, size)
+    with open(sys.argv[2], "wb") as f:
+        f.write(data)
+    name = "XRGB8888" if cf == CF_XRGB8888 else "ARGB8888"
+    print(f"{sys.argv[1]}: {width}x{height} {name}, {size}x{size} tiles, "
+          f"{width * height * 4 // 1024} KiB -> {len(data) // 1024} KiB")
+
+
+if __name__ == "__main__":
+    main()
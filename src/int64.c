@@ -0,0 +1,142 @@
+#include <stdint.h>
+
+/*
+ * 64-bit division helpers GCC calls on i386 (the libgcc ABI).
+ *
+ * When the divisor fits in 32 bits the quotient takes one or two divl
+ * instructions. Otherwise the divisor is normalized so its top 32 bits
+ * give a quotient estimate off by at most one (Hacker's Delight, divDU),
+ * corrected with a single multiply-compare. Division by zero faults like
+ * the hardware divide.
+ */
+
+/* (hi:lo) / d, with hi < d so the quotient fits in 32 bits */
+static inline uint32_t divl(uint32_t hi, uint32_t lo, uint32_t d, uint32_t *rem)
+{
+#if defined(__i386__)
+    uint32_t q;
+    asm("divl %4" : "=a"(q), "=d"(*rem) : "0"(lo), "1"(hi), "rm"(d));
+    return q;
+#else
+    uint64_t n = ((uint64_t)hi << 32) | lo;
+    *rem = (uint32_t)(n % d);
+    return (uint32_t)(n / d);
+#endif
+}
+
+/* 32x32 -> 64 multiply, a single mull on i386 */
+static inline uint64_t mul32(uint32_t a, uint32_t b)
+{
+    return (uint64_t)a * b;
+}
+
+uint64_t __udivmoddi4(uint64_t n, uint64_t d, uint64_t *rem)
+{
+    uint32_t n_hi = (uint32_t)(n >> 32);
+    uint32_t n_lo = (uint32_t)n;
+    uint32_t d_hi = (uint32_t)(d >> 32);
+    uint32_t d_lo = (uint32_t)d;
+    uint32_t q_hi = 0;
+    uint32_t q_lo;
+    uint32_t r;
+
+    if (d_hi == 0)
+    {
+        if (n_hi == 0)
+        {
+            /* Both operands fit in 32 bits */
+            q_lo = n_lo / d_lo;
+            if (rem)
+            {
+                *rem = n_lo - q_lo * d_lo;
+            }
+            return q_lo;
+        }
+
+        if (n_hi >= d_lo)
+        {
+            q_hi = n_hi / d_lo;
+            n_hi -= q_hi * d_lo;
+        }
+        q_lo = divl(n_hi, n_lo, d_lo, &r);
+        if (rem)
+        {
+            *rem = r;
+        }
+        return ((uint64_t)q_hi << 32) | q_lo;
+    }
+
+    if (n < d)
+    {
+        if (rem)
+        {
+            *rem = n;
+        }
+        return 0;
+    }
+
+    /* Divisor has 33+ significant bits, so the quotient fits in 32 bits */
+    int s = __builtin_clz(d_hi);
+    uint32_t v1 = (uint32_t)((d << s) >> 32);
+    uint64_t n1 = n >> 1;
+    uint32_t q1 = divl((uint32_t)(n1 >> 32), (uint32_t)n1, v1, &r);
+
+    q_lo = (uint32_t)(((uint64_t)q1 << s) >> 31);
+    if (q_lo != 0)
+    {
+        q_lo--;
+    }
+
+    uint64_t prod = mul32(q_lo, d_lo) + ((uint64_t)(q_lo * d_hi) << 32);
+    uint64_t left = n - prod;
+    if (left >= d)
+    {
+        q_lo++;
+        left -= d;
+    }
+
+    if (rem)
+    {
+        *rem = left;
+    }
+    return q_lo;
+}
+
+uint64_t __udivdi3(uint64_t n, uint64_t d)
+{
+    return __udivmoddi4(n, d, 0);
+}
+
+uint64_t __umoddi3(uint64_t n, uint64_t d)
+{
+    uint64_t r;
+    __udivmoddi4(n, d, &r);
+    return r;
+}
+
+int64_t __divmoddi4(int64_t n, int64_t d, int64_t *rem)
+{
+    uint64_t un = (n < 0) ? 0 - (uint64_t)n : (uint64_t)n;
+    uint64_t ud = (d < 0) ? 0 - (uint64_t)d : (uint64_t)d;
+    uint64_t ur;
+    uint64_t uq = __udivmoddi4(un, ud, &ur);
+
+    /* Quotient truncates toward zero, remainder takes the dividend's sign */
+    if (rem)
+    {
+        *rem = (n < 0) ? -(int64_t)ur : (int64_t)ur;
+    }
+    return ((n < 0) != (d < 0)) ? -(int64_t)uq : (int64_t)uq;
+}
+
+int64_t __divdi3(int64_t n, int64_t d)
+{
+    return __divmoddi4(n, d, 0);
+}
+
+int64_t __moddi3(int64_t n, int64_t d)
+{
+    int64_t r;
+    __divmoddi4(n, d, &r);
+    return r;
+}
@@ -0,0 +1,50 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stdint.h>
+
+#ifdef HOST_BUILD
+/* Host builds route port I/O to the stand-in in host/host_io.c */
+uint8_t host_inb(uint16_t port);
+void host_outb(uint16_t port, uint8_t val);
+uint32_t host_inl(uint16_t port);
+void host_outl(uint16_t port, uint32_t val);
+
+static inline uint8_t inb(uint16_t port) {
+    return host_inb(port);
+}
+
+static inline void outb(uint16_t port, uint8_t val) {
+    host_outb(port, val);
+}
+
+static inline uint32_t inl(uint16_t port) {
+    return host_inl(port);
+}
+
+static inline void outl(uint16_t port, uint32_t val) {
+    host_outl(port, val);
+}
+#else
+static inline uint8_t inb(uint16_t port) {
+    uint8_t ret;
+    asm volatile ("inb %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+static inline void outb(uint16_t port, uint8_t val) {
+    asm volatile ("outb %0, %1" : : "a"(val), "Nd"(port));
+}
+
+static inline uint32_t inl(uint16_t port) {
+    uint32_t ret;
+    asm volatile ("inl %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+static inline void outl(uint16_t port, uint32_t val) {
+    asm volatile ("outl %0, %1" : : "a"(val), "Nd"(port));
+}
+#endif
+
+#endif
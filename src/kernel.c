@@ -3,86 +3,301 @@
 #include "vbe.h"
 #include "keyboard.h"
 #include "lvgl_port.h"
+#include "serial.h"
+#include "trace.h"
+#include "idt.h"
+#include "timer.h"
+#include "ksyms.h"
+#include "prof.h"
+#include "widget_stats.h"
+#include "memmon.h"
+#include "stack.h"
+#include "scroll_accel.h"
+#include "layer_cache.h"
+#include "glyph_cache.h"
+#include "console.h"
+#include "modfs.h"
+#include "tiled_image.h"
+#include "pacer.h"
+#include "remote.h"
+#include "capture.h"
+#include "replay.h"
+#include "virtio_gpu.h"
+#include "vlist.h"
+#include "ui_batch.h"
+#include "snapshot.h"
+#include "io.h"
+#include "cpu.h"
+#include "blend_sw.h"
+#include "ui_gen.h"
 #include "lvgl/lvgl.h"
 
-/* Simple delay function */
-static void delay(uint32_t count) {
-    for (volatile uint32_t i = 0; i < count * 1000; i++);
+/* Rows of the demo list ("rows" in ui.json); only the visible ones
+ * exist as objects */
+#define UI_ROWS 10000
+
+/* Checked state lives with the data, rows are recycled */
+static uint8_t row_checked[(UI_ROWS + 7) / 8];
+
+/* Named in ui.json: fills a recycled row with item `index` */
+void ui_bind_row(lv_obj_t *row, uint32_t index, void *user_data) {
+    (void)user_data;
+
+    lv_label_set_text_fmt(lv_obj_get_child(row, 0), "List item %u", (unsigned)index);
+    if (index < UI_ROWS && (row_checked[index / 8] & (1 << (index % 8)))) {
+        lv_obj_add_state(row, LV_STATE_CHECKED);
+    } else {
+        lv_obj_remove_state(row, LV_STATE_CHECKED);
+    }
+}
+
+/* Named in ui.json: Enter toggles the focused row */
+void ui_list_clicked(lv_event_t *e) {
+    lv_obj_t *list = lv_event_get_current_target(e);
+    uint32_t index = vlist_get_focused(list);
+
+    if (index < UI_ROWS) {
+        row_checked[index / 8] ^= 1 << (index % 8);
+        vlist_refresh(list);
+    }
+}
+
+/* With virtio-gpu, the hardware cursor points at the focused row. It
+ * follows focus moves and the scrolling they cause without a redraw. */
+static void point_cursor_at_focus(lv_obj_t *list) {
+    uint32_t index = vlist_get_focused(list);
+    uint32_t n = lv_obj_get_child_count(list);
+
+    for (uint32_t i = 0; i < n; i++) {
+        lv_obj_t *row = lv_obj_get_child(list, (int32_t)i);
+        if (vlist_get_row_index(row) != index)
+            continue;
+
+        lv_area_t a;
+        lv_obj_update_layout(row);
+        lv_obj_get_coords(row, &a);
+        virtio_gpu_cursor_move(a.x2 - 48, (a.y1 + a.y2) / 2);
+        return;
+    }
+}
+
+static void cursor_follow_cb(lv_event_t *e) {
+    point_cursor_at_focus(lv_event_get_current_target(e));
 }
 
-/* Create the UI based on your example */
+/* Create the UI described in ui.json (compiled by ui-gen.py) */
 static void create_ui(void) {
-    lv_obj_t *list = lv_obj_create(lv_screen_active());
-    lv_obj_set_size(list, 640, 480);
-    lv_obj_center(list);
-    lv_obj_set_flex_flow(list, LV_FLEX_FLOW_COLUMN);
-    
-    static lv_style_t style_normal;
-    lv_style_init(&style_normal);
-    lv_style_set_bg_color(&style_normal, lv_palette_main(LV_PALETTE_BLUE_GREY));
-    lv_style_set_radius(&style_normal, 0);
-    
-    static lv_style_t style_checked;
-    lv_style_init(&style_checked);
-    lv_style_set_bg_color(&style_checked, lv_palette_main(LV_PALETTE_ORANGE));
-    
-    static lv_style_t style_focus;
-    lv_style_init(&style_focus);
-    lv_style_set_outline_width(&style_focus, 3);
-    lv_style_set_outline_color(&style_focus, lv_palette_main(LV_PALETTE_RED));
-    lv_style_set_outline_pad(&style_focus, 2);
-    
-    /* Get the default group for keyboard navigation */
+    ui_main_t ui;
+    ui_main_create(lv_screen_active(), &ui);
+
+    /* Optional background from an assets archive module (modfs.c), as a
+     * tiled image (tiled_image.c) or an uncompressed one */
+    const lv_image_dsc_t *wallpaper = modfs_image("wallpaper.bin");
+    if (modfs_map("wallpaper.tim", NULL))
+        lv_obj_set_style_bg_image_src(lv_screen_active(), "M:/wallpaper.tim", 0);
+    else if (wallpaper)
+        lv_obj_set_style_bg_image_src(lv_screen_active(), wallpaper, 0);
+    scroll_accel_attach(ui.list);
+
+    /* Rows only change when rebound or (un)focused; the rest of the time a
+     * neighbour's focus outline redraws them from the layer cache */
+    uint32_t rows = lv_obj_get_child_count(ui.list);
+    for (uint32_t i = 0; i < rows; i++)
+        layer_cache_attach(lv_obj_get_child(ui.list, (int32_t)i));
+
+    /* The list is the single stop in the keyboard navigation group */
     lv_group_t *group = lv_group_get_default();
-    
-    lv_obj_t *first_btn = NULL;
-    
-    for (int i = 0; i < 10; i++) {
-        lv_obj_t *btn = lv_button_create(list);
-        lv_obj_set_size(btn, lv_pct(100), LV_SIZE_CONTENT);
-        lv_obj_add_flag(btn, LV_OBJ_FLAG_CHECKABLE);
-        lv_obj_add_style(btn, &style_normal, LV_STATE_DEFAULT);
-        lv_obj_add_style(btn, &style_checked, LV_STATE_CHECKED);
-        lv_obj_add_style(btn, &style_focus, LV_STATE_FOCUSED);
-        
-        lv_obj_t *label = lv_label_create(btn);
-        lv_label_set_text_fmt(label, "List item %d", i);
-        
-        /* Add button to keyboard navigation group */
-        lv_group_add_obj(group, btn);
-        
-        if (i == 0) {
-            first_btn = btn;
-        }
+    if (group) {
+        lv_group_add_obj(group, ui.list);
+        lv_group_focus_obj(ui.list);
     }
-    
-    /* Focus the first button */
-    if (first_btn && group) {
-        lv_group_focus_obj(first_btn);
+
+    lv_obj_add_event_cb(ui.list, cursor_follow_cb, LV_EVENT_VALUE_CHANGED, NULL);
+    lv_obj_add_event_cb(ui.list, cursor_follow_cb, LV_EVENT_SCROLL, NULL);
+    point_cursor_at_focus(ui.list);
+}
+
+/* Single-byte commands received on COM1 */
+static void handle_serial_command(int c) {
+    switch (c) {
+        case 't':
+            trace_dump();
+            break;
+        case 'p':
+            if (prof_running()) {
+                prof_stop();
+                serial_puts("profiler stopped\n");
+            } else {
+                prof_start();
+                serial_puts("profiler started\n");
+            }
+            break;
+        case 'P':
+            prof_dump();
+            break;
+        case 'w':
+            widget_stats_dump();
+            break;
+        case 'W':
+            widget_stats_reset();
+            break;
+        case 'm':
+            memmon_dump();
+            break;
+        case 'M':
+            memmon_dump_callsites();
+            break;
+        case 'a':
+            memmon_trace_toggle();
+            break;
+        case 's':
+            stack_dump();
+            break;
+        case 'b':
+            ui_batch_bench();
+            break;
+        case 'S':
+            snapshot_dump();
+            break;
+        case 'c':
+            layer_cache_dump();
+            break;
+        case 'g':
+            glyph_cache_dump();
+            break;
+        case 'L':
+            console_flood_toggle();
+            break;
+        case 'f':
+            modfs_dump();
+            break;
+        case 'i':
+            tiled_image_dump();
+            break;
+        case 'v':
+            pacer_dump();
+            break;
+        case 'r':
+            remote_dump();
+            break;
+        case 'h':
+            capture_print();
+            break;
+        case 'd':
+            capture_dump();
+            break;
+        case 'k':
+            replay_toggle_record();
+            break;
+        case 'y':
+            replay_toggle();
+            break;
+        case 'Y':
+            replay_receive();
+            break;
+        case 'u':
+            virtio_gpu_dump();
+            break;
+        default:
+            break;
     }
 }
 
 void kernel_main(uint32_t magic, void *mboot_info) {
     (void)magic;
     
+    serial_init();
+    trace_init();
+    cpu_init();
+    blend_sw_init(cpu_features());
+    ksyms_init(mboot_info);
+    modfs_init(mboot_info);
+
+    idt_init();
+    timer_init();
+    irq_enable();
+
+    trace_begin("vbe_init");
     vbe_init(mboot_info);
+    trace_end("vbe_init");
+
+    /* display=virtio moves the framebuffer to RAM shown by virtio-gpu */
+    trace_begin("virtio_gpu_init");
+    virtio_gpu_init(mboot_info);
+    trace_end("virtio_gpu_init");
+
+    trace_begin("vbe_clear");
     vbe_clear(0x000000);
+    trace_end("vbe_clear");
+
+    trace_begin("keyboard_init");
     keyboard_init();
-    lvgl_port_init();
-    create_ui();
-    
+    trace_end("keyboard_init");
+
+    remote_init();
+
+    if (snapshot_restore(mboot_info) == SNAPSHOT_RESTORED) {
+        /* LVGL and the UI are back as they were; only the pixels are not */
+        lv_obj_invalidate(lv_screen_active());
+    } else {
+        trace_begin("lvgl_port_init");
+        lvgl_port_init();
+        trace_end("lvgl_port_init");
+
+        glyph_cache_init();
+        modfs_lvgl_init();
+        tiled_image_init();
+        pacer_init();
+        replay_init();
+
+        trace_begin("create_ui");
+        create_ui();
+        trace_end("create_ui");
+
+        widget_stats_attach(lv_screen_active());
+    }
+
+    /* No VGA retrace to wait for behind virtio-gpu; after the restore,
+     * which brings back the pacer's setting */
+    if (virtio_gpu_active())
+        pacer_set_vsync(0);
+
+    if (snapshot_dump_requested(mboot_info)) {
+        /* Render-ready state, then leave QEMU if it has isa-debug-exit
+         * on port 0xf4 (make snapshot.img); a no-op elsewhere */
+        pacer_refresh_now();
+        snapshot_dump();
+        outb(0xf4, 0);
+    }
+
+    /* Golden-image run on virtual time (make golden-check); no return */
+    uint32_t capture_frames = capture_requested(mboot_info);
+    if (capture_frames)
+        capture_run(mboot_info, capture_frames);
+
+    /* Recorded input from a module, replayed at boot with replay=N */
+    replay_boot(mboot_info);
+
+    lvgl_port_tick_start();
+
     /* Main loop */
     while (1) {
+        int cmd = serial_read();
+        if (cmd >= 0) {
+            handle_serial_command(cmd);
+        }
+
+        stack_check();
+
         /* Poll keyboard every iteration */
         keyboard_handler();
         
-        /* Update LVGL tick (1ms per iteration) */
-        lvgl_port_tick();
-        
         /* Call LVGL timer handler every iteration for responsive input */
         lv_timer_handler();
-        
-        /* Small delay */
-        delay(1);
+
+        /* Redraw the display if a frame deadline has passed */
+        pacer_poll();
+        remote_poll();
+        replay_poll();
     }
 }
\ No newline at end of file
@@ -1,14 +1,9 @@
 #include "keyboard.h"
+#include "io.h"
 
 #define KEYBOARD_DATA_PORT 0x60
 #define KEYBOARD_STATUS_PORT 0x64
 
-static inline uint8_t inb(uint16_t port) {
-    uint8_t ret;
-    asm volatile ("inb %1, %0" : "=a"(ret) : "Nd"(port));
-    return ret;
-}
-
 /* Scancode to ASCII mapping (US keyboard, simplified) */
 static const char scancode_to_ascii[128] = {
     0,  27, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
@@ -101,6 +96,10 @@ void keyboard_handler(void) {
     }
 }
 
+void keyboard_inject(key_event_t key) {
+    enqueue_key(key);
+}
+
 int keyboard_has_key(void) {
     return queue_head != queue_tail;
 }
@@ -15,5 +15,7 @@ void keyboard_init(void);
 void keyboard_handler(void);
 int keyboard_has_key(void);
 key_event_t keyboard_get_key(void);
+/* Queues a key as if it had been typed */
+void keyboard_inject(key_event_t key);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <stddef.h>
+#include "ksyms.h"
+#include "multiboot.h"
+#include "snapshot.h"
+
+#define SHT_SYMTAB 2
+#define STT_FUNC   2
+
+typedef struct {
+    uint32_t sh_name;
+    uint32_t sh_type;
+    uint32_t sh_flags;
+    uint32_t sh_addr;
+    uint32_t sh_offset;
+    uint32_t sh_size;
+    uint32_t sh_link;
+    uint32_t sh_info;
+    uint32_t sh_addralign;
+    uint32_t sh_entsize;
+} elf32_shdr_t;
+
+typedef struct {
+    uint32_t st_name;
+    uint32_t st_value;
+    uint32_t st_size;
+    uint8_t st_info;
+    uint8_t st_other;
+    uint16_t st_shndx;
+} elf32_sym_t;
+
+/* Points into wherever GRUB loaded the tables on this boot */
+static const elf32_sym_t *symtab SNAPSHOT_SKIP;
+static uint32_t sym_count SNAPSHOT_SKIP;
+static const char *strtab SNAPSHOT_SKIP;
+
+int ksyms_init(void *mboot_info) {
+    multiboot_info_t *mb = (multiboot_info_t *)mboot_info;
+
+    symtab = NULL;
+    sym_count = 0;
+    if (!mb || !(mb->flags & MULTIBOOT_INFO_ELF_SHDR))
+        return -1;
+
+    uint32_t num = mb->syms[0];
+    uint32_t entsize = mb->syms[1];
+    uintptr_t base = mb->syms[2];
+
+    /* GRUB loads non-allocated sections too and patches their sh_addr */
+    for (uint32_t i = 0; i < num; i++) {
+        const elf32_shdr_t *sh = (const elf32_shdr_t *)(base + i * entsize);
+        if (sh->sh_type != SHT_SYMTAB || sh->sh_link >= num || !sh->sh_addr)
+            continue;
+
+        const elf32_shdr_t *str = (const elf32_shdr_t *)(base + sh->sh_link * entsize);
+        if (!str->sh_addr)
+            continue;
+
+        symtab = (const elf32_sym_t *)(uintptr_t)sh->sh_addr;
+        sym_count = sh->sh_size / sizeof(elf32_sym_t);
+        strtab = (const char *)(uintptr_t)str->sh_addr;
+        return 0;
+    }
+    return -1;
+}
+
+const char *ksyms_lookup(uint32_t addr, uint32_t *offset) {
+    const elf32_sym_t *best = NULL;
+
+    /* Linear scan: only used when dumping reports, never per sample */
+    for (uint32_t i = 0; i < sym_count; i++) {
+        const elf32_sym_t *s = &symtab[i];
+        if ((s->st_info & 0xF) != STT_FUNC || s->st_value > addr)
+            continue;
+        if (s->st_size && addr < s->st_value + s->st_size) {
+            best = s;
+            break;
+        }
+        /* Sizeless symbols (assembly): take the closest one below */
+        if (!s->st_size && (!best || s->st_value > best->st_value))
+            best = s;
+    }
+
+    if (!best)
+        return NULL;
+    if (offset)
+        *offset = addr - best->st_value;
+    return strtab + best->st_name;
+}
@@ -0,0 +1,14 @@
+#ifndef KSYMS_H
+#define KSYMS_H
+
+#include <stdint.h>
+
+/* Locates the kernel's ELF symbol table through the section headers GRUB
+ * passes in multiboot_info_t.syms. Returns 0 on success. */
+int ksyms_init(void *mboot_info);
+
+/* Name of the function containing addr, or NULL; *offset gets addr minus
+ * the symbol start when non-NULL */
+const char *ksyms_lookup(uint32_t addr, uint32_t *offset);
+
+#endif
@@ -0,0 +1,480 @@
+#include "layer_cache.h"
+
+#if PORT_LAYER_CACHE
+
+#include "lvgl/src/core/lv_obj_private.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "trace.h"
+
+#define ARENA_ALIGN 16
+#define CACHE_CF LV_COLOR_FORMAT_ARGB8888
+#define MAX_CHILDREN 32     /* Bits in entry_t.hidden */
+
+typedef struct {
+    lv_obj_t *obj;
+    uint32_t version;       /* Bumped by layer_cache_invalidate() */
+    uint32_t key;           /* Fingerprint the bitmap was captured at */
+    uint32_t seen_key;      /* Fingerprint of the last uncached draw */
+    uint32_t seen_frame;
+    uint32_t last_use;
+    uint32_t offset;        /* Bitmap position in the arena */
+    uint32_t size;          /* 0: no bitmap */
+    uint32_t hidden;        /* Children hidden for a hit, one bit each */
+    uint8_t want;           /* Capture once the frame is done */
+    uint8_t in_hit;         /* Own draw tasks muted until DRAW_POST_END */
+    uint8_t own_flag;       /* SEND_DRAW_TASK_EVENTS was set by attach */
+    lv_draw_buf_t buf;
+} entry_t;
+
+static entry_t entries[PORT_LAYER_CACHE_SLOTS];
+static layer_cache_stats_t stats;
+static uint32_t arena_used;     /* End of the last bitmap */
+static uint32_t use_clock;
+static uint32_t frame;
+static int capturing;
+static lv_display_t *hooked_disp;
+static lv_image_decoder_t *decoder;
+
+/* Bitmaps are cheap to rebuild, so a warm-boot snapshot leaves the arena
+ * out. After a restore arena_ready reads 0 and the bookkeeping resets */
+static uint8_t arena[PORT_LAYER_CACHE_SIZE] __attribute__((aligned(ARENA_ALIGN))) SNAPSHOT_SKIP;
+static int arena_ready SNAPSHOT_SKIP;
+
+static void arena_check(void) {
+    if (arena_ready)
+        return;
+    arena_ready = 1;
+    arena_used = 0;
+    stats.cached = 0;
+    stats.bytes = 0;
+    for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+        entries[i].size = 0;
+        entries[i].want = 0;
+    }
+}
+
+static entry_t *find(const lv_obj_t *obj) {
+    for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+        if (entries[i].obj == obj)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+static void drop(entry_t *e) {
+    if (!e->size)
+        return;
+    stats.bytes -= e->size;
+    stats.cached--;
+    e->size = 0;
+}
+
+/* Slides the bitmaps down over the holes left by dropped ones */
+static void compact(void) {
+    uint32_t at = 0;
+
+    for (;;) {
+        entry_t *next = NULL;
+        for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+            entry_t *e = &entries[i];
+            if (e->size && e->offset >= at && (!next || e->offset < next->offset))
+                next = e;
+        }
+        if (!next)
+            break;
+
+        if (next->offset != at) {
+            lv_memmove(arena + at, arena + next->offset, next->size);
+            lv_draw_buf_init(&next->buf, next->buf.header.w, next->buf.header.h, CACHE_CF,
+                             next->buf.header.stride, arena + at, next->size);
+            next->offset = at;
+        }
+        at += next->size;
+    }
+    arena_used = at;
+}
+
+/* Room for size bytes at arena_used: evicts the least recently drawn
+ * bitmaps until enough is free, then compacts if it is fragmented */
+static int reserve(uint32_t size) {
+    while (stats.bytes + size > PORT_LAYER_CACHE_SIZE) {
+        entry_t *lru = NULL;
+        for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+            entry_t *e = &entries[i];
+            if (e->size && (!lru || e->last_use < lru->last_use))
+                lru = e;
+        }
+        if (!lru)
+            return -1;
+        drop(lru);
+        stats.evictions++;
+    }
+    if (arena_used + size > PORT_LAYER_CACHE_SIZE)
+        compact();
+    return 0;
+}
+
+static uint32_t mix(uint32_t h, uint32_t v) {
+    return (h ^ v) * 16777619u;
+}
+
+/* Everything about the subtree that changes its pixels without going
+ * through layer_cache_invalidate(). The root's position is left out: the
+ * bitmap is drawn wherever the root is */
+static uint32_t fingerprint(const lv_obj_t *obj, const lv_obj_t *root, uint32_t h) {
+    h = mix(h, (uint32_t)(uintptr_t)obj->class_p);
+    h = mix(h, obj->state);
+    h = mix(h, obj->flags);
+    h = mix(h, (uint32_t)(obj->coords.x1 - root->coords.x1));
+    h = mix(h, (uint32_t)(obj->coords.y1 - root->coords.y1));
+    h = mix(h, (uint32_t)lv_area_get_width(&obj->coords));
+    h = mix(h, (uint32_t)lv_area_get_height(&obj->coords));
+    for (uint32_t i = 0; i < obj->style_cnt; i++) {
+        h = mix(h, (uint32_t)(uintptr_t)obj->styles[i].style);
+        h = mix(h, obj->styles[i].selector);
+    }
+    if (obj->class_p == &lv_label_class) {
+        for (const char *t = lv_label_get_text(obj); t && *t; t++)
+            h = mix(h, (uint8_t)*t);
+    }
+
+    uint32_t n = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < n; i++)
+        h = fingerprint(obj->spec_attr->children[i], root, h);
+    return h;
+}
+
+static uint32_t key_of(const entry_t *e) {
+    return fingerprint(e->obj, e->obj, mix(2166136261u, e->version));
+}
+
+static void bitmap_area(lv_obj_t *obj, lv_area_t *a) {
+    int32_t ext = lv_obj_get_ext_draw_size(obj);
+    lv_obj_get_coords(obj, a);
+    lv_area_increase(a, ext, ext);
+}
+
+static void capture(entry_t *e) {
+    lv_area_t a;
+    bitmap_area(e->obj, &a);
+    uint32_t w = (uint32_t)lv_area_get_width(&a);
+    uint32_t h = (uint32_t)lv_area_get_height(&a);
+    uint32_t stride = lv_draw_buf_width_to_stride(w, CACHE_CF);
+    uint32_t size = (stride * h + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    if (size > PORT_LAYER_CACHE_SIZE) {
+        stats.too_big++;
+        return;
+    }
+    if (reserve(size) != 0)
+        return;
+
+    lv_draw_buf_init(&e->buf, w, h, CACHE_CF, stride, arena + arena_used, size);
+    trace_begin("layer_capture");
+    capturing = 1;
+    lv_result_t res = lv_snapshot_take_to_draw_buf(e->obj, CACHE_CF, &e->buf);
+    capturing = 0;
+    trace_end("layer_capture");
+    if (res != LV_RESULT_OK)
+        return;
+
+    e->key = key_of(e);
+    e->offset = arena_used;
+    e->size = size;
+    e->last_use = ++use_clock;
+    arena_used += size;
+    stats.bytes += size;
+    stats.cached++;
+    stats.captures++;
+}
+
+/* A style transition or an animation changes the pixels from frame to
+ * frame without changing the key. Transitions live in the style list as
+ * temporary entries; their animations run on those, not on the object */
+static int animating(lv_obj_t *obj) {
+    if (lv_anim_get(obj, NULL))
+        return 1;
+    for (uint32_t i = 0; i < obj->style_cnt; i++) {
+        if (obj->styles[i].is_trans)
+            return 1;
+    }
+
+    uint32_t n = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < n; i++) {
+        if (animating(lv_obj_get_child(obj, (int32_t)i)))
+            return 1;
+    }
+    return 0;
+}
+
+/* Hiding a child invalidates it, which LVGL does not allow in the middle
+ * of a refresh, so invalidation is off while the flags change. Hiding a
+ * focused child would move the focus, so such objects are drawn live */
+static int can_hide_children(lv_obj_t *obj) {
+    uint32_t n = lv_obj_get_child_count(obj);
+    if (n > MAX_CHILDREN)
+        return 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (lv_obj_has_state(lv_obj_get_child(obj, (int32_t)i), LV_STATE_FOCUSED))
+            return 0;
+    }
+    return 1;
+}
+
+static void hide_children(entry_t *e) {
+    lv_display_t *disp = lv_obj_get_display(e->obj);
+    uint32_t n = lv_obj_get_child_count(e->obj);
+
+    lv_display_enable_invalidation(disp, false);
+    e->hidden = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        lv_obj_t *child = lv_obj_get_child(e->obj, (int32_t)i);
+        if (!lv_obj_has_flag(child, LV_OBJ_FLAG_HIDDEN)) {
+            lv_obj_add_flag(child, LV_OBJ_FLAG_HIDDEN);
+            e->hidden |= 1u << i;
+        }
+    }
+    lv_display_enable_invalidation(disp, true);
+}
+
+static void show_children(entry_t *e) {
+    lv_display_t *disp = lv_obj_get_display(e->obj);
+    uint32_t n = lv_obj_get_child_count(e->obj);
+
+    lv_display_enable_invalidation(disp, false);
+    for (uint32_t i = 0; i < n && i < MAX_CHILDREN; i++) {
+        if (e->hidden & (1u << i))
+            lv_obj_remove_flag(lv_obj_get_child(e->obj, (int32_t)i), LV_OBJ_FLAG_HIDDEN);
+    }
+    e->hidden = 0;
+    lv_display_enable_invalidation(disp, true);
+}
+
+/* The object's own draw tasks are already queued when LVGL reports them,
+ * so a hit empties them instead: the software renderer skips
+ * transparent draws */
+static void mute_task(lv_draw_task_t *t) {
+    switch (lv_draw_task_get_type(t)) {
+        case LV_DRAW_TASK_TYPE_FILL:
+            lv_draw_task_get_fill_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_BORDER:
+            lv_draw_task_get_border_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+            lv_draw_task_get_box_shadow_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_LABEL:
+            lv_draw_task_get_label_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_IMAGE:
+            lv_draw_task_get_image_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_LINE:
+            lv_draw_task_get_line_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        case LV_DRAW_TASK_TYPE_ARC:
+            lv_draw_task_get_arc_dsc(t)->opa = LV_OPA_TRANSP;
+            break;
+        default:
+            break;
+    }
+}
+
+/* A hit draws the bitmap, then hides the children so lv_obj_redraw()
+ * skips them and mutes the object's own draw tasks, up to and including
+ * the scrollbar and outline of DRAW_POST, which the bitmap holds too */
+static void draw_begin(entry_t *e, lv_layer_t *layer) {
+    lv_obj_t *obj = e->obj;
+
+    if (animating(obj)) {
+        stats.animated++;
+        e->want = 0;
+        return;
+    }
+
+    uint32_t key = key_of(e);
+    if (e->size && e->key == key && can_hide_children(obj)) {
+        lv_draw_image_dsc_t dsc;
+        lv_area_t a;
+        lv_draw_image_dsc_init(&dsc);
+        dsc.src = &e->buf;
+        bitmap_area(obj, &a);
+        lv_draw_image(layer, &dsc, &a);
+
+        e->last_use = ++use_clock;
+        hide_children(e);
+        e->in_hit = 1;
+        stats.hits++;
+        return;
+    }
+
+    stats.misses++;
+    drop(e);
+    /* Only content that survives into another frame is worth a capture */
+    if (e->seen_key == key && e->seen_frame != frame) {
+        e->want = 1;
+    } else if (e->seen_key != key) {
+        e->seen_key = key;
+        e->seen_frame = frame;
+    }
+}
+
+static void obj_event_cb(lv_event_t *ev) {
+    entry_t *e = lv_event_get_user_data(ev);
+
+    switch (lv_event_get_code(ev)) {
+        case LV_EVENT_DRAW_MAIN_BEGIN:
+            if (!capturing) {
+                arena_check();
+                draw_begin(e, lv_event_get_layer(ev));
+            }
+            break;
+        case LV_EVENT_DRAW_TASK_ADDED:
+            if (e->in_hit)
+                mute_task(lv_event_get_draw_task(ev));
+            break;
+        case LV_EVENT_DRAW_POST_BEGIN:
+            if (e->in_hit)
+                show_children(e);
+            break;
+        case LV_EVENT_DRAW_POST_END:
+            e->in_hit = 0;
+            break;
+        case LV_EVENT_STYLE_CHANGED:
+            e->version++;
+            break;
+        case LV_EVENT_DELETE:
+            drop(e);
+            lv_memset(e, 0, sizeof(*e));
+            stats.attached--;
+            break;
+        default:
+            break;
+    }
+}
+
+static void refr_ready_cb(lv_event_t *ev) {
+    (void)ev;
+    arena_check();
+    frame++;
+    for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+        entry_t *e = &entries[i];
+        if (e->obj && e->want) {
+            e->want = 0;
+            if (!e->size && !animating(e->obj))
+                capture(e);
+        }
+    }
+}
+
+/* The bin decoder is stubbed out (stdlib.c), so cached bitmaps come with a
+ * decoder of their own that hands out the buffer as is */
+static entry_t *entry_of_src(const void *src) {
+    for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+        if (src == &entries[i].buf && entries[i].size)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+static lv_result_t decoder_info(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc,
+                                lv_image_header_t *header) {
+    (void)dec;
+    entry_t *e = entry_of_src(dsc->src);
+    if (dsc->src_type != LV_IMAGE_SRC_VARIABLE || !e)
+        return LV_RESULT_INVALID;
+    *header = e->buf.header;
+    return LV_RESULT_OK;
+}
+
+static lv_result_t decoder_open(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc) {
+    (void)dec;
+    entry_t *e = entry_of_src(dsc->src);
+    if (!e)
+        return LV_RESULT_INVALID;
+    dsc->decoded = &e->buf;
+    return LV_RESULT_OK;
+}
+
+int layer_cache_attach(lv_obj_t *obj) {
+    entry_t *e = NULL;
+    for (uint32_t i = 0; i < PORT_LAYER_CACHE_SLOTS; i++) {
+        if (entries[i].obj == obj)
+            return 0;
+        if (!entries[i].obj && !e)
+            e = &entries[i];
+    }
+    if (!e)
+        return -1;
+
+    lv_display_t *disp = lv_obj_get_display(obj);
+    if (hooked_disp != disp) {
+        if (hooked_disp)
+            return -1;
+        hooked_disp = disp;
+        lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+    }
+    if (!decoder) {
+        decoder = lv_image_decoder_create();
+        lv_image_decoder_set_info_cb(decoder, decoder_info);
+        lv_image_decoder_set_open_cb(decoder, decoder_open);
+    }
+
+    arena_check();
+    lv_memset(e, 0, sizeof(*e));
+    e->obj = obj;
+    if (!lv_obj_has_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS)) {
+        lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+        e->own_flag = 1;
+    }
+    lv_obj_add_event_cb(obj, obj_event_cb, LV_EVENT_ALL, e);
+    stats.attached++;
+    return 0;
+}
+
+void layer_cache_detach(lv_obj_t *obj) {
+    entry_t *e = find(obj);
+    if (!e)
+        return;
+
+    if (e->hidden)
+        show_children(e);
+    if (e->own_flag)
+        lv_obj_remove_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+    drop(e);
+    lv_obj_remove_event_cb_with_user_data(obj, obj_event_cb, e);
+    lv_memset(e, 0, sizeof(*e));
+    stats.attached--;
+}
+
+void layer_cache_invalidate(lv_obj_t *obj) {
+    for (; obj; obj = lv_obj_get_parent(obj)) {
+        entry_t *e = find(obj);
+        if (e) {
+            e->version++;
+            drop(e);
+            return;
+        }
+    }
+}
+
+void layer_cache_get_stats(layer_cache_stats_t *out) {
+    *out = stats;
+}
+
+void layer_cache_dump(void) {
+    uint32_t draws = stats.hits + stats.misses;
+
+    serial_printf("layer cache: %u attached, %u cached, %u/%u KiB\n",
+                  (unsigned)stats.attached, (unsigned)stats.cached,
+                  (unsigned)(stats.bytes / 1024), (unsigned)(PORT_LAYER_CACHE_SIZE / 1024));
+    serial_printf("  hits %u misses %u (%u%% hit), live %u, captures %u, evictions %u, too big %u\n",
+                  (unsigned)stats.hits, (unsigned)stats.misses,
+                  (unsigned)(draws ? (uint64_t)stats.hits * 100 / draws : 0),
+                  (unsigned)stats.animated, (unsigned)stats.captures,
+                  (unsigned)stats.evictions, (unsigned)stats.too_big);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Retained layers for static subtrees. An attached object keeps a bitmap
+ * of itself and its children; while the subtree is unchanged, a redraw
+ * composites the bitmap instead of drawing the widgets. Unchanged means
+ * the same size, states, style lists, flags, child positions and label
+ * text. Anything else (e.g. editing a local style of a child) needs
+ * layer_cache_invalidate(). A subtree with a style transition or an
+ * animation running is drawn live and not captured. Bitmaps live in a
+ * fixed arena (PORT_LAYER_CACHE_SIZE); the least recently drawn ones are
+ * evicted.
+ */
+typedef struct {
+    uint32_t hits;          /* Redraws served from a bitmap */
+    uint32_t misses;        /* Redraws of attached objects without one */
+    uint32_t animated;      /* Redraws left live for a transition or animation */
+    uint32_t captures;      /* Bitmaps rendered */
+    uint32_t evictions;     /* Bitmaps dropped to make room */
+    uint32_t too_big;       /* Subtrees larger than the whole arena */
+    uint32_t attached;
+    uint32_t cached;        /* Attached objects holding a bitmap */
+    uint32_t bytes;         /* Arena bytes in use */
+} layer_cache_stats_t;
+
+#if PORT_LAYER_CACHE
+/* Opts obj and its subtree into caching; 0 on success, -1 if all
+ * PORT_LAYER_CACHE_SLOTS are taken */
+int layer_cache_attach(lv_obj_t *obj);
+void layer_cache_detach(lv_obj_t *obj);
+/* Drops the bitmap of obj, or of the attached ancestor containing it */
+void layer_cache_invalidate(lv_obj_t *obj);
+void layer_cache_get_stats(layer_cache_stats_t *stats);
+/* Prints the stats on serial ('c' command) */
+void layer_cache_dump(void);
+#else
+static inline int layer_cache_attach(lv_obj_t *obj) { (void)obj; return 0; }
+static inline void layer_cache_detach(lv_obj_t *obj) { (void)obj; }
+static inline void layer_cache_invalidate(lv_obj_t *obj) { (void)obj; }
+static inline void layer_cache_get_stats(layer_cache_stats_t *stats) { lv_memset(stats, 0, sizeof(*stats)); }
+static inline void layer_cache_dump(void) {}
+#endif
+
+#endif
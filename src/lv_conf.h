@@ -2,6 +2,7 @@
 #define LV_CONF_H
 
 #include <stdint.h>
+#include "port_conf.h"
 
 /* Prevent LVGL from using inttypes.h */
 #define LV_USE_STDLIB_MALLOC LV_STDLIB_CLIB
@@ -28,6 +29,9 @@
 /* Drawing settings */
 #define LV_DRAW_SW_SUPPORT_RGB565 0
 #define LV_DRAW_SW_SUPPORT_RGB888 1
+/* ARGB8888 blend loops come from blend_sw.h (PORT_BLEND_SW) */
+#define LV_USE_DRAW_SW_ASM LV_DRAW_SW_ASM_CUSTOM
+#define LV_DRAW_SW_ASM_CUSTOM_INCLUDE "blend_sw.h"
 
 /* Binary decoder (disable for bare metal) */
 #define LV_USE_BIN_DECODER 0
@@ -39,6 +43,8 @@
 
 /* Font settings */
 #define LV_FONT_MONTSERRAT_14 1
+/* Monospace, for the log console (console.c) */
+#define LV_FONT_UNSCII_8 1
 #define LV_FONT_DEFAULT &lv_font_montserrat_14
 
 /* Widget usage */
@@ -55,7 +61,15 @@
 /* Logging */
 #define LV_USE_LOG 0
 
+/* System monitor overlay; the memory line comes from lv_mem_monitor() */
+#define LV_USE_SYSMON PORT_MEM_OVERLAY
+#define LV_USE_PERF_MONITOR 0
+#define LV_USE_MEM_MONITOR PORT_MEM_OVERLAY
+#define LV_USE_MEM_MONITOR_POS LV_ALIGN_BOTTOM_LEFT
+
 /* Others */
+/* Renders a subtree into a buffer; the layer cache captures with it */
+#define LV_USE_SNAPSHOT 1
 #define LV_USE_ASSERT_NULL 1
 #define LV_USE_ASSERT_MALLOC 1
 #define LV_USE_ASSERT_MEM_INTEGRITY 0
@@ -1,6 +1,15 @@
 #include "lvgl_port.h"
 #include "vbe.h"
+#include "fb.h"
 #include "keyboard.h"
+#include "trace.h"
+#include "snapshot.h"
+#include "pacer.h"
+#include "remote.h"
+#include "replay.h"
+#include "virtio_gpu.h"
+#include "timer.h"
+#include "port_conf.h"
 
 static lv_display_t *disp;
 static lv_indev_t *indev;
@@ -8,29 +17,50 @@ static lv_indev_t *indev;
 /* Display flush callback */
 static void disp_flush_cb(lv_display_t *display, const lv_area_t *area, uint8_t *px_map)
 {
-    vbe_info_t *vbe = vbe_get_info();
+    pacer_before_flush();
+    trace_begin("flush");
+
+    /* LVGL 9.x renders 32-bit ARGB, the same layout as our framebuffer */
+    fb_blit(vbe_get_info(), area->x1, area->y1, lv_area_get_width(area),
+            lv_area_get_height(area), (const uint32_t *)px_map);
+
+    virtio_gpu_flush(area->x1, area->y1, lv_area_get_width(area), lv_area_get_height(area),
+                     lv_display_flush_is_last(display));
+    remote_flush(area, px_map, lv_display_flush_is_last(display));
 
-    int32_t x, y;
-    uint32_t *fb_ptr;
-    uint32_t *color_ptr = (uint32_t *)px_map;
+    trace_end("flush");
+    trace_counter("flush_px", (int32_t)lv_area_get_size(area));
+
+    lv_display_flush_ready(display);
+}
 
-    /* Bounds checking to prevent crashes */
-    int32_t y1 = (area->y1 < 0) ? 0 : area->y1;
-    int32_t y2 = (area->y2 >= (int32_t)vbe->height) ? (int32_t)vbe->height - 1 : area->y2;
-    int32_t x1 = (area->x1 < 0) ? 0 : area->x1;
-    int32_t x2 = (area->x2 >= (int32_t)vbe->width) ? (int32_t)vbe->width - 1 : area->x2;
+static uint32_t frames_done;
+
+uint32_t lvgl_port_frames(void)
+{
+    return frames_done;
+}
+
+/* Refresh spans for the timeline; the first completed refresh ends boot */
+static void disp_refr_event_cb(lv_event_t *e)
+{
+    /* Per boot, so a warm boot still ends its timeline */
+    static int first_frame_done SNAPSHOT_SKIP;
 
-    for (y = y1; y <= y2; y++)
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START)
     {
-        fb_ptr = vbe->framebuffer + y * (vbe->pitch / 4) + x1;
-        for (x = x1; x <= x2; x++)
-        {
-            /* LVGL 9.x uses 32-bit ARGB format directly */
-            *fb_ptr++ = *color_ptr++;
-        }
+        trace_begin("refresh");
+        return;
     }
 
-    lv_display_flush_ready(display);
+    trace_end("refresh");
+    frames_done++;
+    if (!first_frame_done)
+    {
+        first_frame_done = 1;
+        trace_instant("first_frame");
+        trace_boot_done();
+    }
 }
 
 /* Keyboard input read callback */
@@ -43,9 +73,9 @@ static void keyboard_read_cb(lv_indev_t *indev_drv, lv_indev_data_t *data)
         return;
     }
 
-    if (keyboard_has_key())
+    if (replay_has_key())
     {
-        key_event_t key = keyboard_get_key();
+        key_event_t key = replay_get_key();
 
         /* Map keys to LVGL */
         uint32_t lv_key = 0;
@@ -88,7 +118,7 @@ static void keyboard_read_cb(lv_indev_t *indev_drv, lv_indev_data_t *data)
             data->key = lv_key;
             data->state = LV_INDEV_STATE_PRESSED;
             /* Check if more keys are available */
-            data->continue_reading = keyboard_has_key();
+            data->continue_reading = replay_has_key();
         }
         else
         {
@@ -109,13 +139,20 @@ void lvgl_port_init(void)
     vbe_info_t *vbe = vbe_get_info();
 
     /* Initialize LVGL */
+    trace_begin("lv_init");
     lv_init();
+    trace_end("lv_init");
 
     /* Allocate display buffer in BSS (static) - 1/20 screen size for safety */
     static lv_color_t buf1[640 * 480 / 20];
 
+    /* Creating the display also initializes the default theme */
+    trace_begin("lv_display_create");
     disp = lv_display_create(vbe->width, vbe->height);
+    trace_end("lv_display_create");
     lv_display_set_flush_cb(disp, disp_flush_cb);
+    lv_display_add_event_cb(disp, disp_refr_event_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(disp, disp_refr_event_cb, LV_EVENT_REFR_READY, NULL);
     lv_display_set_buffers(disp, buf1, NULL, sizeof(buf1), LV_DISPLAY_RENDER_MODE_PARTIAL);
 
     /* Set color format to match our 32-bit framebuffer */
@@ -135,8 +172,31 @@ void lvgl_port_init(void)
     lv_group_set_wrap(group, true);
 }
 
-void lvgl_port_tick(void)
+/* LVGL time is base_ms plus the PIT ticks since base_pit, converted in
+ * one step so that no tick is counted twice or dropped. The PIT count
+ * starts again from 0 on every boot; tick_ms, the last time handed out,
+ * carries on from a warm-boot snapshot and becomes the new base. */
+static uint32_t tick_ms;
+static uint32_t base_ms SNAPSHOT_SKIP;
+static uint32_t base_pit SNAPSHOT_SKIP;
+static int tick_running SNAPSHOT_SKIP;
+
+static uint32_t tick_get_cb(void)
+{
+    /* A snapshot taken with 'S' comes back with this callback installed,
+     * before lvgl_port_tick_start() has set the base */
+    if (!tick_running)
+        return tick_ms;
+
+    tick_ms = base_ms + (uint32_t)((uint64_t)(timer_ticks() - base_pit) * 1000 / PORT_TIMER_HZ);
+    return tick_ms;
+}
+
+void lvgl_port_tick_start(void)
 {
-    /* Increment tick by 1ms */
-    lv_tick_inc(1);
+    /* Carry on from the current time, e.g. a warm-boot snapshot's */
+    base_ms = lv_tick_get();
+    base_pit = timer_ticks();
+    tick_running = 1;
+    lv_tick_set_cb(tick_get_cb);
 }
\ No newline at end of file
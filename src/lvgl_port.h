@@ -4,6 +4,10 @@
 #include "lvgl/lvgl.h"
 
 void lvgl_port_init(void);
-void lvgl_port_tick(void);
+/* From here on LVGL's clock follows the PIT. Until then it only moves
+ * with lv_tick_inc(), which is what capture.c's virtual time relies on. */
+void lvgl_port_tick_start(void);
+/* Display refreshes completed so far */
+uint32_t lvgl_port_frames(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "memmon.h"
+#include "heap.h"
+#include "ksyms.h"
+#include "lvgl_port.h"
+#include "port_conf.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "timer.h"
+
+/* Counters at the previous memmon_dump, for the per-interval rates */
+static struct {
+    uint32_t ticks;
+    uint32_t frames;
+    uint32_t allocs;
+    uint32_t frees;
+    uint64_t bytes;
+} last;
+
+void memmon_dump(void) {
+    heap_stats_t st;
+    heap_get_stats(&st);
+
+    uint32_t ticks = timer_ticks();
+    uint32_t frames = lvgl_port_frames();
+    uint32_t d_ticks = ticks - last.ticks;
+    uint32_t d_frames = frames - last.frames;
+    uint32_t d_allocs = st.alloc_total - last.allocs;
+    uint32_t d_frees = st.free_total - last.frees;
+    uint32_t d_bytes = (uint32_t)(st.alloc_bytes - last.bytes);
+
+    serial_puts("\n# --- heap ---\n");
+    serial_printf("used %u of %u bytes (%u%%) in %u blocks, peak %u\n",
+                  (unsigned)st.used_size, (unsigned)st.total_size,
+                  (unsigned)(st.used_size * 100ULL / st.total_size),
+                  (unsigned)st.used_cnt, (unsigned)st.peak_used);
+    serial_printf("free %u bytes in %u blocks, largest %u, frag %u%%\n",
+                  (unsigned)st.free_size, (unsigned)st.free_cnt,
+                  (unsigned)st.largest_free, (unsigned)st.frag_pct);
+    serial_printf("since last: %u allocs, %u frees, %u bytes over %u ms, %u frames\n",
+                  (unsigned)d_allocs, (unsigned)d_frees, (unsigned)d_bytes,
+                  (unsigned)(d_ticks * 1000ULL / PORT_TIMER_HZ),
+                  (unsigned)d_frames);
+    if (d_frames)
+        serial_printf("per frame: %u allocs, %u frees, %u bytes\n",
+                      (unsigned)(d_allocs / d_frames),
+                      (unsigned)(d_frees / d_frames),
+                      (unsigned)(d_bytes / d_frames));
+    serial_printf("heap check: %s\n", heap_check() == 0 ? "ok" : "CORRUPT");
+    serial_puts("# --- end ---\n");
+
+    last.ticks = ticks;
+    last.frames = frames;
+    last.allocs = st.alloc_total;
+    last.frees = st.free_total;
+    last.bytes = st.alloc_bytes;
+}
+
+#if PORT_MEM_CALLSITES
+/* Frame count at the previous 'M'; the per-site alloc counters are reset
+ * there too, so each report covers the frames since */
+static uint32_t callsite_frames;
+
+/* Selection sort of the top PORT_MEM_CALLSITE_TOP by key; the table is small */
+static void sort_top(heap_callsite_t *sites, int n, int by_blocks) {
+    for (int i = 0; i < n && i < PORT_MEM_CALLSITE_TOP; i++) {
+        int best = i;
+        for (int j = i + 1; j < n; j++) {
+            int more = by_blocks ? sites[j].allocs > sites[best].allocs
+                                 : sites[j].bytes > sites[best].bytes;
+            if (more)
+                best = j;
+        }
+        heap_callsite_t tmp = sites[i];
+        sites[i] = sites[best];
+        sites[best] = tmp;
+    }
+}
+
+/* Tenths, for rates that are often below one per frame */
+static void put_rate(uint64_t total, uint32_t frames) {
+    uint64_t r = total * 10 / frames;
+    serial_printf("%9u.%u", (unsigned)(r / 10), (unsigned)(r % 10));
+}
+
+static void print_sites(const char *title, heap_callsite_t *sites, int n, uint32_t frames) {
+    serial_printf("# %s\n", title);
+    serial_puts("#  bytes/frame  blks/frame  live bytes  live blks  site\n");
+    for (int i = 0; i < n && i < PORT_MEM_CALLSITE_TOP; i++) {
+        const heap_callsite_t *c = &sites[i];
+        uint32_t off;
+        const char *name = ksyms_lookup(c->caller, &off);
+
+        if (!c->allocs)
+            break;
+        serial_puts("  ");
+        put_rate(c->bytes, frames);
+        serial_puts(" ");
+        put_rate(c->allocs, frames);
+        serial_printf(" %11u %10u  ", (unsigned)c->live_bytes, (unsigned)c->live_blocks);
+        if (name)
+            serial_printf("%s+0x%x\n", name, (unsigned)off);
+        else
+            serial_printf("0x%08x\n", (unsigned)c->caller);
+    }
+}
+#endif
+
+void memmon_dump_callsites(void) {
+#if PORT_MEM_CALLSITES
+    static heap_callsite_t sites[PORT_MEM_CALLSITE_SLOTS];
+    int n = heap_get_callsites(sites, PORT_MEM_CALLSITE_SLOTS);
+    uint32_t now = lvgl_port_frames();
+    uint32_t frames = now - callsite_frames;
+
+    if (frames == 0)
+        frames = 1;
+
+    serial_printf("\n# --- heap call sites, %u frames ---\n", (unsigned)(now - callsite_frames));
+    sort_top(sites, n, 0);
+    print_sites("by bytes allocated", sites, n, frames);
+    sort_top(sites, n, 1);
+    print_sites("by blocks allocated", sites, n, frames);
+    serial_puts("# --- end ---\n");
+
+    heap_reset_callsites();
+    callsite_frames = now;
+#else
+    serial_puts("heap call sites disabled (PORT_MEM_CALLSITES)\n");
+#endif
+}
+
+static int tracing SNAPSHOT_SKIP;
+
+static void trace_op(char op, uint32_t id, uint32_t size, uint32_t new_id) {
+    if (op == 'f')
+        serial_printf("f %u\n", (unsigned)id);
+    else if (op == 'r' && new_id != id)
+        serial_printf("r %u %u %u\n", (unsigned)id, (unsigned)size, (unsigned)new_id);
+    else
+        serial_printf("%c %u %u\n", op, (unsigned)id, (unsigned)size);
+}
+
+void memmon_trace_toggle(void) {
+    tracing = !tracing;
+    if (tracing) {
+        serial_puts("\n# --- heap trace ---\n");
+        heap_set_trace(trace_op);
+    } else {
+        heap_set_trace(NULL);
+        serial_puts("# --- end ---\n");
+    }
+}
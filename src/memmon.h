@@ -0,0 +1,19 @@
+#ifndef MEMMON_H
+#define MEMMON_H
+
+/*
+ * Serial reports on the kernel heap (see heap.h): occupancy, peak and
+ * fragmentation, plus allocation rates since the previous report.
+ */
+void memmon_dump(void);
+
+/* Top allocation call sites by bytes and by blocks allocated per frame
+ * since the previous call, which starts a new interval; needs
+ * PORT_MEM_CALLSITES */
+void memmon_dump_callsites(void);
+
+/* Starts or stops printing every LVGL allocation on serial, in the trace
+ * format of the host allocator bench ('a' command) */
+void memmon_trace_toggle(void);
+
+#endif
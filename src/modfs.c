@@ -0,0 +1,427 @@
+#include "modfs.h"
+
+#if PORT_MODFS
+
+#include "multiboot.h"
+#include "serial.h"
+#include "snapshot.h"
+
+#define TAR_BLOCK 512
+
+/* POSIX ustar header */
+typedef struct {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char chksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];          /* "ustar\0" */
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+} tar_header_t;
+
+typedef struct {
+    char path[PORT_MODFS_PATH_MAX];
+    const uint8_t *data;
+    uint32_t size;
+    int is_image;
+    lv_image_dsc_t img;     /* Pixels in the module */
+    lv_draw_buf_t buf;      /* The same pixels for the decoder */
+} file_t;
+
+typedef struct {
+    const file_t *file;     /* NULL: handle is free */
+    uint32_t pos;
+} handle_t;
+
+/* The index describes the modules of this boot, so it is rebuilt on every
+ * boot and kept out of warm-boot snapshots. Its address is stable, so
+ * restored objects that use an image from it stay valid */
+static file_t files[PORT_MODFS_MAX_FILES] SNAPSHOT_SKIP;
+static uint32_t file_count SNAPSHOT_SKIP;
+static uint32_t archive_count SNAPSHOT_SKIP;
+static uint32_t skipped SNAPSHOT_SKIP;      /* Over PORT_MODFS_MAX_FILES or path too long */
+static handle_t handles[PORT_MODFS_FILES] SNAPSHOT_SKIP;
+
+static lv_fs_drv_t drv;
+static lv_image_decoder_t *decoder;
+
+static uint32_t octal(const char *s, uint32_t len) {
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < len && s[i] >= '0' && s[i] <= '7'; i++)
+        v = v * 8 + (uint32_t)(s[i] - '0');
+    return v;
+}
+
+static uint32_t str_len(const char *s, uint32_t max) {
+    uint32_t n = 0;
+    while (n < max && s[n])
+        n++;
+    return n;
+}
+
+static int str_eq(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static int header_valid(const tar_header_t *h) {
+    static const char magic[5] = { 'u', 's', 't', 'a', 'r' };
+    for (int i = 0; i < 5; i++) {
+        if (h->magic[i] != magic[i])
+            return 0;
+    }
+
+    /* Sum of all header bytes, with the checksum field read as spaces */
+    const uint8_t *b = (const uint8_t *)h;
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < TAR_BLOCK; i++)
+        sum += (i >= 148 && i < 156) ? ' ' : b[i];
+    return sum == octal(h->chksum, sizeof(h->chksum));
+}
+
+/* prefix + "/" + name, without a leading "./" or "/" */
+static int make_path(const tar_header_t *h, char *out) {
+    uint32_t plen = str_len(h->prefix, sizeof(h->prefix));
+    uint32_t nlen = str_len(h->name, sizeof(h->name));
+    uint32_t n = 0;
+
+    if (plen + 1 + nlen + 1 > PORT_MODFS_PATH_MAX)
+        return -1;
+    for (uint32_t i = 0; i < plen; i++)
+        out[n++] = h->prefix[i];
+    if (plen)
+        out[n++] = '/';
+    for (uint32_t i = 0; i < nlen; i++)
+        out[n++] = h->name[i];
+    out[n] = '\0';
+
+    uint32_t skip = 0;
+    while (out[skip] == '.' && out[skip + 1] == '/')
+        skip += 2;
+    while (out[skip] == '/')
+        skip++;
+    if (skip) {
+        for (uint32_t i = 0; i <= n - skip; i++)
+            out[i] = out[i + skip];
+    }
+    return out[0] ? 0 : -1;
+}
+
+static int ends_with(const char *s, const char *suffix) {
+    uint32_t n = str_len(s, PORT_MODFS_PATH_MAX);
+    uint32_t m = str_len(suffix, PORT_MODFS_PATH_MAX);
+    return n >= m && str_eq(s + n - m, suffix);
+}
+
+/* A ".bin" file with a v9 header and all of its pixels present */
+static void probe_image(file_t *f) {
+    const lv_image_header_t *h = (const lv_image_header_t *)f->data;
+
+    if (!ends_with(f->path, ".bin") || f->size < sizeof(*h) ||
+        h->magic != LV_IMAGE_HEADER_MAGIC || (h->flags & LV_IMAGE_FLAGS_COMPRESSED) ||
+        h->w == 0 || h->h == 0 || h->stride == 0)
+        return;
+
+    uint32_t data_size = (uint32_t)h->stride * h->h;
+    if (f->size - sizeof(*h) < data_size)
+        return;
+
+    const uint8_t *px = f->data + sizeof(*h);
+    f->img.header = *h;
+    f->img.data_size = data_size;
+    f->img.data = px;
+    lv_draw_buf_init(&f->buf, h->w, h->h, (lv_color_format_t)h->cf, h->stride, (void *)px,
+                     data_size);
+    /* Module memory is not for drawing into */
+    f->buf.header.flags = h->flags & LV_IMAGE_FLAGS_PREMULTIPLIED;
+    f->is_image = 1;
+}
+
+static void index_archive(const uint8_t *p, uint32_t len) {
+    uint32_t off = 0;
+
+    archive_count++;
+    while (off + TAR_BLOCK <= len) {
+        const tar_header_t *h = (const tar_header_t *)(p + off);
+        if (h->name[0] == '\0' || !header_valid(h))
+            break;      /* End-of-archive block */
+
+        uint32_t size = octal(h->size, sizeof(h->size));
+        const uint8_t *data = p + off + TAR_BLOCK;
+        off += TAR_BLOCK + (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+        if (off > len)
+            break;      /* Truncated module */
+
+        /* Regular files only */
+        if (h->typeflag != '0' && h->typeflag != '\0')
+            continue;
+        if (file_count == PORT_MODFS_MAX_FILES) {
+            skipped++;
+            continue;
+        }
+
+        file_t *f = &files[file_count];
+        if (make_path(h, f->path) != 0) {
+            skipped++;
+            continue;
+        }
+        f->data = data;
+        f->size = size;
+        probe_image(f);
+        file_count++;
+    }
+}
+
+void modfs_init(void *mboot_info) {
+    multiboot_info_t *mb = mboot_info;
+
+    file_count = 0;
+    archive_count = 0;
+    skipped = 0;
+    if (!mb || !(mb->flags & MULTIBOOT_INFO_MODS))
+        return;
+
+    const multiboot_module_t *mods = (const multiboot_module_t *)mb->mods_addr;
+    for (uint32_t i = 0; i < mb->mods_count; i++) {
+        const uint8_t *p = (const uint8_t *)mods[i].mod_start;
+        uint32_t len = mods[i].mod_end - mods[i].mod_start;
+        if (len >= TAR_BLOCK && header_valid((const tar_header_t *)p))
+            index_archive(p, len);
+    }
+}
+
+static const file_t *find(const char *path) {
+    while (*path == '/')
+        path++;
+    for (uint32_t i = 0; i < file_count; i++) {
+        if (str_eq(files[i].path, path))
+            return &files[i];
+    }
+    return NULL;
+}
+
+const void *modfs_map(const char *path, uint32_t *size) {
+    const file_t *f = find(path);
+    if (!f)
+        return NULL;
+    if (size)
+        *size = f->size;
+    return f->data;
+}
+
+const lv_image_dsc_t *modfs_image(const char *path) {
+    const file_t *f = find(path);
+    return f && f->is_image ? &f->img : NULL;
+}
+
+/* LVGL drive */
+
+static void *fs_open(lv_fs_drv_t *d, const char *path, lv_fs_mode_t mode) {
+    (void)d;
+    if (mode & LV_FS_MODE_WR)
+        return NULL;
+
+    const file_t *f = find(path);
+    if (!f)
+        return NULL;
+    for (uint32_t i = 0; i < PORT_MODFS_FILES; i++) {
+        if (!handles[i].file) {
+            handles[i].file = f;
+            handles[i].pos = 0;
+            return &handles[i];
+        }
+    }
+    return NULL;
+}
+
+static lv_fs_res_t fs_close(lv_fs_drv_t *d, void *file) {
+    (void)d;
+    ((handle_t *)file)->file = NULL;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_read(lv_fs_drv_t *d, void *file, void *buf, uint32_t btr, uint32_t *br) {
+    (void)d;
+    handle_t *h = file;
+    uint32_t left = h->file->size - h->pos;
+    uint32_t n = btr < left ? btr : left;
+
+    lv_memcpy(buf, h->file->data + h->pos, n);
+    h->pos += n;
+    *br = n;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_seek(lv_fs_drv_t *d, void *file, uint32_t pos, lv_fs_whence_t whence) {
+    (void)d;
+    handle_t *h = file;
+    uint32_t base = whence == LV_FS_SEEK_CUR ? h->pos :
+                    whence == LV_FS_SEEK_END ? h->file->size : 0;
+    uint32_t to = base + pos;
+
+    if (to > h->file->size)
+        return LV_FS_RES_INV_PARAM;
+    h->pos = to;
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_tell(lv_fs_drv_t *d, void *file, uint32_t *pos) {
+    (void)d;
+    *pos = ((handle_t *)file)->pos;
+    return LV_FS_RES_OK;
+}
+
+/* Directories are implied by the paths; a listing is every file whose
+ * path starts with the directory, one level deep */
+typedef struct {
+    char dir[PORT_MODFS_PATH_MAX];
+    uint32_t next;
+} dir_t;
+
+static dir_t dir_handle SNAPSHOT_SKIP;
+static int dir_open SNAPSHOT_SKIP;
+
+static void *fs_dir_open(lv_fs_drv_t *d, const char *path) {
+    (void)d;
+    if (dir_open)
+        return NULL;
+    while (*path == '/')
+        path++;
+
+    uint32_t n = str_len(path, PORT_MODFS_PATH_MAX - 2);
+    lv_memcpy(dir_handle.dir, path, n);
+    if (n && path[n - 1] != '/')
+        dir_handle.dir[n++] = '/';
+    dir_handle.dir[n] = '\0';
+    dir_handle.next = 0;
+    dir_open = 1;
+    return &dir_handle;
+}
+
+static lv_fs_res_t fs_dir_read(lv_fs_drv_t *d, void *rddir, char *fn, uint32_t fn_len) {
+    (void)d;
+    dir_t *dir = rddir;
+    uint32_t dlen = str_len(dir->dir, PORT_MODFS_PATH_MAX);
+
+    fn[0] = '\0';
+    while (dir->next < file_count) {
+        const char *p = files[dir->next++].path;
+        uint32_t i = 0;
+        while (i < dlen && p[i] == dir->dir[i])
+            i++;
+        if (i < dlen)
+            continue;
+
+        /* Files in subdirectories are not listed here */
+        const char *rest = p + dlen;
+        uint32_t j = 0;
+        while (rest[j] && rest[j] != '/')
+            j++;
+        if (rest[j] == '/')
+            continue;
+
+        uint32_t n = j < fn_len - 1 ? j : fn_len - 1;
+        lv_memcpy(fn, rest, n);
+        fn[n] = '\0';
+        break;
+    }
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t fs_dir_close(lv_fs_drv_t *d, void *rddir) {
+    (void)d;
+    (void)rddir;
+    dir_open = 0;
+    return LV_FS_RES_OK;
+}
+
+/* Image decoder: the bin decoder is stubbed out (stdlib.c), and these
+ * images need no decoding anyway */
+
+static const file_t *image_of_src(const lv_image_decoder_dsc_t *dsc) {
+    if (dsc->src_type == LV_IMAGE_SRC_VARIABLE) {
+        for (uint32_t i = 0; i < file_count; i++) {
+            if (dsc->src == &files[i].img && files[i].is_image)
+                return &files[i];
+        }
+        return NULL;
+    }
+    if (dsc->src_type == LV_IMAGE_SRC_FILE) {
+        const char *path = dsc->src;
+        if (path[0] != PORT_MODFS_LETTER || path[1] != ':')
+            return NULL;
+        const file_t *f = find(path + 2);
+        return f && f->is_image ? f : NULL;
+    }
+    return NULL;
+}
+
+static lv_result_t decoder_info(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc,
+                                lv_image_header_t *header) {
+    (void)dec;
+    const file_t *f = image_of_src(dsc);
+    if (!f)
+        return LV_RESULT_INVALID;
+    *header = f->buf.header;
+    return LV_RESULT_OK;
+}
+
+static lv_result_t decoder_open(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc) {
+    (void)dec;
+    const file_t *f = image_of_src(dsc);
+    if (!f)
+        return LV_RESULT_INVALID;
+    dsc->decoded = &f->buf;
+    return LV_RESULT_OK;
+}
+
+void modfs_lvgl_init(void) {
+    lv_fs_drv_init(&drv);
+    drv.letter = PORT_MODFS_LETTER;
+    drv.open_cb = fs_open;
+    drv.close_cb = fs_close;
+    drv.read_cb = fs_read;
+    drv.seek_cb = fs_seek;
+    drv.tell_cb = fs_tell;
+    drv.dir_open_cb = fs_dir_open;
+    drv.dir_read_cb = fs_dir_read;
+    drv.dir_close_cb = fs_dir_close;
+    lv_fs_drv_register(&drv);
+
+    decoder = lv_image_decoder_create();
+    lv_image_decoder_set_info_cb(decoder, decoder_info);
+    lv_image_decoder_set_open_cb(decoder, decoder_open);
+}
+
+void modfs_dump(void) {
+    serial_printf("modfs: %u files in %u archives", (unsigned)file_count,
+                  (unsigned)archive_count);
+    if (skipped)
+        serial_printf(", %u skipped (raise PORT_MODFS_MAX_FILES/PATH_MAX)", (unsigned)skipped);
+    serial_puts("\n");
+
+    for (uint32_t i = 0; i < file_count; i++) {
+        const file_t *f = &files[i];
+        serial_printf("  %c:/%s %u bytes at 0x%08x", PORT_MODFS_LETTER, f->path,
+                      (unsigned)f->size, (unsigned)(uintptr_t)f->data);
+        if (f->is_image)
+            serial_printf(", image %ux%u cf %u", (unsigned)f->img.header.w,
+                          (unsigned)f->img.header.h, (unsigned)f->img.header.cf);
+        serial_puts("\n");
+    }
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef MODFS_H
+#define MODFS_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Read-only files from GRUB modules. Every module that is a ustar archive
+ * is indexed at boot; its files are served in place, without copies or
+ * heap, through the LVGL drive PORT_MODFS_LETTER ("M:/logo.bin") and
+ * modfs_map(). Files ending in ".bin" that start with an LVGL v9 image
+ * header are also images: modfs_image() returns an lv_image_dsc_t whose
+ * pixels point into the module, and a decoder registered here serves
+ * both that descriptor and "M:/..." paths without decoding anything.
+ * Paths are archive paths without a leading "./" or "/".
+ */
+#if PORT_MODFS
+/* Indexes the modules; call every boot, before snapshot_restore() */
+void modfs_init(void *mboot_info);
+/* Registers the drive and the image decoder; call once after lv_init() */
+void modfs_lvgl_init(void);
+/* Contents of a file and its size, NULL if there is no such file */
+const void *modfs_map(const char *path, uint32_t *size);
+/* NULL if path is not an uncompressed v9 image */
+const lv_image_dsc_t *modfs_image(const char *path);
+/* Lists the files on serial ('f' command) */
+void modfs_dump(void);
+#else
+static inline void modfs_init(void *mboot_info) { (void)mboot_info; }
+static inline void modfs_lvgl_init(void) {}
+static inline const void *modfs_map(const char *path, uint32_t *size) { (void)path; (void)size; return NULL; }
+static inline const lv_image_dsc_t *modfs_image(const char *path) { (void)path; return NULL; }
+static inline void modfs_dump(void) {}
+#endif
+
+#endif
@@ -0,0 +1,182 @@
+#include "pacer.h"
+
+#if PORT_PACER
+
+#include "lvgl/src/core/lv_refr_private.h"
+#include "lvgl/src/display/lv_display_private.h"
+#include "io.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "timer.h"
+#include "trace.h"
+#include "tsc.h"
+
+#define VGA_INPUT_STATUS_1  0x3DA
+#define VGA_VRETRACE        0x08
+
+/* Consecutive retrace timeouts after which vsync is turned off */
+#define VSYNC_GIVE_UP       3
+
+static uint32_t rate_hz = PORT_PACER_HZ;
+static int vsync_on = PORT_PACER_VSYNC;
+
+/* Deadlines are counted in PIT ticks, which start again from 0 on every
+ * boot, so the schedule is not part of a warm-boot snapshot */
+static int started SNAPSHOT_SKIP;
+static uint32_t base SNAPSHOT_SKIP;         /* Tick of deadline 0 */
+static uint32_t next SNAPSHOT_SKIP;         /* Index of the next deadline */
+static int vsync_pending SNAPSHOT_SKIP;     /* Frame running, no VRAM copy yet */
+static uint32_t vsync_misses SNAPSHOT_SKIP;
+static pacer_stats_t stats SNAPSHOT_SKIP;
+
+/* Deadline n, exact on average for rates that do not divide PORT_TIMER_HZ */
+static uint32_t deadline(uint32_t n) {
+    return base + (uint32_t)((uint64_t)n * PORT_TIMER_HZ / rate_hz);
+}
+
+static int reached(uint32_t now, uint32_t tick) {
+    return (int32_t)(now - tick) >= 0;
+}
+
+static void restart(uint32_t now) {
+    base = now;
+    next = 1;
+    started = 1;
+}
+
+/* Waits for the start of a vertical retrace; one already in progress is
+ * let go, since it may be about to end */
+static int wait_retrace(void) {
+    uint32_t start = timer_ticks();
+    uint32_t limit = 2 * PORT_TIMER_HZ / rate_hz + 1;
+
+    while (inb(VGA_INPUT_STATUS_1) & VGA_VRETRACE) {
+        if (timer_ticks() - start > limit)
+            return -1;
+    }
+    while (!(inb(VGA_INPUT_STATUS_1) & VGA_VRETRACE)) {
+        if (timer_ticks() - start > limit)
+            return -1;
+    }
+    return 0;
+}
+
+void pacer_before_flush(void) {
+    if (!vsync_pending)
+        return;
+    vsync_pending = 0;
+
+    uint64_t t0 = rdtsc();
+    int res = wait_retrace();
+    stats.vsync_wait_us += tsc_to_us(rdtsc() - t0, NULL);
+    stats.vsync_waits++;
+
+    if (res == 0) {
+        vsync_misses = 0;
+        return;
+    }
+    stats.vsync_timeouts++;
+    if (++vsync_misses == VSYNC_GIVE_UP) {
+        vsync_on = 0;
+        serial_puts("pacer: no vertical retrace on port 0x3DA, vsync off\n");
+    }
+}
+
+void pacer_poll(void) {
+    uint32_t now = timer_ticks();
+
+    if (!started) {
+        restart(now);
+        return;
+    }
+    if (!reached(now, deadline(next)))
+        return;
+
+    /* The latest deadline passed; any before it were not served in time */
+    uint32_t last = (uint32_t)((uint64_t)(now - base) * rate_hz / PORT_TIMER_HZ);
+    uint32_t skipped = last - next;
+    next = last + 1;
+
+    /* Animations step to the frame time, so run them before looking for
+     * changes */
+    lv_anim_refr_now();
+    lv_display_t *disp = lv_display_get_default();
+    if (!disp)
+        return;
+
+    /* Layout changes only invalidate areas once the layout has run, so run
+     * it now, as the refresh would, before deciding the frame is idle */
+    lv_obj_update_layout(disp->act_scr);
+    if (disp->prev_scr)
+        lv_obj_update_layout(disp->prev_scr);
+    lv_obj_update_layout(disp->bottom_layer);
+    lv_obj_update_layout(disp->top_layer);
+    lv_obj_update_layout(disp->sys_layer);
+    if (disp->inv_p == 0) {
+        stats.idle++;
+        return;
+    }
+    if (skipped) {
+        stats.dropped += skipped;
+        trace_counter("frames_dropped", (int32_t)stats.dropped);
+    }
+
+    uint64_t t0 = rdtsc();
+    vsync_pending = vsync_on;
+    lv_display_refr_timer(NULL);
+    vsync_pending = 0;
+    uint32_t us = (uint32_t)tsc_to_us(rdtsc() - t0, NULL);
+
+    stats.frames++;
+    stats.frame_total_us += us;
+    if (us > stats.frame_max_us)
+        stats.frame_max_us = us;
+    if (reached(timer_ticks(), deadline(next))) {
+        stats.missed++;
+        trace_instant("deadline_missed");
+    }
+}
+
+void pacer_init(void) {
+    lv_display_t *disp = lv_display_get_default();
+    if (disp)
+        lv_display_delete_refr_timer(disp);
+}
+
+void pacer_refresh_now(void) {
+    lv_anim_refr_now();
+    lv_display_refr_timer(NULL);
+}
+
+void pacer_set_rate(uint32_t hz) {
+    if (hz == 0)
+        hz = 1;
+    if (hz > PORT_TIMER_HZ)
+        hz = PORT_TIMER_HZ;
+    rate_hz = hz;
+    started = 0;
+}
+
+void pacer_set_vsync(int on) {
+    vsync_on = on;
+    vsync_misses = 0;
+}
+
+void pacer_get_stats(pacer_stats_t *out) {
+    *out = stats;
+    out->rate_hz = rate_hz;
+}
+
+void pacer_dump(void) {
+    serial_printf("pacer: %u Hz, vsync %s\n", (unsigned)rate_hz, vsync_on ? "on" : "off");
+    serial_printf("  frames %u, idle %u, missed %u, dropped %u\n", (unsigned)stats.frames,
+                  (unsigned)stats.idle, (unsigned)stats.missed, (unsigned)stats.dropped);
+    serial_printf("  frame avg %u us, max %u us\n",
+                  (unsigned)(stats.frames ? stats.frame_total_us / stats.frames : 0),
+                  (unsigned)stats.frame_max_us);
+    serial_printf("  vsync waits %u, avg %u us, timeouts %u\n", (unsigned)stats.vsync_waits,
+                  (unsigned)(stats.vsync_waits ? stats.vsync_wait_us / stats.vsync_waits : 0),
+                  (unsigned)stats.vsync_timeouts);
+}
+
+#endif
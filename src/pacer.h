@@ -0,0 +1,56 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Frame pacing. LVGL's own refresh timer is removed, and the display is
+ * refreshed at most once per deadline of a PORT_PACER_HZ clock taken from
+ * the PIT. Changes made between deadlines are drawn together in the next
+ * frame. A frame that overruns skips the deadlines it covered. Those are
+ * counted as dropped and their changes go into the following frame.
+ * With vsync on, each frame's first copy to VRAM waits for the start of
+ * the VGA vertical retrace (bit 3 of port 0x3DA).
+ */
+typedef struct {
+    uint32_t rate_hz;
+    uint32_t frames;        /* Refreshes run at a deadline */
+    uint32_t idle;          /* Deadlines with nothing to redraw */
+    uint32_t missed;        /* Frames still running at the next deadline */
+    uint32_t dropped;       /* Deadlines skipped with changes pending */
+    uint32_t frame_max_us;
+    uint64_t frame_total_us;
+    uint32_t vsync_waits;
+    uint32_t vsync_timeouts;    /* No retrace seen within two frame periods */
+    uint64_t vsync_wait_us;
+} pacer_stats_t;
+
+#if PORT_PACER
+/* Takes over refreshing the default display; call once after it exists */
+void pacer_init(void);
+/* Refreshes the display if a deadline has passed; call from the main loop */
+void pacer_poll(void);
+/* Refreshes right away, outside the schedule (lv_refr_now() no longer
+ * draws once the refresh timer is gone) */
+void pacer_refresh_now(void);
+void pacer_set_rate(uint32_t hz);
+void pacer_set_vsync(int on);
+/* Called by the flush callback before copying to VRAM */
+void pacer_before_flush(void);
+void pacer_get_stats(pacer_stats_t *stats);
+/* Prints the stats on serial ('v' command) */
+void pacer_dump(void);
+#else
+static inline void pacer_init(void) {}
+static inline void pacer_poll(void) {}
+static inline void pacer_refresh_now(void) { lv_refr_now(NULL); }
+static inline void pacer_set_rate(uint32_t hz) { (void)hz; }
+static inline void pacer_set_vsync(int on) { (void)on; }
+static inline void pacer_before_flush(void) {}
+static inline void pacer_get_stats(pacer_stats_t *stats) { *stats = (pacer_stats_t){ 0 }; }
+static inline void pacer_dump(void) {}
+#endif
+
+#endif
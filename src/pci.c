@@ -0,0 +1,73 @@
+#include "pci.h"
+#include "io.h"
+
+#define PCI_CONFIG_ADDRESS  0xCF8
+#define PCI_CONFIG_DATA     0xCFC
+
+static void select_reg(uint16_t bdf, uint8_t offset) {
+    outl(PCI_CONFIG_ADDRESS, 0x80000000u | (uint32_t)bdf << 8 | (offset & 0xFC));
+}
+
+uint32_t pci_read32(uint16_t bdf, uint8_t offset) {
+    select_reg(bdf, offset);
+    return inl(PCI_CONFIG_DATA);
+}
+
+void pci_write32(uint16_t bdf, uint8_t offset, uint32_t val) {
+    select_reg(bdf, offset);
+    outl(PCI_CONFIG_DATA, val);
+}
+
+uint8_t pci_read8(uint16_t bdf, uint8_t offset) {
+    return (uint8_t)(pci_read32(bdf, offset) >> ((offset & 3) * 8));
+}
+
+uint16_t pci_read16(uint16_t bdf, uint8_t offset) {
+    return (uint16_t)(pci_read32(bdf, offset) >> ((offset & 2) * 8));
+}
+
+/* Read-modify-write of the dword; writing back the other half is only
+ * safe for registers without write-1-to-clear bits next to them, which
+ * holds for the command register */
+void pci_write16(uint16_t bdf, uint8_t offset, uint16_t val) {
+    uint32_t shift = (offset & 2) * 8;
+    uint32_t v = pci_read32(bdf, offset);
+    v = (v & ~(0xFFFFu << shift)) | (uint32_t)val << shift;
+    pci_write32(bdf, offset, v);
+}
+
+int pci_find(uint16_t vendor, uint16_t device, uint16_t *bdf) {
+    uint32_t want = (uint32_t)device << 16 | vendor;
+
+    for (uint32_t bus = 0; bus < 256; bus++) {
+        for (uint32_t dev = 0; dev < 32; dev++) {
+            uint16_t f0 = (uint16_t)(bus << 8 | dev << 3);
+            uint32_t id = pci_read32(f0, 0);
+            if ((id & 0xFFFF) == 0xFFFF)
+                continue;
+            /* Header type bit 7: more than one function */
+            uint32_t funcs = (pci_read8(f0, 0x0E) & 0x80) ? 8 : 1;
+            for (uint32_t fn = 0; fn < funcs; fn++) {
+                uint16_t f = (uint16_t)(f0 | fn);
+                if (fn)
+                    id = pci_read32(f, 0);
+                if (id == want) {
+                    *bdf = f;
+                    return 0;
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+uint32_t pci_bar_address(uint16_t bdf, uint8_t bar) {
+    uint32_t lo = pci_read32(bdf, (uint8_t)(PCI_BAR0 + bar * 4));
+
+    if (lo & 1)
+        return 0;
+    /* Type 2: 64-bit, the high half is in the next BAR */
+    if (((lo >> 1) & 3) == 2 && pci_read32(bdf, (uint8_t)(PCI_BAR0 + bar * 4 + 4)))
+        return 0;
+    return lo & ~0xFu;
+}
@@ -0,0 +1,29 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+/*
+ * PCI configuration space through mechanism #1 (ports 0xCF8/0xCFC).
+ * A function is addressed as bus << 8 | device << 3 | function.
+ */
+#define PCI_COMMAND             0x04
+#define PCI_STATUS              0x06
+#define PCI_BAR0                0x10
+#define PCI_CAP_PTR             0x34
+
+#define PCI_COMMAND_MEMORY      0x0002
+#define PCI_COMMAND_MASTER      0x0004
+#define PCI_STATUS_CAP_LIST     0x0010
+
+uint32_t pci_read32(uint16_t bdf, uint8_t offset);
+void pci_write32(uint16_t bdf, uint8_t offset, uint32_t val);
+uint8_t pci_read8(uint16_t bdf, uint8_t offset);
+uint16_t pci_read16(uint16_t bdf, uint8_t offset);
+void pci_write16(uint16_t bdf, uint8_t offset, uint16_t val);
+/* First function with this vendor and device ID; 0 if found */
+int pci_find(uint16_t vendor, uint16_t device, uint16_t *bdf);
+/* Address of a memory BAR, 0 if it is an I/O BAR or above 4 GB */
+uint32_t pci_bar_address(uint16_t bdf, uint8_t bar);
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef PORT_CONF_H
+#define PORT_CONF_H
+
+/* Build-time configuration of the port layer (the lv_conf.h of the kernel
+ * side). Every option can be overridden with -D on the command line. */
+
+/* COM1, used for diagnostics output and commands */
+#ifndef PORT_SERIAL_BAUD
+#define PORT_SERIAL_BAUD 115200
+#endif
+
+/* Boot/frame timeline tracing (trace.c), dumped as Chrome trace JSON */
+#ifndef PORT_TRACE
+#define PORT_TRACE 1
+#endif
+/* Events recorded before the first frame are kept in their own buffer so
+ * the frame loop can never overwrite the boot timeline */
+#ifndef PORT_TRACE_BOOT_EVENTS
+#define PORT_TRACE_BOOT_EVENTS 256
+#endif
+#ifndef PORT_TRACE_RING_EVENTS
+#define PORT_TRACE_RING_EVENTS 2048
+#endif
+
+/* PIT channel 0 interrupt rate (timer.c); sampling rates divide it */
+#ifndef PORT_TIMER_HZ
+#define PORT_TIMER_HZ 1000
+#endif
+
+/* Sampling profiler (prof.c) */
+#ifndef PORT_PROF
+#define PORT_PROF 1
+#endif
+#ifndef PORT_PROF_HZ
+#define PORT_PROF_HZ 1000
+#endif
+/* Distinct sampled EIPs kept in the histogram */
+#ifndef PORT_PROF_SLOTS
+#define PORT_PROF_SLOTS 4096
+#endif
+/* Caller frames recorded per sample, 0 disables folded stacks. Frames are
+ * only meaningful when built with FRAME_POINTERS=1 */
+#ifndef PORT_PROF_STACK_DEPTH
+#define PORT_PROF_STACK_DEPTH 4
+#endif
+#ifndef PORT_PROF_STACK_SLOTS
+#define PORT_PROF_STACK_SLOTS 1024
+#endif
+/* Functions printed in the flat profile */
+#ifndef PORT_PROF_TOP
+#define PORT_PROF_TOP 40
+#endif
+
+/* Per-widget render cost attribution (widget_stats.c). Off by default:
+ * every object gets an LV_EVENT_ALL callback and draw task events. */
+#ifndef PORT_WIDGET_STATS
+#define PORT_WIDGET_STATS 0
+#endif
+/* Objects tracked at once; must be a power of two */
+#ifndef PORT_WIDGET_STATS_SLOTS
+#define PORT_WIDGET_STATS_SLOTS 256
+#endif
+#ifndef PORT_WIDGET_STATS_TOP
+#define PORT_WIDGET_STATS_TOP 20
+#endif
+
+/* Kernel heap in stdlib.c, backing malloc and lv_malloc */
+#ifndef PORT_HEAP_SIZE
+#define PORT_HEAP_SIZE (96 * 1024)
+#endif
+/* Tag every block with the address of the code that allocated it and keep
+ * per-call-site totals (8 bytes of header are reserved either way) */
+#ifndef PORT_MEM_CALLSITES
+#define PORT_MEM_CALLSITES 0
+#endif
+#ifndef PORT_MEM_CALLSITE_SLOTS
+#define PORT_MEM_CALLSITE_SLOTS 128
+#endif
+/* Frames to walk up from lv_malloc_core/malloc: 1 skips LVGL's lv_malloc
+ * wrapper. Walking needs frame pointers (make FRAME_POINTERS=1) */
+#ifndef PORT_MEM_CALLSITE_DEPTH
+#define PORT_MEM_CALLSITE_DEPTH 1
+#endif
+/* Rows printed by the 'M' serial command */
+#ifndef PORT_MEM_CALLSITE_TOP
+#define PORT_MEM_CALLSITE_TOP 20
+#endif
+/* LVGL's memory overlay in the bottom-left corner (LV_USE_SYSMON and
+ * LV_USE_MEM_MONITOR). It is redrawn every second, which shows up in
+ * frame timings and heap traffic, so it is for debugging only. */
+#ifndef PORT_MEM_OVERLAY
+#define PORT_MEM_OVERLAY 0
+#endif
+
+/* Stacks reserved in boot.S. Both are painted at boot so the 's' serial
+ * command can report how deep they have actually grown */
+#ifndef PORT_MAIN_STACK_SIZE
+#define PORT_MAIN_STACK_SIZE (64 * 1024)
+#endif
+/* Interrupt handlers switch to their own stack; 0 runs them on whatever
+ * stack was interrupted, which then needs headroom for the deepest IRQ */
+#ifndef PORT_IRQ_STACK_SIZE
+#define PORT_IRQ_STACK_SIZE (8 * 1024)
+#endif
+/* Page-aligned 4 KiB guard below each stack. There is no paging yet, so it
+ * is painted and checked from the main loop instead of being unmapped */
+#ifndef PORT_STACK_GUARD
+#define PORT_STACK_GUARD 1
+#endif
+
+/* Scroll fast path (scroll_accel.c): on a pure scroll, move the pixels
+ * already in the framebuffer and only render the newly exposed strip */
+#ifndef PORT_SCROLL_ACCEL
+#define PORT_SCROLL_ACCEL 1
+#endif
+/* Scrollable objects that can be attached at the same time */
+#ifndef PORT_SCROLL_ACCEL_SLOTS
+#define PORT_SCROLL_ACCEL_SLOTS 4
+#endif
+
+/* Warm boot (snapshot.c): restore a snapshot module built from this exact
+ * kernel instead of running LVGL init and UI construction */
+#ifndef PORT_SNAPSHOT
+#define PORT_SNAPSHOT 1
+#endif
+
+/* Retained layers (layer_cache.c): attached subtrees are drawn from a
+ * bitmap while unchanged. The arena is the memory budget for all bitmaps;
+ * it is separate from the heap and not part of a warm-boot snapshot */
+#ifndef PORT_LAYER_CACHE
+#define PORT_LAYER_CACHE 1
+#endif
+/* About five rows of the 640-pixel demo list: the focused row and the
+ * neighbours its outline overlaps */
+#ifndef PORT_LAYER_CACHE_SIZE
+#define PORT_LAYER_CACHE_SIZE (512 * 1024)
+#endif
+/* Objects that can be attached at the same time */
+#ifndef PORT_LAYER_CACHE_SLOTS
+#define PORT_LAYER_CACHE_SLOTS 32
+#endif
+
+/* SIMD blend kernels (blend_sw.c) behind LVGL's LV_DRAW_SW_ASM_CUSTOM
+ * hooks, picked at boot from CPUID: AVX2, else SSE2, else LVGL's C loops */
+#ifndef PORT_BLEND_SW
+#define PORT_BLEND_SW 1
+#endif
+
+/* Pre-blended glyphs (glyph_cache.c): label text on a solid background
+ * is copied from a ring of blended glyph boxes instead of blended again */
+#ifndef PORT_GLYPH_CACHE
+#define PORT_GLYPH_CACHE 1
+#endif
+#ifndef PORT_GLYPH_CACHE_SIZE
+#define PORT_GLYPH_CACHE_SIZE (128 * 1024)
+#endif
+/* Glyphs tracked at once, a multiple of 4 (4-way sets) */
+#ifndef PORT_GLYPH_CACHE_ENTRIES
+#define PORT_GLYPH_CACHE_ENTRIES 512
+#endif
+
+/* Log console (console.c): a fixed grid of character cells drawn from a
+ * glyph atlas. The buffer holds the atlas and the grid's pixels, e.g.
+ * 80x30 cells of lv_font_unscii_8 take about 625 KiB. The demo only uses
+ * it for the 'L' flood, so it is off by default. */
+#ifndef PORT_CONSOLE
+#define PORT_CONSOLE 0
+#endif
+#ifndef PORT_CONSOLE_COLS
+#define PORT_CONSOLE_COLS 80
+#endif
+#ifndef PORT_CONSOLE_ROWS
+#define PORT_CONSOLE_ROWS 30
+#endif
+#ifndef PORT_CONSOLE_BUF_SIZE
+#define PORT_CONSOLE_BUF_SIZE (640 * 1024)
+#endif
+/* Lines per millisecond the 'L' flood writes */
+#ifndef PORT_CONSOLE_FLOOD_LINES
+#define PORT_CONSOLE_FLOOD_LINES 4
+#endif
+
+/* Read-only files from ustar archives loaded as GRUB modules (modfs.c),
+ * served in place as LVGL drive PORT_MODFS_LETTER */
+#ifndef PORT_MODFS
+#define PORT_MODFS 1
+#endif
+#ifndef PORT_MODFS_LETTER
+#define PORT_MODFS_LETTER 'M'
+#endif
+/* Files indexed across all archives */
+#ifndef PORT_MODFS_MAX_FILES
+#define PORT_MODFS_MAX_FILES 64
+#endif
+/* Longest archive path, including the terminator */
+#ifndef PORT_MODFS_PATH_MAX
+#define PORT_MODFS_PATH_MAX 64
+#endif
+/* Files open at the same time through lv_fs */
+#ifndef PORT_MODFS_FILES
+#define PORT_MODFS_FILES 4
+#endif
+
+/* Tiled RLE images from image-pack.py (tiled_image.c), decoded per tile
+ * into an LRU cache of PORT_TILED_IMAGE_CACHE_SIZE bytes */
+#ifndef PORT_TILED_IMAGE
+#define PORT_TILED_IMAGE PORT_MODFS
+#endif
+/* 20 tiles: two rows of tiles across a 640-pixel screen, which covers a
+ * redrawn list row at any offset */
+#ifndef PORT_TILED_IMAGE_CACHE_SIZE
+#define PORT_TILED_IMAGE_CACHE_SIZE (20 * 64 * 64 * 4)
+#endif
+/* Largest tile in bytes; the default fits image-pack.py's 64x64 tiles */
+#ifndef PORT_TILED_IMAGE_TILE_BYTES
+#define PORT_TILED_IMAGE_TILE_BYTES (64 * 64 * 4)
+#endif
+
+/* Display refreshes paced by the PIT instead of LVGL's refresh timer
+ * (pacer.c); PORT_PACER_HZ must not exceed PORT_TIMER_HZ */
+#ifndef PORT_PACER
+#define PORT_PACER 1
+#endif
+#ifndef PORT_PACER_HZ
+#define PORT_PACER_HZ 60
+#endif
+/* Start each frame's VRAM copies at a VGA vertical retrace */
+#ifndef PORT_PACER_VSYNC
+#define PORT_PACER_VSYNC 1
+#endif
+
+/* Flushed areas RLE-encoded onto a second UART for remote-view.py
+ * (remote.c); off at run time when no UART answers there. make
+ * run-remote turns it on. */
+#ifndef PORT_REMOTE
+#define PORT_REMOTE 0
+#endif
+#ifndef PORT_REMOTE_UART
+#define PORT_REMOTE_UART 0x2F8
+#endif
+#ifndef PORT_REMOTE_IRQ
+#define PORT_REMOTE_IRQ 3
+#endif
+#ifndef PORT_REMOTE_BAUD
+#define PORT_REMOTE_BAUD 115200
+#endif
+/* Encoded bytes waiting for the UART; a power of two. 64 KiB is about
+ * 5 s of line time at 115200 baud; areas that do not fit are resent. */
+#ifndef PORT_REMOTE_RING
+#define PORT_REMOTE_RING (64 * 1024)
+#endif
+
+/* Framebuffer hashes on virtual time for golden-image tests (capture.c) */
+#ifndef PORT_CAPTURE
+#define PORT_CAPTURE 1
+#endif
+
+/* Keys recorded on serial and replayed from a module (replay.c) */
+#ifndef PORT_REPLAY
+#define PORT_REPLAY 1
+#endif
+/* Longest recording a replay holds, in key events */
+#ifndef PORT_REPLAY_EVENTS
+#define PORT_REPLAY_EVENTS 4096
+#endif
+
+/* virtio-gpu 2D display backend (virtio_gpu.c), used when the kernel
+ * command line has display=virtio; the mode is fixed at build time. Off
+ * by default: its screen buffer is ~1.2 MiB of bss. make run-virtio
+ * turns it on. */
+#ifndef PORT_VIRTIO_GPU
+#define PORT_VIRTIO_GPU 0
+#endif
+#ifndef PORT_VIRTIO_GPU_WIDTH
+#define PORT_VIRTIO_GPU_WIDTH 640
+#endif
+#ifndef PORT_VIRTIO_GPU_HEIGHT
+#define PORT_VIRTIO_GPU_HEIGHT 480
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+#include "prof.h"
+
+#if PORT_PROF
+
+#include <stddef.h>
+#include "ksyms.h"
+#include "serial.h"
+#include "timer.h"
+
+#define PROBE_LIMIT 16
+
+typedef struct {
+    uint32_t eip;
+    uint32_t count;
+} prof_slot_t;
+
+typedef struct {
+    uint32_t frames[PORT_PROF_STACK_DEPTH + 1];     /* [0] = sampled EIP */
+    uint32_t count;
+} prof_stack_t;
+
+/* Per-function totals, built at dump time */
+typedef struct {
+    uint32_t start;
+    const char *name;
+    uint32_t count;
+} prof_func_t;
+
+extern uint8_t stack_bottom[];
+extern uint8_t stack_top[];
+
+void *memset(void *s, int c, size_t n);
+
+static prof_slot_t slots[PORT_PROF_SLOTS];
+static prof_func_t funcs[PORT_PROF_SLOTS];
+#if PORT_PROF_STACK_DEPTH > 0
+static prof_stack_t stacks[PORT_PROF_STACK_SLOTS];
+#endif
+
+static volatile int running;
+static uint32_t samples;
+static uint32_t dropped;
+
+static inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    return x;
+}
+
+static void record_eip(uint32_t eip) {
+    uint32_t h = hash32(eip);
+
+    for (uint32_t i = 0; i < PROBE_LIMIT; i++) {
+        prof_slot_t *s = &slots[(h + i) % PORT_PROF_SLOTS];
+        if (s->eip == eip || s->count == 0) {
+            s->eip = eip;
+            s->count++;
+            return;
+        }
+    }
+    dropped++;
+}
+
+#if PORT_PROF_STACK_DEPTH > 0
+static void record_stack(irq_frame_t *frame) {
+    uint32_t frames[PORT_PROF_STACK_DEPTH + 1] = { 0 };
+    uint32_t ebp = frame->ebp;
+    uint32_t h = hash32(frame->eip);
+
+    frames[0] = frame->eip;
+    for (int d = 1; d <= PORT_PROF_STACK_DEPTH; d++) {
+        /* Only follow frame pointers that stay inside the boot stack and
+         * move towards its top */
+        if (ebp < (uint32_t)stack_bottom || ebp > (uint32_t)stack_top - 8 || (ebp & 3))
+            break;
+        const uint32_t *fp = (const uint32_t *)ebp;
+        frames[d] = fp[1];
+        h = hash32(h ^ fp[1]);
+        if (fp[0] <= ebp)
+            break;
+        ebp = fp[0];
+    }
+
+    for (uint32_t i = 0; i < PROBE_LIMIT; i++) {
+        prof_stack_t *s = &stacks[(h + i) % PORT_PROF_STACK_SLOTS];
+        int same = 1;
+        for (int d = 0; d <= PORT_PROF_STACK_DEPTH; d++)
+            same &= s->frames[d] == frames[d];
+        if (same || s->count == 0) {
+            for (int d = 0; d <= PORT_PROF_STACK_DEPTH; d++)
+                s->frames[d] = frames[d];
+            s->count++;
+            return;
+        }
+    }
+    dropped++;
+}
+#endif
+
+static void prof_sample(irq_frame_t *frame) {
+    samples++;
+    record_eip(frame->eip);
+#if PORT_PROF_STACK_DEPTH > 0
+    record_stack(frame);
+#endif
+}
+
+void prof_start(void) {
+    prof_stop();
+
+    memset(slots, 0, sizeof(slots));
+#if PORT_PROF_STACK_DEPTH > 0
+    memset(stacks, 0, sizeof(stacks));
+#endif
+    samples = 0;
+    dropped = 0;
+
+    running = 1;
+    timer_add_callback(prof_sample, PORT_TIMER_HZ / PORT_PROF_HZ);
+}
+
+void prof_stop(void) {
+    timer_remove_callback(prof_sample);
+    running = 0;
+}
+
+int prof_running(void) {
+    return running;
+}
+
+static void print_symbol(uint32_t addr) {
+    const char *name = ksyms_lookup(addr, NULL);
+    if (name)
+        serial_puts(name);
+    else
+        serial_printf("0x%08x", (unsigned)addr);
+}
+
+static void dump_flat(void) {
+    uint32_t nfuncs = 0;
+
+    /* Fold EIPs into their containing functions */
+    for (uint32_t i = 0; i < PORT_PROF_SLOTS; i++) {
+        if (!slots[i].count)
+            continue;
+
+        uint32_t offset = 0;
+        const char *name = ksyms_lookup(slots[i].eip, &offset);
+        uint32_t start = name ? slots[i].eip - offset : slots[i].eip;
+
+        uint32_t f;
+        for (f = 0; f < nfuncs; f++) {
+            if (funcs[f].start == start)
+                break;
+        }
+        if (f == nfuncs) {
+            funcs[nfuncs].start = start;
+            funcs[nfuncs].name = name;
+            funcs[nfuncs].count = 0;
+            nfuncs++;
+        }
+        funcs[f].count += slots[i].count;
+    }
+
+    serial_printf("# flat profile: %u samples at %u Hz, %u dropped\n",
+                  (unsigned)samples, (unsigned)PORT_PROF_HZ, (unsigned)dropped);
+    serial_puts("# samples      %  function\n");
+
+    /* Partial selection sort, only the top entries are printed */
+    for (uint32_t n = 0; n < PORT_PROF_TOP && n < nfuncs; n++) {
+        uint32_t best = n;
+        for (uint32_t f = n + 1; f < nfuncs; f++) {
+            if (funcs[f].count > funcs[best].count)
+                best = f;
+        }
+        prof_func_t tmp = funcs[n];
+        funcs[n] = funcs[best];
+        funcs[best] = tmp;
+
+        uint32_t permille = samples ? (uint32_t)((uint64_t)funcs[n].count * 1000 / samples) : 0;
+        serial_printf("%9u %3u.%u%%  ", (unsigned)funcs[n].count,
+                      (unsigned)(permille / 10), (unsigned)(permille % 10));
+        if (funcs[n].name)
+            serial_puts(funcs[n].name);
+        else
+            serial_printf("0x%08x", (unsigned)funcs[n].start);
+        serial_putc('\n');
+    }
+}
+
+#if PORT_PROF_STACK_DEPTH > 0
+static void dump_folded(void) {
+    serial_puts("# folded stacks\n");
+
+    for (uint32_t i = 0; i < PORT_PROF_STACK_SLOTS; i++) {
+        const prof_stack_t *s = &stacks[i];
+        if (!s->count)
+            continue;
+
+        /* Outermost caller first; return addresses point past the call */
+        int depth = PORT_PROF_STACK_DEPTH;
+        while (depth > 0 && !s->frames[depth])
+            depth--;
+        for (int d = depth; d > 0; d--) {
+            print_symbol(s->frames[d] - 1);
+            serial_putc(';');
+        }
+        print_symbol(s->frames[0]);
+        serial_printf(" %u\n", (unsigned)s->count);
+    }
+}
+#endif
+
+void prof_dump(void) {
+    int was_running = running;
+    prof_stop();
+
+    serial_puts("\n# --- profile ---\n");
+    dump_flat();
+#if PORT_PROF_STACK_DEPTH > 0
+    dump_folded();
+#endif
+    serial_puts("# --- end ---\n");
+
+    if (was_running) {
+        running = 1;
+        timer_add_callback(prof_sample, PORT_TIMER_HZ / PORT_PROF_HZ);
+    }
+}
+
+#endif
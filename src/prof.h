@@ -0,0 +1,26 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include "port_conf.h"
+
+/*
+ * Statistical profiler: samples the interrupted EIP (and, with
+ * PORT_PROF_STACK_DEPTH, a frame-pointer backtrace) from the PIT interrupt
+ * and symbolizes on target from the multiboot ELF symbols (ksyms.c).
+ */
+#if PORT_PROF
+/* Clears the histograms and starts sampling at PORT_PROF_HZ */
+void prof_start(void);
+void prof_stop(void);
+int prof_running(void);
+/* Flat profile followed by folded stacks (flamegraph.pl / speedscope
+ * input), written to the serial port */
+void prof_dump(void);
+#else
+static inline void prof_start(void) {}
+static inline void prof_stop(void) {}
+static inline int prof_running(void) { return 0; }
+static inline void prof_dump(void) {}
+#endif
+
+#endif
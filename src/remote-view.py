@@ -0,0 +1,148 @@
+import os
+import socket
+import struct
+import sys
+
+# Rebuilds the screen from the remote display stream (remote.c).
+#
+# Usage: python3 remote-view.py SOURCE screen.ppm
+#
+# SOURCE is a capture file (QEMU -serial file:remote.bin), "-" for stdin,
+# or tcp:HOST:PORT (make run-remote). The picture is written to the PPM
+# file after every frame, through a rename, so an image viewer that
+# reloads on change shows the screen live. Over TCP the viewer first asks
+# for the whole screen, so it can join a running kernel. One line per
+# frame gives its number and size on the wire.
+
+
+class Screen:
+    def __init__(self):
+        self.w = self.h = 0
+        self.px = bytearray()
+
+    def resize(self, w, h):
+        if (w, h) != (self.w, self.h):
+            self.w, self.h = w, h
+            self.px = bytearray(w * h * 3)
+
+    def rect(self, x, y, w, h, data):
+        row = bytearray(w * 3)
+        prev = None
+        pos = 0
+        for r in range(h):
+            i = 0
+            while i < w:
+                code = data[pos]
+                pos += 1
+                n = (code & 0x7F if code < 0x80 else code & 0x3F) + 1
+                if code < 0x80:
+                    row[i * 3:(i + n) * 3] = data[pos:pos + n * 3]
+                    pos += n * 3
+                elif code < 0xC0:
+                    row[i * 3:(i + n) * 3] = data[pos:pos + 3] * n
+                    pos += 3
+                else:
+                    row[i * 3:(i + n) * 3] = prev[i * 3:(i + n) * 3]
+                i += n
+            self.put_row(x, y + r, row)
+            prev = bytearray(row)
+
+    def put_row(self, x, y, row):
+        if not 0 <= y < self.h:
+            return
+        n = min(len(row) // 3, self.w - x)
+        if n > 0:
+            o = (y * self.w + x) * 3
+            self.px[o:o + n * 3] = row[:n * 3]
+
+    def move(self, x, y, w, h, dx, dy):
+        # Same clipping as fb_move() in fb.c
+        x1, x2, y1, y2 = x, x + w, y, y + h
+        x1 = max(x1, 0, -dx)
+        x2 = min(x2, self.w, self.w - dx)
+        y1 = max(y1, 0, -dy)
+        y2 = min(y2, self.h, self.h - dy)
+        if x2 <= x1 or y2 <= y1:
+            return
+        rows = [self.px[(r * self.w + x1) * 3:(r * self.w + x2) * 3] for r in range(y1, y2)]
+        for r, data in zip(range(y1 + dy, y2 + dy), rows):
+            o = (r * self.w + x1 + dx) * 3
+            self.px[o:o + len(data)] = data
+
+    def save(self, path):
+        out = bytearray(len(self.px))
+        out[0::3] = self.px[2::3]   # B G R on the wire, R G B in a PPM
+        out[1::3] = self.px[1::3]
+        out[2::3] = self.px[0::3]
+        tmp = path + ".tmp"
+        with open(tmp, "wb") as f:
+            f.write(b"P6 %d %d 255\n" % (self.w, self.h))
+            f.write(out)
+        os.replace(tmp, path)
+
+
+def open_source(name):
+    if name == "-":
+        return sys.stdin.buffer.read1, None
+    if name.startswith("tcp:"):
+        _, host, port = name.split(":")
+        sock = socket.create_connection((host, int(port)))
+        sock.sendall(b"K")
+        return lambda n: sock.recv(n), sock
+    f = open(name, "rb")
+    return f.read1, f
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: remote-view.py SOURCE screen.ppm")
+    read, _ = open_source(sys.argv[1])
+    out = sys.argv[2]
+    screen = Screen()
+    buf = bytearray()
+    sizes = {ord("I"): 4, ord("M"): 12, ord("E"): 8, ord("R"): 12}
+
+    while True:
+        chunk = read(65536)
+        if not chunk:
+            break
+        buf += chunk
+        while True:
+            # Skip to the next message; a capture may start mid-stream
+            start = buf.find(b"\xa5\x5a")
+            if start < 0:
+                del buf[:max(len(buf) - 1, 0)]
+                break
+            del buf[:start]
+            if len(buf) < 3:
+                break
+            kind = buf[2]
+            if kind not in sizes:
+                del buf[:2]
+                continue
+            if len(buf) < 3 + sizes[kind]:
+                break
+            if kind == ord("R"):
+                x, y, w, h, length = struct.unpack_from("<HHHHI", buf, 3)
+                if len(buf) < 15 + length:
+                    break
+                if screen.w:
+                    screen.rect(x, y, w, h, buf[15:15 + length])
+                del buf[:15 + length]
+            elif kind == ord("I"):
+                screen.resize(*struct.unpack_from("<HH", buf, 3))
+                del buf[:7]
+            elif kind == ord("M"):
+                if screen.w:
+                    screen.move(*struct.unpack_from("<hhhhhh", buf, 3))
+                del buf[:15]
+            else:
+                frame, size = struct.unpack_from("<II", buf, 3)
+                del buf[:11]
+                if screen.w:
+                    screen.save(out)
+                print(f"frame {frame}: {size} bytes", flush=True)
+
+
+if __name__ == "__main__":
+    main()
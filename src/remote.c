@@ -0,0 +1,372 @@
+#include "remote.h"
+
+#if PORT_REMOTE
+
+#include "idt.h"
+#include "io.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "tsc.h"
+#include "vbe.h"
+
+#define UART_DATA   0
+#define UART_IER    1
+#define UART_IIR    2
+#define UART_FCR    2
+#define UART_LCR    3
+#define UART_MCR    4
+#define UART_LSR    5
+#define UART_SCR    7
+
+#define IER_THRE        0x02
+#define LSR_DATA_READY  0x01
+#define LSR_THR_EMPTY   0x20
+#define MCR_OUT2        0x08    /* Gates the UART's interrupt line on PCs */
+#define FIFO_BYTES      16
+
+#define RING_MASK   (PORT_REMOTE_RING - 1)
+#define MSG_RECT    15          /* Header bytes of an 'R' message */
+#define MAX_CODE    (1 + 128 * 3)
+/* Rows per rect when resending from VRAM, so a big area goes out in
+ * pieces as the ring drains */
+#define RESEND_ROWS 16
+
+_Static_assert((PORT_REMOTE_RING & RING_MASK) == 0, "PORT_REMOTE_RING must be a power of two");
+
+#define BASE PORT_REMOTE_UART
+
+/* The stream and the UART are per boot; a warm boot starts over */
+static uint8_t ring[PORT_REMOTE_RING] SNAPSHOT_SKIP;
+static volatile uint32_t head SNAPSHOT_SKIP;    /* Bytes queued, free-running */
+static volatile uint32_t tail SNAPSHOT_SKIP;    /* Bytes sent */
+static int present SNAPSHOT_SKIP;
+static lv_area_t backlog SNAPSHOT_SKIP;         /* Screen area the viewer may have wrong */
+static int backlog_valid SNAPSHOT_SKIP;
+static uint32_t frame_no SNAPSHOT_SKIP;
+static uint32_t frame_bytes SNAPSHOT_SKIP;
+static uint32_t frame_us SNAPSHOT_SKIP;
+static remote_stats_t stats SNAPSHOT_SKIP;
+
+static void uart_irq(irq_frame_t *frame) {
+    (void)frame;
+    (void)inb(BASE + UART_IIR);
+
+    if (inb(BASE + UART_LSR) & LSR_THR_EMPTY) {
+        uint32_t t = tail;
+        for (int i = 0; i < FIFO_BYTES && t != head; i++)
+            outb(BASE + UART_DATA, ring[t++ & RING_MASK]);
+        tail = t;
+    }
+    if (tail == head)
+        outb(BASE + UART_IER, 0);
+}
+
+static int room(uint32_t pos, uint32_t n) {
+    return pos + n - tail <= PORT_REMOTE_RING;
+}
+
+static void put8(uint32_t *pos, uint32_t v) {
+    ring[(*pos)++ & RING_MASK] = (uint8_t)v;
+}
+
+static void put16(uint32_t *pos, uint32_t v) {
+    put8(pos, v);
+    put8(pos, v >> 8);
+}
+
+static void put32(uint32_t *pos, uint32_t v) {
+    put16(pos, v);
+    put16(pos, v >> 16);
+}
+
+static void put_px(uint32_t *pos, uint32_t px) {
+    put8(pos, px);
+    put8(pos, px >> 8);
+    put8(pos, px >> 16);
+}
+
+static void put_header(uint32_t *pos, char type) {
+    put8(pos, 0xA5);
+    put8(pos, 0x5A);
+    put8(pos, (uint8_t)type);
+}
+
+/* Makes the bytes up to pos visible to the interrupt handler and wakes
+ * it up; an interrupt that finds the ring empty turns itself off again */
+static void publish(uint32_t pos) {
+    uint32_t n = pos - head;
+
+    asm volatile ("" ::: "memory");
+    head = pos;
+    outb(BASE + UART_IER, IER_THRE);
+
+    stats.bytes += n;
+    frame_bytes += n;
+    if (pos - tail > stats.ring_peak)
+        stats.ring_peak = pos - tail;
+}
+
+#define SAME(a, b) ((((a) ^ (b)) & 0xFFFFFF) == 0)
+
+/* One 'R' message for w x h pixels at src (stride in pixels); 0 if the
+ * ring had no room, in which case nothing is queued */
+static int put_rect(int32_t x, int32_t y, int32_t w, int32_t h, const uint32_t *src,
+                    uint32_t stride) {
+    uint32_t pos = head;
+
+    if (!room(pos, MSG_RECT))
+        return 0;
+    put_header(&pos, 'R');
+    put16(&pos, (uint32_t)x);
+    put16(&pos, (uint32_t)y);
+    put16(&pos, (uint32_t)w);
+    put16(&pos, (uint32_t)h);
+    uint32_t len_pos = pos;
+    pos += 4;
+
+    for (int32_t r = 0; r < h; r++) {
+        const uint32_t *row = src + r * stride;
+        const uint32_t *up = r ? row - stride : NULL;
+        int32_t i = 0;
+
+        while (i < w) {
+            if (!room(pos, MAX_CODE))
+                return 0;
+
+            /* A copy from the row above is one byte and a run four, so
+             * the copy wins ties */
+            int32_t a = 0;
+            if (up) {
+                while (i + a < w && a < 64 && SAME(row[i + a], up[i + a]))
+                    a++;
+            }
+            int32_t n = 1;
+            while (i + n < w && n < 64 && SAME(row[i + n], row[i]))
+                n++;
+            if (a >= 2 && a >= n) {
+                put8(&pos, 0xC0 | (a - 1));
+                i += a;
+                continue;
+            }
+            if (n >= 2) {
+                put8(&pos, 0x80 | (n - 1));
+                put_px(&pos, row[i]);
+                i += n;
+                continue;
+            }
+
+            /* Literals up to where a run or a copy of 2+ pixels starts */
+            n = 1;
+            while (i + n < w && n < 128) {
+                int32_t j = i + n;
+                if (j + 1 < w && (SAME(row[j], row[j + 1]) ||
+                                  (up && SAME(row[j], up[j]) && SAME(row[j + 1], up[j + 1]))))
+                    break;
+                n++;
+            }
+            put8(&pos, n - 1);
+            for (int32_t k = 0; k < n; k++)
+                put_px(&pos, row[i + k]);
+            i += n;
+        }
+    }
+
+    uint32_t len = pos - len_pos - 4;
+    put32(&len_pos, len);
+    publish(pos);
+    stats.rects++;
+    stats.raw_bytes += (uint64_t)w * h * 4;
+    return 1;
+}
+
+static void backlog_add(const lv_area_t *a) {
+    vbe_info_t *vbe = vbe_get_info();
+    lv_area_t c = {
+        LV_MAX(a->x1, 0), LV_MAX(a->y1, 0),
+        LV_MIN(a->x2, (int32_t)vbe->width - 1), LV_MIN(a->y2, (int32_t)vbe->height - 1),
+    };
+
+    if (c.x1 > c.x2 || c.y1 > c.y2)
+        return;
+    if (!backlog_valid) {
+        backlog = c;
+        backlog_valid = 1;
+        return;
+    }
+    backlog.x1 = LV_MIN(backlog.x1, c.x1);
+    backlog.y1 = LV_MIN(backlog.y1, c.y1);
+    backlog.x2 = LV_MAX(backlog.x2, c.x2);
+    backlog.y2 = LV_MAX(backlog.y2, c.y2);
+}
+
+/* Sends the backlog from VRAM, a band at a time, until the ring fills */
+static void resend(void) {
+    vbe_info_t *vbe = vbe_get_info();
+    uint32_t stride = vbe->pitch / 4;
+
+    while (backlog_valid) {
+        int32_t w = lv_area_get_width(&backlog);
+        int32_t h = LV_MIN(lv_area_get_height(&backlog), RESEND_ROWS);
+        const uint32_t *src = vbe->framebuffer + backlog.y1 * stride + backlog.x1;
+
+        if (!put_rect(backlog.x1, backlog.y1, w, h, src, stride))
+            return;
+        stats.resends++;
+        backlog.y1 += h;
+        if (backlog.y1 > backlog.y2)
+            backlog_valid = 0;
+    }
+}
+
+static void put_info(void) {
+    vbe_info_t *vbe = vbe_get_info();
+    uint32_t pos = head;
+
+    if (!room(pos, 7))
+        return;
+    put_header(&pos, 'I');
+    put16(&pos, vbe->width);
+    put16(&pos, vbe->height);
+    publish(pos);
+}
+
+static void end_frame(void) {
+    uint32_t pos = head;
+
+    if (!room(pos, 11))
+        return;
+    put_header(&pos, 'E');
+    put32(&pos, frame_no);
+    put32(&pos, frame_bytes + 11);
+    publish(pos);
+
+    stats.frames++;
+    stats.last_frame_bytes = frame_bytes;
+    if (frame_bytes > stats.max_frame_bytes)
+        stats.max_frame_bytes = frame_bytes;
+    if (frame_us > stats.max_frame_encode_us)
+        stats.max_frame_encode_us = frame_us;
+    frame_no++;
+    frame_bytes = 0;
+    frame_us = 0;
+}
+
+void remote_flush(const lv_area_t *area, const uint8_t *px_map, int last) {
+    if (!present)
+        return;
+
+    uint64_t t0 = rdtsc();
+    int32_t w = lv_area_get_width(area);
+    if (!put_rect(area->x1, area->y1, w, lv_area_get_height(area), (const uint32_t *)px_map,
+                  (uint32_t)w)) {
+        stats.dropped++;
+        backlog_add(area);
+    }
+    if (last && backlog_valid)
+        resend();
+    uint32_t us = (uint32_t)tsc_to_us(rdtsc() - t0, NULL);
+    stats.encode_us += us;
+    frame_us += us;
+
+    if (last)
+        end_frame();
+}
+
+void remote_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx, int32_t dy) {
+    if (!present)
+        return;
+
+    lv_area_t dst = { x + dx, y + dy, x + dx + w - 1, y + dy + h - 1 };
+    uint32_t pos = head;
+    if (!room(pos, 15)) {
+        stats.dropped++;
+        backlog_add(&dst);
+        return;
+    }
+    put_header(&pos, 'M');
+    put16(&pos, (uint32_t)x);
+    put16(&pos, (uint32_t)y);
+    put16(&pos, (uint32_t)w);
+    put16(&pos, (uint32_t)h);
+    put16(&pos, (uint32_t)dx);
+    put16(&pos, (uint32_t)dy);
+    publish(pos);
+    stats.moves++;
+
+    /* Wrong pixels the viewer still has move along with the rest */
+    if (backlog_valid) {
+        lv_area_t moved = { backlog.x1 + dx, backlog.y1 + dy, backlog.x2 + dx, backlog.y2 + dy };
+        backlog_add(&moved);
+    }
+}
+
+void remote_poll(void) {
+    if (!present)
+        return;
+
+    int resync = 0;
+    while (inb(BASE + UART_LSR) & LSR_DATA_READY) {
+        if (inb(BASE + UART_DATA) == 'K')
+            resync = 1;
+    }
+    if (resync) {
+        put_info();
+        vbe_info_t *vbe = vbe_get_info();
+        lv_area_t all = { 0, 0, (int32_t)vbe->width - 1, (int32_t)vbe->height - 1 };
+        backlog_add(&all);
+    }
+    if (!backlog_valid)
+        return;
+
+    uint64_t t0 = rdtsc();
+    resend();
+    frame_us += (uint32_t)tsc_to_us(rdtsc() - t0, NULL);
+    if (frame_bytes)
+        end_frame();
+}
+
+void remote_init(void) {
+    head = tail = 0;
+    backlog_valid = 0;
+    frame_no = frame_bytes = frame_us = 0;
+
+    /* Nothing at the port reads the scratch register back as 0xFF */
+    outb(BASE + UART_SCR, 0x5A);
+    present = inb(BASE + UART_SCR) == 0x5A;
+    if (!present)
+        return;
+
+    uint16_t divisor = 115200 / PORT_REMOTE_BAUD;
+    outb(BASE + UART_IER, 0x00);
+    outb(BASE + UART_LCR, 0x80);            /* DLAB on */
+    outb(BASE + UART_DATA, divisor & 0xFF);
+    outb(BASE + UART_IER, divisor >> 8);
+    outb(BASE + UART_LCR, 0x03);            /* 8N1, DLAB off */
+    outb(BASE + UART_FCR, 0xC7);            /* FIFOs on and cleared */
+    outb(BASE + UART_MCR, 0x03 | MCR_OUT2);
+    irq_install(PORT_REMOTE_IRQ, uart_irq);
+
+    put_info();
+}
+
+void remote_get_stats(remote_stats_t *out) {
+    *out = stats;
+}
+
+void remote_dump(void) {
+    if (!present) {
+        serial_printf("remote: no UART at 0x%x\n", (unsigned)BASE);
+        return;
+    }
+    serial_printf("remote: %u frames, %u rects, %u moves, %u dropped, %u resent\n",
+                  (unsigned)stats.frames, (unsigned)stats.rects, (unsigned)stats.moves,
+                  (unsigned)stats.dropped, (unsigned)stats.resends);
+    serial_printf("  %u KiB sent for %u KiB of pixels, last frame %u bytes, max %u\n",
+                  (unsigned)(stats.bytes / 1024), (unsigned)(stats.raw_bytes / 1024),
+                  (unsigned)stats.last_frame_bytes, (unsigned)stats.max_frame_bytes);
+    serial_printf("  encode %u us total, max %u us per frame; ring peak %u of %u bytes\n",
+                  (unsigned)stats.encode_us, (unsigned)stats.max_frame_encode_us,
+                  (unsigned)stats.ring_peak, (unsigned)PORT_REMOTE_RING);
+}
+
+#endif
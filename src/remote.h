@@ -0,0 +1,71 @@
+#ifndef REMOTE_H
+#define REMOTE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Remote display: every area copied to VRAM is also run-length encoded
+ * onto a second UART (PORT_REMOTE_UART, COM2 by default), where
+ * remote-view.py rebuilds the screen. Encoded bytes go into a ring of
+ * PORT_REMOTE_RING bytes that the UART interrupt drains, so flushing
+ * never waits for the line. An area that does not fit in the ring is
+ * dropped and sent again later from VRAM. The sink is off when no UART
+ * answers at that port.
+ *
+ * Stream: messages start with 0xA5 0x5A and a type byte, followed by
+ * little-endian fields:
+ *   'I' w h                       screen size (u16), sent at boot
+ *   'R' x y w h len, len bytes    pixels of a rect (u16 fields, u32 len)
+ *   'M' x y w h dx dy             fb_move() of a rect (i16)
+ *   'E' frame bytes               end of frame: number, stream bytes (u32)
+ * Rect pixels are B G R, row by row; a code never crosses a row:
+ *   0x00-0x7f  n + 1 literal pixels follow
+ *   0x80-0xbf  one pixel follows, repeated (n & 0x3f) + 1 times
+ *   0xc0-0xff  (n & 0x3f) + 1 pixels equal to those in the row above
+ * The viewer sends 'K' to have the whole screen sent again.
+ */
+typedef struct {
+    uint32_t frames;            /* End-of-frame messages */
+    uint32_t rects;
+    uint32_t moves;
+    uint32_t dropped;           /* Rects or moves that did not fit in the ring */
+    uint32_t resends;           /* Rects sent again from VRAM */
+    uint64_t bytes;             /* Stream bytes queued */
+    uint64_t raw_bytes;         /* Pixels encoded, at 4 bytes each */
+    uint32_t last_frame_bytes;
+    uint32_t max_frame_bytes;
+    uint64_t encode_us;
+    uint32_t max_frame_encode_us;
+    uint32_t ring_peak;         /* Most bytes waiting in the ring */
+} remote_stats_t;
+
+#if PORT_REMOTE
+/* Probes and programs the UART; call every boot after vbe_init() and
+ * idt_init() */
+void remote_init(void);
+/* Called by the flush callback after an area reached VRAM; last is set
+ * on the final area of a frame */
+void remote_flush(const lv_area_t *area, const uint8_t *px_map, int last);
+/* Mirrors an fb_move() with the same arguments */
+void remote_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx, int32_t dy);
+/* Handles viewer requests and resends dropped areas; call from the main loop */
+void remote_poll(void);
+void remote_get_stats(remote_stats_t *stats);
+/* Prints the stats on serial ('r' command) */
+void remote_dump(void);
+#else
+static inline void remote_init(void) {}
+static inline void remote_flush(const lv_area_t *area, const uint8_t *px_map, int last) {
+    (void)area; (void)px_map; (void)last;
+}
+static inline void remote_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx, int32_t dy) {
+    (void)x; (void)y; (void)w; (void)h; (void)dx; (void)dy;
+}
+static inline void remote_poll(void) {}
+static inline void remote_get_stats(remote_stats_t *stats) { *stats = (remote_stats_t){ 0 }; }
+static inline void remote_dump(void) {}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+#include <stddef.h>
+#include "replay.h"
+
+#if PORT_REPLAY
+
+#include "cmdline.h"
+#include "io.h"
+#include "multiboot.h"
+#include "pacer.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "timer.h"
+#include "tsc.h"
+#include "lvgl/lvgl.h"
+
+int strncmp(const char *s1, const char *s2, size_t n);
+
+#define LINE_LEN    64
+#define HIST_MS     64          /* 1 ms buckets; the last one holds the rest */
+/* Frames kept in the stats after the last key, so its effect is drawn */
+#define TAIL_MS     500
+#define ESC         27
+
+typedef struct {
+    const char *p;
+    const char *end;
+} text_t;
+
+/* Recordings and timings are per boot; none of this is snapshotted */
+static replay_event_t events[PORT_REPLAY_EVENTS] SNAPSHOT_SKIP;
+static uint32_t event_count SNAPSHOT_SKIP;
+
+static int recording SNAPSHOT_SKIP;
+static uint32_t record_base SNAPSHOT_SKIP;
+static uint32_t record_count SNAPSHOT_SKIP;
+
+static int playing SNAPSHOT_SKIP;
+static uint32_t speed SNAPSHOT_SKIP;        /* 0 until the first replay: 1x */
+static uint32_t play_base SNAPSHOT_SKIP;
+static uint32_t next_event SNAPSHOT_SKIP;
+static int exit_after SNAPSHOT_SKIP;
+
+static uint64_t refr_start SNAPSHOT_SKIP;
+static uint32_t frames SNAPSHOT_SKIP;
+static uint64_t frame_total_us SNAPSHOT_SKIP;
+static uint32_t frame_max_us SNAPSHOT_SKIP;
+static uint32_t hist[HIST_MS] SNAPSHOT_SKIP;
+static pacer_stats_t pacer_start SNAPSHOT_SKIP;
+
+static uint32_t now_ms(void) {
+    return (uint32_t)((uint64_t)timer_ticks() * 1000 / PORT_TIMER_HZ);
+}
+
+static uint32_t parse_uint(const char **p, const char *end, uint32_t base) {
+    uint32_t v = 0;
+    while (*p < end) {
+        char c = **p;
+        uint32_t d;
+        if (c >= '0' && c <= '9')
+            d = (uint32_t)(c - '0');
+        else if (base == 16 && c >= 'a' && c <= 'f')
+            d = (uint32_t)(c - 'a' + 10);
+        else
+            break;
+        v = v * base + d;
+        (*p)++;
+    }
+    return v;
+}
+
+static int starts(const char *line, const char *end, const char *prefix, size_t len) {
+    return (size_t)(end - line) >= len && strncmp(line, prefix, len) == 0;
+}
+
+/* "input: MS SCANCODE PRESSED ASCII"; 0 for any other line */
+static int parse_event(const char *line, const char *end, replay_event_t *ev) {
+    static const char prefix[] = "input: ";
+
+    if (!starts(line, end, prefix, sizeof(prefix) - 1))
+        return 0;
+    const char *p = line + sizeof(prefix) - 1;
+    if (p == end || *p < '0' || *p > '9')
+        return 0;
+
+    uint32_t v[4];
+    for (int i = 0; i < 4; i++) {
+        const char *start = p;
+        v[i] = parse_uint(&p, end, i == 1 ? 16 : 10);
+        if (p == start)
+            return 0;
+        if (i < 3) {
+            if (p == end || *p != ' ')
+                return 0;
+            p++;
+        }
+    }
+    ev->ms = v[0];
+    ev->key = (key_event_t){ (uint8_t)v[1], (uint8_t)v[2], (char)v[3] };
+    return 1;
+}
+
+static int next_line(text_t *t, const char **line, const char **end) {
+    while (t->p < t->end && (*t->p == '\n' || *t->p == '\r'))
+        t->p++;
+    if (t->p == t->end)
+        return 0;
+    *line = t->p;
+    while (t->p < t->end && *t->p != '\n' && *t->p != '\r')
+        t->p++;
+    *end = t->p;
+    return 1;
+}
+
+/* Loads the last complete recording in a block of text, if any */
+static void load_text(const char *text, uint32_t len) {
+    text_t t = { text, text + len };
+    const char *line, *end, *begin = NULL, *from = NULL, *to = NULL;
+
+    while (next_line(&t, &line, &end)) {
+        if (starts(line, end, "input: begin", 12))
+            begin = end;
+        else if (begin && starts(line, end, "input: end", 10)) {
+            from = begin;
+            to = line;
+            begin = NULL;
+        }
+    }
+    if (!from)
+        return;
+
+    event_count = 0;
+    t = (text_t){ from, to };
+    while (next_line(&t, &line, &end) && event_count < PORT_REPLAY_EVENTS) {
+        if (parse_event(line, end, &events[event_count]))
+            event_count++;
+    }
+}
+
+static void record(key_event_t key) {
+    serial_printf("input: %u %02x %u %u\n", (unsigned)(now_ms() - record_base),
+                  (unsigned)key.scancode, (unsigned)key.pressed,
+                  (unsigned)(uint8_t)key.ascii);
+    record_count++;
+}
+
+void replay_toggle_record(void) {
+    if (recording) {
+        recording = 0;
+        serial_printf("input: end %u\n", (unsigned)record_count);
+        return;
+    }
+    serial_puts("input: begin\n");
+    record_base = now_ms();
+    record_count = 0;
+    recording = 1;
+}
+
+static int due(void) {
+    uint64_t elapsed = (uint64_t)(now_ms() - play_base) * speed;
+    return next_event < event_count && elapsed >= events[next_event].ms;
+}
+
+int replay_has_key(void) {
+    if (!playing)
+        return keyboard_has_key();
+
+    /* Live keys would make every run different */
+    while (keyboard_has_key())
+        (void)keyboard_get_key();
+    return due();
+}
+
+key_event_t replay_get_key(void) {
+    key_event_t key = playing ? events[next_event++].key : keyboard_get_key();
+    if (recording)
+        record(key);
+    return key;
+}
+
+/* Frame times between the display's refresh events, while replaying */
+static void refr_event_cb(lv_event_t *e) {
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+        refr_start = rdtsc();
+        return;
+    }
+    if (!playing || !refr_start)
+        return;
+
+    uint32_t us = (uint32_t)tsc_to_us(rdtsc() - refr_start, NULL);
+    uint32_t ms = us / 1000;
+    hist[ms < HIST_MS ? ms : HIST_MS - 1]++;
+    frames++;
+    frame_total_us += us;
+    if (us > frame_max_us)
+        frame_max_us = us;
+}
+
+void replay_init(void) {
+    lv_display_t *disp = lv_display_get_default();
+    if (!disp)
+        return;
+    lv_display_add_event_cb(disp, refr_event_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(disp, refr_event_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+/* Upper edge in ms of the bucket holding the pct-th percentile */
+static uint32_t percentile(uint32_t pct) {
+    uint32_t want = (frames * pct + 99) / 100;
+    uint32_t seen = 0;
+
+    if (!frames)
+        return 0;
+    for (uint32_t i = 0; i < HIST_MS; i++) {
+        seen += hist[i];
+        if (seen >= want)
+            return i + 1;
+    }
+    return HIST_MS;
+}
+
+static void start(void) {
+    if (!event_count) {
+        serial_puts("replay: no recording loaded\n");
+        return;
+    }
+    if (!speed)
+        speed = 1;
+
+    frames = 0;
+    frame_total_us = 0;
+    frame_max_us = 0;
+    for (uint32_t i = 0; i < HIST_MS; i++)
+        hist[i] = 0;
+    pacer_get_stats(&pacer_start);
+
+    serial_printf("replay: %u events, %u ms at %ux\n", (unsigned)event_count,
+                  (unsigned)events[event_count - 1].ms, (unsigned)speed);
+    next_event = 0;
+    play_base = now_ms();
+    playing = 1;
+}
+
+static void finish(void) {
+    pacer_stats_t p;
+
+    playing = 0;
+    pacer_get_stats(&p);
+    serial_printf("replay: done, %u of %u events in %u ms\n", (unsigned)next_event,
+                  (unsigned)event_count, (unsigned)(now_ms() - play_base));
+    serial_printf("replay: frames %u, avg %u us, max %u us\n", (unsigned)frames,
+                  (unsigned)(frames ? frame_total_us / frames : 0), (unsigned)frame_max_us);
+    serial_printf("replay: p50 <= %u ms, p95 <= %u ms, p99 <= %u ms\n",
+                  (unsigned)percentile(50), (unsigned)percentile(95),
+                  (unsigned)percentile(99));
+    serial_printf("replay: missed %u, dropped %u\n", (unsigned)(p.missed - pacer_start.missed),
+                  (unsigned)(p.dropped - pacer_start.dropped));
+
+    if (exit_after) {
+        outb(0xf4, 0);
+        for (;;)
+            asm volatile ("hlt");
+    }
+}
+
+void replay_poll(void) {
+    if (!playing || next_event < event_count)
+        return;
+
+    uint32_t last = events[event_count - 1].ms / speed;
+    if (now_ms() - play_base >= last + TAIL_MS)
+        finish();
+}
+
+void replay_toggle(void) {
+    if (playing)
+        finish();
+    else
+        start();
+}
+
+void replay_receive(void) {
+    char line[LINE_LEN];
+    uint32_t len = 0;
+    int in_recording = 0;
+
+    if (playing)
+        finish();
+    serial_puts("replay: send a recording, ESC to give up\n");
+
+    /* Polled without pause: the main loop is too slow for a 16-byte FIFO */
+    for (;;) {
+        int c = serial_read();
+        if (c < 0)
+            continue;
+        if (c == ESC) {
+            serial_puts("replay: receive aborted\n");
+            return;
+        }
+        if (c != '\n' && c != '\r') {
+            if (len < LINE_LEN)
+                line[len++] = (char)c;
+            continue;
+        }
+
+        const char *end = line + len;
+        len = 0;
+        if (starts(line, end, "input: begin", 12)) {
+            event_count = 0;
+            in_recording = 1;
+        } else if (in_recording && starts(line, end, "input: end", 10)) {
+            break;
+        } else if (in_recording && event_count < PORT_REPLAY_EVENTS &&
+                   parse_event(line, end, &events[event_count])) {
+            event_count++;
+        }
+    }
+    start();
+}
+
+void replay_boot(void *mboot_info) {
+    multiboot_info_t *mb = mboot_info;
+
+    if (mb && (mb->flags & MULTIBOOT_INFO_MODS)) {
+        const multiboot_module_t *mods = (const multiboot_module_t *)mb->mods_addr;
+        for (uint32_t i = 0; i < mb->mods_count; i++)
+            load_text((const char *)mods[i].mod_start, mods[i].mod_end - mods[i].mod_start);
+    }
+    if (event_count)
+        serial_printf("replay: recording of %u events loaded\n", (unsigned)event_count);
+
+    const char *v = cmdline_value(mboot_info, "replay_exit");
+    exit_after = v && *v == '1';
+    v = cmdline_value(mboot_info, "replay");
+    if (v) {
+        speed = cmdline_parse_uint(&v);
+        start();
+    }
+}
+
+#endif
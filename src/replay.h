@@ -0,0 +1,55 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "keyboard.h"
+
+/*
+ * Input recording and replay. The keypad input device takes its keys
+ * through replay_get_key(). While recording ('k' command) each key it
+ * takes is printed as "input: MS SCANCODE PRESSED ASCII" between
+ * "input: begin" and "input: end COUNT", MS counted from the start of
+ * the recording. A replay feeds the last complete recording found in a
+ * multiboot module (a serial log works as is), or one sent over serial
+ * after 'Y', back at the recorded times divided by a speed factor. Live
+ * keys are dropped meanwhile. Frame times are collected during a replay
+ * and printed at its end as "replay: ..." lines, so a recorded session
+ * can be rerun as a benchmark. "replay=N" on the kernel command line
+ * starts the module's recording at N times speed at boot, and
+ * "replay_exit=1" leaves QEMU when it is done (make replay-bench).
+ */
+typedef struct {
+    uint32_t ms;            /* Since the start of the recording */
+    key_event_t key;
+} replay_event_t;
+
+#if PORT_REPLAY
+/* Hooks the display's refresh events; call once after lvgl_port_init() */
+void replay_init(void);
+/* Loads a recording from the modules and applies "replay=N"; every boot */
+void replay_boot(void *mboot_info);
+/* Next key for LVGL: from the replay while one runs, else the keyboard */
+int replay_has_key(void);
+key_event_t replay_get_key(void);
+/* Ends a replay that has fed its last key; call from the main loop */
+void replay_poll(void);
+/* Starts or stops printing keys ('k' command) */
+void replay_toggle_record(void);
+/* Starts or stops a replay of the loaded recording ('y' command) */
+void replay_toggle(void);
+/* Reads a recording from serial until "input: end", then replays it
+ * ('Y' command); ESC gives up */
+void replay_receive(void);
+#else
+static inline void replay_init(void) {}
+static inline void replay_boot(void *mboot_info) { (void)mboot_info; }
+static inline int replay_has_key(void) { return keyboard_has_key(); }
+static inline key_event_t replay_get_key(void) { return keyboard_get_key(); }
+static inline void replay_poll(void) {}
+static inline void replay_toggle_record(void) {}
+static inline void replay_toggle(void) {}
+static inline void replay_receive(void) {}
+#endif
+
+#endif
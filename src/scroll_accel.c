@@ -0,0 +1,324 @@
+#include "scroll_accel.h"
+
+#if PORT_SCROLL_ACCEL
+
+#include "lvgl/src/display/lv_display_private.h"
+#include "fb.h"
+#include "vbe.h"
+#include "remote.h"
+#include "trace.h"
+#include "virtio_gpu.h"
+
+typedef struct {
+    lv_obj_t *obj;
+    int32_t scroll_x;       /* Scroll position at the previous step */
+    int32_t scroll_y;
+} tracked_t;
+
+static tracked_t tracked[PORT_SCROLL_ACCEL_SLOTS];
+static scroll_accel_stats_t stats;
+static lv_display_t *hooked_disp;
+
+/* Set by a scroll step that moved pixels. lv_obj_scroll_by_raw() calls
+ * lv_obj_invalidate() right after LV_EVENT_SCROLL; that invalidation is
+ * recognized by its area and trimmed to exclude the moved region */
+static struct {
+    int active;
+    lv_area_t expect;
+    lv_area_t moved;
+} pending;
+
+static void area_shift(lv_area_t *a, int32_t dx, int32_t dy) {
+    a->x1 += dx;
+    a->x2 += dx;
+    a->y1 += dy;
+    a->y2 += dy;
+}
+
+static int area_equal(const lv_area_t *a, const lv_area_t *b) {
+    return a->x1 == b->x1 && a->y1 == b->y1 && a->x2 == b->x2 && a->y2 == b->y2;
+}
+
+static int area_overlaps(const lv_area_t *a, const lv_area_t *b) {
+    lv_area_t tmp;
+    return lv_area_intersect(&tmp, a, b);
+}
+
+/* a minus the inner rectangle in (contained in a): up to four bands */
+static int area_subtract(const lv_area_t *a, const lv_area_t *in, lv_area_t *out) {
+    int n = 0;
+    if (in->y1 > a->y1)
+        out[n++] = (lv_area_t){ a->x1, a->y1, a->x2, in->y1 - 1 };
+    if (in->y2 < a->y2)
+        out[n++] = (lv_area_t){ a->x1, in->y2 + 1, a->x2, a->y2 };
+    if (in->x1 > a->x1)
+        out[n++] = (lv_area_t){ a->x1, in->y1, in->x1 - 1, in->y2 };
+    if (in->x2 < a->x2)
+        out[n++] = (lv_area_t){ in->x2 + 1, in->y1, a->x2, in->y2 };
+    return n;
+}
+
+/* Nothing on the way up may blend or transform the object's pixels */
+static int draws_untransformed(lv_obj_t *obj) {
+    for (lv_obj_t *o = obj; o; o = lv_obj_get_parent(o)) {
+        if (lv_obj_get_style_opa(o, LV_PART_MAIN) < LV_OPA_COVER ||
+            lv_obj_get_style_transform_rotation(o, LV_PART_MAIN) != 0 ||
+            lv_obj_get_style_transform_scale_x(o, LV_PART_MAIN) != LV_SCALE_NONE ||
+            lv_obj_get_style_transform_scale_y(o, LV_PART_MAIN) != LV_SCALE_NONE ||
+            lv_obj_get_style_blend_mode(o, LV_PART_MAIN) != LV_BLEND_MODE_NORMAL)
+            return 0;
+    }
+    return 1;
+}
+
+/* The background stays put while the content moves, so it must be a flat
+ * opaque fill */
+static int can_move_pixels(lv_obj_t *obj) {
+    if (lv_obj_get_style_bg_opa(obj, LV_PART_MAIN) < LV_OPA_COVER ||
+        lv_obj_get_style_bg_grad_dir(obj, LV_PART_MAIN) != LV_GRAD_DIR_NONE ||
+        lv_obj_get_style_bg_image_src(obj, LV_PART_MAIN) != NULL ||
+        lv_obj_has_flag(obj, LV_OBJ_FLAG_OVERFLOW_VISIBLE))
+        return 0;
+    return draws_untransformed(obj);
+}
+
+/* Invalidated but not yet rendered pixels would be moved stale */
+static int has_pending_inv(lv_display_t *disp, const lv_area_t *vis) {
+    for (uint32_t i = 0; i < disp->inv_p; i++) {
+        if (area_overlaps(&disp->inv_areas[i], vis))
+            return 1;
+    }
+    return 0;
+}
+
+static void inv_clipped(lv_display_t *disp, const lv_area_t *a, const lv_area_t *clip) {
+    lv_area_t r;
+    if (lv_area_intersect(&r, a, clip))
+        lv_inv_area(disp, &r);
+}
+
+/* An object drawn over the scrolled area that does not scroll with it got
+ * moved along with the content: redraw it where it is and where its old
+ * image landed */
+static void inv_occluder(lv_display_t *disp, lv_obj_t *o, const lv_area_t *vis,
+                         int32_t dx, int32_t dy) {
+    if (lv_obj_has_flag(o, LV_OBJ_FLAG_HIDDEN))
+        return;
+
+    lv_area_t a;
+    int32_t ext = lv_obj_get_ext_draw_size(o);
+    lv_obj_get_coords(o, &a);
+    lv_area_increase(&a, ext, ext);
+    if (!area_overlaps(&a, vis))
+        return;
+
+    inv_clipped(disp, &a, vis);
+    area_shift(&a, dx, dy);
+    inv_clipped(disp, &a, vis);
+}
+
+static void inv_occluders(lv_display_t *disp, lv_obj_t *obj, const lv_area_t *vis,
+                          int32_t dx, int32_t dy) {
+    uint32_t cnt = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < cnt; i++) {
+        lv_obj_t *child = lv_obj_get_child(obj, (int32_t)i);
+        if (lv_obj_has_flag(child, LV_OBJ_FLAG_FLOATING))
+            inv_occluder(disp, child, vis, dx, dy);
+    }
+
+    /* Later siblings of the object and of each ancestor are drawn on top */
+    lv_obj_t *o = obj;
+    lv_obj_t *parent;
+    while ((parent = lv_obj_get_parent(o)) != NULL) {
+        cnt = lv_obj_get_child_count(parent);
+        for (uint32_t i = (uint32_t)lv_obj_get_index(o) + 1; i < cnt; i++)
+            inv_occluder(disp, lv_obj_get_child(parent, (int32_t)i), vis, dx, dy);
+        o = parent;
+    }
+
+    lv_obj_t *layers[] = { lv_display_get_layer_top(disp), lv_display_get_layer_sys(disp) };
+    for (uint32_t l = 0; l < sizeof(layers) / sizeof(layers[0]); l++) {
+        cnt = lv_obj_get_child_count(layers[l]);
+        for (uint32_t i = 0; i < cnt; i++)
+            inv_occluder(disp, lv_obj_get_child(layers[l], (int32_t)i), vis, dx, dy);
+    }
+}
+
+static int scroll_fast(lv_obj_t *obj, int32_t dx, int32_t dy) {
+    lv_display_t *disp = lv_obj_get_display(obj);
+
+    if (disp->render_mode == LV_DISPLAY_RENDER_MODE_FULL ||
+        lv_display_get_rotation(disp) != LV_DISPLAY_ROTATION_0 ||
+        !can_move_pixels(obj))
+        return 0;
+
+    lv_area_t vis;
+    lv_obj_get_coords(obj, &vis);
+    if (!lv_obj_area_is_visible(obj, &vis) || has_pending_inv(disp, &vis))
+        return 0;
+
+    /* Borders, rounded corners and scrollbars do not scroll; keep them out
+     * of the moved region so they are simply redrawn */
+    lv_area_t inner;
+    int32_t inset = LV_MAX(lv_obj_get_style_radius(obj, LV_PART_MAIN),
+                           lv_obj_get_style_border_width(obj, LV_PART_MAIN));
+    int32_t bar = lv_obj_get_style_width(obj, LV_PART_SCROLLBAR);
+    lv_obj_get_coords(obj, &inner);
+    lv_area_increase(&inner, -inset, -inset);
+    if (lv_obj_get_style_base_dir(obj, LV_PART_MAIN) == LV_BASE_DIR_RTL)
+        inner.x1 += bar + lv_obj_get_style_pad_left(obj, LV_PART_SCROLLBAR);
+    else
+        inner.x2 -= bar + lv_obj_get_style_pad_right(obj, LV_PART_SCROLLBAR);
+    inner.y2 -= bar + lv_obj_get_style_pad_bottom(obj, LV_PART_SCROLLBAR);
+    if (!lv_area_intersect(&inner, &inner, &vis))
+        return 0;
+
+    /* Destination of the move; its source is the same area shifted back */
+    lv_area_t dst = inner;
+    area_shift(&dst, dx, dy);
+    if (!lv_area_intersect(&dst, &dst, &inner))
+        return 0;
+
+    /* The area lv_obj_invalidate() is about to pass to lv_inv_area() */
+    lv_area_t expect;
+    lv_area_t scr = { 0, 0, lv_display_get_horizontal_resolution(disp) - 1,
+                      lv_display_get_vertical_resolution(disp) - 1 };
+    int32_t ext = lv_obj_get_ext_draw_size(obj);
+    lv_obj_get_coords(obj, &expect);
+    lv_area_increase(&expect, ext, ext);
+    if (!lv_obj_area_is_visible(obj, &expect) || !lv_area_intersect(&expect, &expect, &scr))
+        return 0;
+
+    trace_begin("scroll_move");
+    fb_move(vbe_get_info(), dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst),
+            lv_area_get_height(&dst), dx, dy);
+    virtio_gpu_move(dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst),
+                    lv_area_get_height(&dst), dx, dy);
+    remote_move(dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst), lv_area_get_height(&dst),
+                dx, dy);
+    trace_end("scroll_move");
+    inv_occluders(disp, obj, &vis, dx, dy);
+
+    pending.expect = expect;
+    pending.moved = dst;
+    pending.active = 1;
+    return 1;
+}
+
+static void scroll_event_cb(lv_event_t *e) {
+    lv_obj_t *obj = lv_event_get_current_target(e);
+    tracked_t *t = lv_event_get_user_data(e);
+
+    int32_t sx = lv_obj_get_scroll_x(obj);
+    int32_t sy = lv_obj_get_scroll_y(obj);
+    int32_t dx = t->scroll_x - sx;
+    int32_t dy = t->scroll_y - sy;
+    t->scroll_x = sx;
+    t->scroll_y = sy;
+
+    pending.active = 0;
+    if ((dx != 0 || dy != 0) && !scroll_fast(obj, dx, dy))
+        stats.slow++;
+}
+
+static void inv_area_event_cb(lv_event_t *e) {
+    if (!pending.active)
+        return;
+    pending.active = 0;
+
+    lv_area_t *area = lv_event_get_param(e);
+    if (!area_equal(area, &pending.expect)) {
+        /* Not the scroll invalidation; the moved pixels get redrawn anyway */
+        stats.slow++;
+        return;
+    }
+
+    lv_area_t bands[4];
+    int n = area_subtract(area, &pending.moved, bands);
+    if (n == 0)
+        return;
+
+    /* Render the first band in place of the full area, queue the rest */
+    *area = bands[0];
+    for (int i = 1; i < n; i++)
+        lv_inv_area(hooked_disp, &bands[i]);
+
+    uint32_t moved = lv_area_get_size(&pending.moved);
+    stats.fast++;
+    stats.moved_px += moved;
+    trace_counter("scroll_moved_px", (int32_t)moved);
+}
+
+static void delete_event_cb(lv_event_t *e) {
+    tracked_t *t = lv_event_get_user_data(e);
+    t->obj = NULL;
+}
+
+int scroll_accel_attach(lv_obj_t *obj) {
+    tracked_t *t = NULL;
+    for (int i = 0; i < PORT_SCROLL_ACCEL_SLOTS; i++) {
+        if (tracked[i].obj == obj)
+            return 0;
+        if (!tracked[i].obj && !t)
+            t = &tracked[i];
+    }
+    if (!t)
+        return -1;
+
+    lv_display_t *disp = lv_obj_get_display(obj);
+    if (hooked_disp != disp) {
+        if (hooked_disp)
+            return -1;
+        hooked_disp = disp;
+        lv_display_add_event_cb(disp, inv_area_event_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+    }
+
+    t->obj = obj;
+    t->scroll_x = lv_obj_get_scroll_x(obj);
+    t->scroll_y = lv_obj_get_scroll_y(obj);
+    lv_obj_add_event_cb(obj, scroll_event_cb, LV_EVENT_SCROLL, t);
+    lv_obj_add_event_cb(obj, delete_event_cb, LV_EVENT_DELETE, t);
+    return 0;
+}
+
+int scroll_accel_move_area(lv_obj_t *obj, const lv_area_t *area, int32_t dx, int32_t dy) {
+    lv_display_t *disp = lv_obj_get_display(obj);
+
+    if (disp->render_mode == LV_DISPLAY_RENDER_MODE_FULL ||
+        lv_display_get_rotation(disp) != LV_DISPLAY_ROTATION_0 ||
+        !draws_untransformed(obj))
+        return 0;
+
+    /* All of it on screen, and nothing in it waiting to be rendered */
+    lv_area_t vis = *area;
+    if (!lv_obj_area_is_visible(obj, &vis) || !area_equal(&vis, area) ||
+        has_pending_inv(disp, area))
+        return 0;
+
+    lv_area_t dst = *area;
+    area_shift(&dst, dx, dy);
+    if (!lv_area_intersect(&dst, &dst, area))
+        return 0;
+
+    trace_begin("scroll_move");
+    fb_move(vbe_get_info(), dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst),
+            lv_area_get_height(&dst), dx, dy);
+    virtio_gpu_move(dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst),
+                    lv_area_get_height(&dst), dx, dy);
+    remote_move(dst.x1 - dx, dst.y1 - dy, lv_area_get_width(&dst), lv_area_get_height(&dst),
+                dx, dy);
+    trace_end("scroll_move");
+    inv_occluders(disp, obj, area, dx, dy);
+
+    uint32_t moved = lv_area_get_size(&dst);
+    stats.fast++;
+    stats.moved_px += moved;
+    trace_counter("scroll_moved_px", (int32_t)moved);
+    return 1;
+}
+
+void scroll_accel_get_stats(scroll_accel_stats_t *out) {
+    *out = stats;
+}
+
+#endif
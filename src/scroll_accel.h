@@ -0,0 +1,39 @@
+#ifndef SCROLL_ACCEL_H
+#define SCROLL_ACCEL_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Scroll fast path. LVGL invalidates the whole object on every scroll
+ * step; for an opaque, untransformed container the pixels on screen are
+ * still valid, just displaced. The overlapping part is moved inside the
+ * framebuffer and the invalidation is cut down to the exposed strip,
+ * the borders/corners and anything drawn on top of the container.
+ */
+typedef struct {
+    uint32_t fast;          /* Scroll steps served by a framebuffer move */
+    uint32_t slow;          /* Steps that fell back to a full redraw */
+    uint64_t moved_px;      /* Pixels moved instead of rendered */
+} scroll_accel_stats_t;
+
+#if PORT_SCROLL_ACCEL
+/* Enables the fast path for a scrollable object; 0 on success */
+int scroll_accel_attach(lv_obj_t *obj);
+/* Moves the screen pixels of area, which obj draws opaquely, by (dx, dy)
+ * and invalidates whatever is drawn on top of it. The strip the move
+ * exposes is left for the caller to invalidate. 0 if the move is not
+ * safe (area partly hidden or already invalidated, transforms, ...) */
+int scroll_accel_move_area(lv_obj_t *obj, const lv_area_t *area, int32_t dx, int32_t dy);
+void scroll_accel_get_stats(scroll_accel_stats_t *stats);
+#else
+static inline int scroll_accel_attach(lv_obj_t *obj) { (void)obj; return 0; }
+static inline int scroll_accel_move_area(lv_obj_t *obj, const lv_area_t *area, int32_t dx, int32_t dy) {
+    (void)obj; (void)area; (void)dx; (void)dy;
+    return 0;
+}
+static inline void scroll_accel_get_stats(scroll_accel_stats_t *stats) { lv_memset(stats, 0, sizeof(*stats)); }
+#endif
+
+#endif
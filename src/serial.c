@@ -0,0 +1,67 @@
+#include "serial.h"
+#include "io.h"
+#include "port_conf.h"
+
+#define COM1 0x3F8
+
+#define UART_DATA 0
+#define UART_IER  1
+#define UART_FCR  2
+#define UART_LCR  3
+#define UART_MCR  4
+#define UART_LSR  5
+
+#define LSR_DATA_READY 0x01
+#define LSR_THR_EMPTY  0x20
+
+int vsnprintf(char *buf, size_t size, const char *format, __builtin_va_list args);
+
+void serial_init(void) {
+    uint16_t divisor = 115200 / PORT_SERIAL_BAUD;
+
+    outb(COM1 + UART_IER, 0x00);            /* Polled, no interrupts */
+    outb(COM1 + UART_LCR, 0x80);            /* DLAB on */
+    outb(COM1 + UART_DATA, divisor & 0xFF);
+    outb(COM1 + UART_IER, divisor >> 8);
+    outb(COM1 + UART_LCR, 0x03);            /* 8N1, DLAB off */
+    outb(COM1 + UART_FCR, 0xC7);            /* FIFOs on and cleared */
+    outb(COM1 + UART_MCR, 0x03);            /* DTR + RTS */
+}
+
+void serial_putc(char c) {
+    while (!(inb(COM1 + UART_LSR) & LSR_THR_EMPTY));
+    outb(COM1 + UART_DATA, (uint8_t)c);
+}
+
+void serial_write(const char *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\n')
+            serial_putc('\r');
+        serial_putc(buf[i]);
+    }
+}
+
+void serial_puts(const char *s) {
+    while (*s) {
+        if (*s == '\n')
+            serial_putc('\r');
+        serial_putc(*s++);
+    }
+}
+
+int serial_printf(const char *format, ...) {
+    char buf[256];
+    __builtin_va_list args;
+    __builtin_va_start(args, format);
+    int len = vsnprintf(buf, sizeof(buf), format, args);
+    __builtin_va_end(args);
+
+    serial_write(buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+    return len;
+}
+
+int serial_read(void) {
+    if (!(inb(COM1 + UART_LSR) & LSR_DATA_READY))
+        return -1;
+    return inb(COM1 + UART_DATA);
+}
@@ -0,0 +1,14 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stddef.h>
+
+void serial_init(void);
+void serial_putc(char c);
+void serial_write(const char *buf, size_t len);
+void serial_puts(const char *s);
+int serial_printf(const char *format, ...);
+/* Returns the next received byte, or -1 if none is pending */
+int serial_read(void);
+
+#endif
@@ -0,0 +1,128 @@
+import os
+import re
+import sys
+
+# Per-module size report from a GNU ld map file (kernel.map).
+#
+# Usage: python3 size-report.py kernel.map [baseline.map]
+#
+# LVGL objects are grouped by source directory (lvgl/src/widgets/button),
+# kernel objects are listed per file. With a baseline map a delta column
+# shows what changed, e.g. between PROFILE=debug and PROFILE=gc builds.
+
+CATEGORIES = (
+    ("text", (".text",)),
+    ("rodata", (".rodata",)),
+    ("data", (".data",)),
+    ("bss", (".bss", "COMMON")),
+)
+
+input_re = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+cont_re = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def category(section):
+    for name, prefixes in CATEGORIES:
+        for prefix in prefixes:
+            if section == prefix or section.startswith(prefix + "."):
+                return name
+    return None
+
+
+def module(path):
+    # Archive members: /usr/lib/gcc/.../libgcc.a(_udivdi3.o)
+    if "(" in path:
+        return os.path.basename(path.split("(")[0])
+    if ".ltrans" in path:
+        return "<lto partitions>"
+    path = os.path.normpath(path)
+    if path.startswith("lvgl" + os.sep):
+        return os.path.dirname(path)
+    return path
+
+
+def parse(map_path):
+    sizes = {}
+    in_map = False
+    pending = None
+
+    with open(map_path, "r", encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Linker script and memory map"):
+                in_map = True
+                continue
+            if not in_map:
+                continue
+
+            section = None
+            m = input_re.match(line)
+            if m:
+                section, size, path = m.group(1), int(m.group(3), 16), m.group(4)
+            elif pending:
+                c = cont_re.match(line)
+                if c:
+                    section, size, path = pending, int(c.group(2), 16), c.group(3)
+
+            # Long input section names are printed alone, details follow
+            pending = None
+            if section is None:
+                if line.startswith(" ") and len(line.split()) == 1:
+                    pending = line.strip()
+                continue
+
+            cat = category(section)
+            if cat is None or size == 0:
+                continue
+            entry = sizes.setdefault(module(path), dict.fromkeys((c for c, _ in CATEGORIES), 0))
+            entry[cat] += size
+
+    return sizes
+
+
+def loaded(entry):
+    # What GRUB has to copy from the image; .bss is only zeroed
+    return entry["text"] + entry["rodata"] + entry["data"]
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: size-report.py kernel.map [baseline.map]")
+        return 1
+
+    current = parse(sys.argv[1])
+    baseline = parse(sys.argv[2]) if len(sys.argv) > 2 else None
+
+    header = f"{'module':<44} {'text':>9} {'rodata':>9} {'data':>8} {'bss':>9} {'loaded':>9}"
+    if baseline is not None:
+        header += f" {'delta':>9}"
+    print(header)
+    print("-" * len(header))
+
+    names = set(current) | set(baseline or {})
+    empty = dict.fromkeys((c for c, _ in CATEGORIES), 0)
+    rows = sorted(names, key=lambda n: loaded(current.get(n, empty)), reverse=True)
+
+    totals = dict(empty)
+    base_total = 0
+    for name in rows:
+        e = current.get(name, empty)
+        for c in totals:
+            totals[c] += e[c]
+        line = f"{name:<44} {e['text']:>9} {e['rodata']:>9} {e['data']:>8} {e['bss']:>9} {loaded(e):>9}"
+        if baseline is not None:
+            b = loaded(baseline.get(name, empty))
+            base_total += b
+            line += f" {loaded(e) - b:>+9}"
+        print(line)
+
+    print("-" * len(header))
+    line = f"{'total':<44} {totals['text']:>9} {totals['rodata']:>9} {totals['data']:>8} {totals['bss']:>9} {loaded(totals):>9}"
+    if baseline is not None:
+        line += f" {loaded(totals) - base_total:>+9}"
+    print(line)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,71 @@
+import struct
+import sys
+
+# Extracts a warm-boot snapshot (snapshot.c) from a serial log.
+#
+# Usage: python3 snapshot-tool.py serial.log snapshot.img
+#
+# The kernel prints the image as hex lines between "snapshot: begin N" and
+# "snapshot: end", either on the 'S' serial command or at boot with
+# "snapshot=dump" on the kernel command line. The last complete dump in the
+# log wins. The header is checked here too, so a truncated capture fails at
+# build time instead of falling back to a cold boot.
+
+MAGIC = 0x50414E53
+HEADER = struct.Struct("<II20s7I")
+
+
+def fnv1a(data, h=2166136261):
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def extract(lines):
+    image = None
+    hexdata = None
+    size = 0
+    for line in lines:
+        line = line.strip()
+        if line.startswith("snapshot: begin "):
+            hexdata = []
+            size = int(line.split()[2])
+        elif line == "snapshot: end" and hexdata is not None:
+            image = bytes.fromhex("".join(hexdata))
+            if len(image) != size:
+                sys.exit(f"dump is {len(image)} bytes, expected {size}")
+            hexdata = None
+        elif hexdata is not None:
+            hexdata.append(line)
+    if image is None:
+        sys.exit("no complete snapshot in the log")
+    return image
+
+
+def check(image):
+    (magic, version, build_id, width, height, data_addr, data_size,
+     bss_addr, bss_size, checksum) = HEADER.unpack_from(image)
+    if magic != MAGIC:
+        sys.exit("bad magic")
+    payload = image[HEADER.size:]
+    if len(payload) != data_size + bss_size:
+        sys.exit("payload size does not match the header")
+    if fnv1a(payload) != checksum:
+        sys.exit("checksum mismatch")
+    print(f"snapshot v{version} build {build_id.hex()} {width}x{height}")
+    print(f"  .data 0x{data_addr:08x} {data_size} bytes")
+    print(f"  .bss  0x{bss_addr:08x} {bss_size} bytes")
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: snapshot-tool.py serial.log snapshot.img")
+    with open(sys.argv[1], errors="replace") as f:
+        image = extract(f)
+    check(image)
+    with open(sys.argv[2], "wb") as f:
+        f.write(image)
+
+
+if __name__ == "__main__":
+    main()
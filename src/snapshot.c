@@ -0,0 +1,188 @@
+#include <stddef.h>
+#include "snapshot.h"
+#include "multiboot.h"
+#include "cmdline.h"
+#include "serial.h"
+#include "idt.h"
+#include "vbe.h"
+#include "trace.h"
+
+#define DUMP_LINE 32        /* Bytes per hex line */
+
+void *memcpy(void *dest, const void *src, size_t n);
+void *memset(void *s, int c, size_t n);
+int memcmp(const void *s1, const void *s2, size_t n);
+
+/* linker.ld */
+extern uint8_t __snapshot_data[], __snapshot_data_end[];
+extern uint8_t __snapshot_bss[], __snapshot_bss_end[];
+extern const uint8_t __build_id_note[], __build_id_end[];
+
+#if PORT_SNAPSHOT
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* The note is namesz, descsz, type, "GNU\0", then the ID itself */
+static int build_id(uint8_t *out) {
+    const uint32_t *note = (const uint32_t *)__build_id_note;
+    uint32_t len = (uint32_t)(__build_id_end - __build_id_note);
+
+    if (len < 16 || note[1] != SNAPSHOT_ID_SIZE || len < 16 + SNAPSHOT_ID_SIZE)
+        return -1;
+    memcpy(out, __build_id_note + 16, SNAPSHOT_ID_SIZE);
+    return 0;
+}
+
+/* Header describing this kernel, without the checksum */
+static void make_header(snapshot_header_t *h) {
+    vbe_info_t *vbe = vbe_get_info();
+
+    memset(h, 0, sizeof(*h));
+    h->magic = SNAPSHOT_MAGIC;
+    h->version = SNAPSHOT_VERSION;
+    build_id(h->build_id);
+    h->width = vbe->width;
+    h->height = vbe->height;
+    h->data_addr = (uint32_t)__snapshot_data;
+    h->data_size = (uint32_t)(__snapshot_data_end - __snapshot_data);
+    h->bss_addr = (uint32_t)__snapshot_bss;
+    h->bss_size = (uint32_t)(__snapshot_bss_end - __snapshot_bss);
+}
+
+static uint32_t payload_checksum(const uint8_t *data, const uint8_t *bss,
+                                 const snapshot_header_t *h) {
+    uint32_t sum = fnv1a(2166136261u, data, h->data_size);
+    return fnv1a(sum, bss, h->bss_size);
+}
+
+static const snapshot_header_t *find_module(multiboot_info_t *mb, uint32_t *size) {
+    if (!mb || !(mb->flags & MULTIBOOT_INFO_MODS))
+        return NULL;
+
+    const multiboot_module_t *mods = (const multiboot_module_t *)mb->mods_addr;
+    for (uint32_t i = 0; i < mb->mods_count; i++) {
+        const snapshot_header_t *h = (const snapshot_header_t *)mods[i].mod_start;
+        uint32_t len = mods[i].mod_end - mods[i].mod_start;
+        if (len >= sizeof(*h) && h->magic == SNAPSHOT_MAGIC) {
+            *size = len;
+            return h;
+        }
+    }
+    return NULL;
+}
+
+snapshot_result_t snapshot_restore(void *mboot_info) {
+    uint32_t size;
+    const snapshot_header_t *img = find_module(mboot_info, &size);
+    if (!img)
+        return SNAPSHOT_NONE;
+
+    snapshot_header_t self;
+    make_header(&self);
+    if (img->version != self.version ||
+        memcmp(img->build_id, self.build_id, SNAPSHOT_ID_SIZE) != 0 ||
+        img->width != self.width || img->height != self.height ||
+        img->data_addr != self.data_addr || img->data_size != self.data_size ||
+        img->bss_addr != self.bss_addr || img->bss_size != self.bss_size) {
+        serial_puts("snapshot: taken from another build or video mode, cold boot\n");
+        return SNAPSHOT_STALE;
+    }
+
+    const uint8_t *data = (const uint8_t *)(img + 1);
+    const uint8_t *bss = data + img->data_size;
+    if (size < sizeof(*img) + img->data_size + img->bss_size ||
+        payload_checksum(data, bss, img) != img->checksum) {
+        serial_puts("snapshot: image corrupt, cold boot\n");
+        return SNAPSHOT_CORRUPT;
+    }
+
+    /* The timer interrupt writes restored state */
+    trace_begin("snapshot_restore");
+    irq_disable();
+    memcpy(__snapshot_data, data, img->data_size);
+    memcpy(__snapshot_bss, bss, img->bss_size);
+    irq_enable();
+    trace_end("snapshot_restore");
+
+    serial_printf("snapshot: restored %u bytes\n",
+                  (unsigned)(img->data_size + img->bss_size));
+    return SNAPSHOT_RESTORED;
+}
+
+int snapshot_dump_requested(void *mboot_info) {
+    return cmdline_is(mboot_info, "snapshot", "dump");
+}
+
+typedef struct {
+    char line[DUMP_LINE * 2 + 2];
+    uint32_t fill;
+} hex_writer_t;
+
+static void hex_write(hex_writer_t *w, const uint8_t *p, uint32_t len) {
+    static const char digits[] = "0123456789abcdef";
+
+    for (uint32_t i = 0; i < len; i++) {
+        w->line[w->fill * 2] = digits[p[i] >> 4];
+        w->line[w->fill * 2 + 1] = digits[p[i] & 0xF];
+        if (++w->fill == DUMP_LINE) {
+            w->line[DUMP_LINE * 2] = '\n';
+            serial_write(w->line, DUMP_LINE * 2 + 1);
+            w->fill = 0;
+        }
+    }
+}
+
+static void hex_flush(hex_writer_t *w) {
+    if (w->fill) {
+        w->line[w->fill * 2] = '\n';
+        serial_write(w->line, w->fill * 2 + 1);
+        w->fill = 0;
+    }
+}
+
+void snapshot_dump(void) {
+    snapshot_header_t h;
+    hex_writer_t w = { .fill = 0 };
+
+    make_header(&h);
+    if (build_id(h.build_id) != 0) {
+        serial_puts("snapshot: kernel linked without a build ID\n");
+        return;
+    }
+
+    /* Nothing may change between the checksum and the last byte sent */
+    irq_disable();
+    h.checksum = payload_checksum(__snapshot_data, __snapshot_bss, &h);
+    serial_printf("snapshot: begin %u\n",
+                  (unsigned)(sizeof(h) + h.data_size + h.bss_size));
+    hex_write(&w, (const uint8_t *)&h, sizeof(h));
+    hex_write(&w, __snapshot_data, h.data_size);
+    hex_write(&w, __snapshot_bss, h.bss_size);
+    hex_flush(&w);
+    serial_puts("snapshot: end\n");
+    irq_enable();
+}
+
+#else
+
+snapshot_result_t snapshot_restore(void *mboot_info) {
+    (void)mboot_info;
+    return SNAPSHOT_NONE;
+}
+
+int snapshot_dump_requested(void *mboot_info) {
+    (void)mboot_info;
+    return 0;
+}
+
+void snapshot_dump(void) {
+    serial_puts("snapshot: disabled (PORT_SNAPSHOT)\n");
+}
+
+#endif
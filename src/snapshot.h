@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/* For zero-initialized state that describes this boot rather than the UI
+ * (hardware info, boot timeline, symbol table); a restore leaves it alone */
+#define SNAPSHOT_SKIP __attribute__((section(".bss.nosnapshot")))
+
+#define SNAPSHOT_MAGIC    0x50414E53    /* "SNAP" */
+#define SNAPSHOT_VERSION  1
+#define SNAPSHOT_ID_SIZE  20            /* --build-id=sha1 */
+
+/* Image layout: this header, then .data, then the restored part of .bss */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint8_t build_id[SNAPSHOT_ID_SIZE];
+    uint32_t width;         /* Video mode the UI was laid out for */
+    uint32_t height;
+    uint32_t data_addr;
+    uint32_t data_size;
+    uint32_t bss_addr;
+    uint32_t bss_size;
+    uint32_t checksum;      /* FNV-1a of everything after the header */
+} snapshot_header_t;
+
+typedef enum {
+    SNAPSHOT_RESTORED = 0,
+    SNAPSHOT_NONE = -1,     /* No snapshot module */
+    SNAPSHOT_STALE = -2,    /* Taken from a different build or video mode */
+    SNAPSHOT_CORRUPT = -3,  /* Truncated or checksum mismatch */
+} snapshot_result_t;
+
+/* Looks for a snapshot among the multiboot modules and, if it was taken
+ * from this build, copies it over .data/.bss. Call after vbe_init() and
+ * before lvgl_port_init(); on SNAPSHOT_RESTORED skip LVGL init and UI
+ * construction. The framebuffer is not saved, so redraw the screen */
+snapshot_result_t snapshot_restore(void *mboot_info);
+
+/* Nonzero if the kernel command line asks for "snapshot=dump" */
+int snapshot_dump_requested(void *mboot_info);
+
+/* Prints the current state as a snapshot image in hex lines between
+ * "snapshot: begin" and "snapshot: end" (read by snapshot-tool.py).
+ * Call from the main loop, outside lv_timer_handler() */
+void snapshot_dump(void);
+
+#endif
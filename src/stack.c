@@ -0,0 +1,115 @@
+#include "stack.h"
+#include "serial.h"
+
+/* Bounds from boot.S */
+extern uint32_t stack_bottom[], stack_top[];
+#if PORT_IRQ_STACK_SIZE
+extern uint32_t irq_stack_bottom[], irq_stack_top[];
+#endif
+#if PORT_STACK_GUARD
+extern uint32_t stack_guard[];
+#if PORT_IRQ_STACK_SIZE
+extern uint32_t irq_stack_guard[];
+#endif
+#endif
+
+/* Words right below the stack compared by stack_check() */
+#define GUARD_CHECK_WORDS 16
+
+typedef struct {
+    const char *name;
+    uint32_t *guard;        /* STACK_GUARD_SIZE bytes ending at bottom */
+    uint32_t *bottom;
+    uint32_t *top;
+} stack_range_t;
+
+#if PORT_STACK_GUARD
+#define GUARD(sym) (sym)
+#else
+#define GUARD(sym) NULL
+#endif
+
+static int stack_range(stack_id_t id, stack_range_t *r) {
+    switch (id) {
+        case STACK_MAIN:
+            r->name = "main";
+            r->guard = GUARD(stack_guard);
+            r->bottom = stack_bottom;
+            r->top = stack_top;
+            return 0;
+#if PORT_IRQ_STACK_SIZE
+        case STACK_IRQ:
+            r->name = "irq";
+            r->guard = GUARD(irq_stack_guard);
+            r->bottom = irq_stack_bottom;
+            r->top = irq_stack_top;
+            return 0;
+#endif
+        default:
+            return -1;
+    }
+}
+
+int stack_get_info(stack_id_t id, stack_info_t *info) {
+    stack_range_t r;
+    if (stack_range(id, &r) != 0)
+        return -1;
+
+    /* Stacks grow down: the first overwritten word from the bottom marks
+     * the deepest point reached */
+    uint32_t *p = r.bottom;
+    while (p < r.top && *p == STACK_PAINT)
+        p++;
+
+    info->name = r.name;
+    info->size = (uint32_t)((uint8_t *)r.top - (uint8_t *)r.bottom);
+    info->high_water = (uint32_t)((uint8_t *)r.top - (uint8_t *)p);
+    info->guard_hit = 0;
+    if (r.guard) {
+        for (const uint32_t *g = r.guard; g < r.guard + STACK_GUARD_SIZE / 4; g++) {
+            if (*g != STACK_PAINT) {
+                info->guard_hit = 1;
+                break;
+            }
+        }
+    } else {
+        info->guard_hit = info->high_water == info->size;
+    }
+    return 0;
+}
+
+void stack_check(void) {
+    for (int id = 0; id < STACK_COUNT; id++) {
+        stack_range_t r;
+        if (stack_range(id, &r) != 0)
+            continue;
+
+        /* Without a guard, the bottom of the stack itself is the canary */
+        const uint32_t *w = r.guard ? r.guard + STACK_GUARD_SIZE / 4 - GUARD_CHECK_WORDS
+                                    : r.bottom;
+        for (int i = 0; i < GUARD_CHECK_WORDS; i++) {
+            if (w[i] != STACK_PAINT) {
+                serial_printf("\n%s stack overflow near %p\n", r.name,
+                              (void *)&w[i]);
+                asm volatile ("cli; hlt");
+            }
+        }
+    }
+}
+
+void stack_dump(void) {
+    serial_puts("\n# --- stacks ---\n");
+    serial_puts("# name        size    peak   pct   headroom  guard\n");
+    for (int id = 0; id < STACK_COUNT; id++) {
+        stack_info_t info;
+        if (stack_get_info(id, &info) != 0)
+            continue;
+
+        serial_printf("%-6s %9u %7u %4u%% %10u  %s\n", info.name,
+                      (unsigned)info.size, (unsigned)info.high_water,
+                      (unsigned)(info.high_water * 100ULL / info.size),
+                      (unsigned)(info.size - info.high_water),
+                      info.guard_hit ? "HIT" : "ok");
+    }
+    serial_puts("# --- end ---\n");
+}
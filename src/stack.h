@@ -0,0 +1,39 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include "port_conf.h"
+
+/* Fill pattern written over the stacks (and guards) by boot.S */
+#define STACK_PAINT 0x5AC3A55A
+#define STACK_GUARD_SIZE 4096
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+typedef enum {
+    STACK_MAIN,
+    STACK_IRQ,
+    STACK_COUNT
+} stack_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t size;
+    uint32_t high_water;    /* Deepest use seen, in bytes */
+    int guard_hit;          /* Guard page no longer holds the paint */
+} stack_info_t;
+
+/* Scans the painted region; 0 on success, -1 if the stack is not built */
+int stack_get_info(stack_id_t id, stack_info_t *info);
+
+/* Checks the words just below each stack; halts with a serial message if
+ * one was overwritten. Cheap enough to call every main-loop iteration */
+void stack_check(void);
+
+/* Prints size, high-water mark and remaining headroom of each stack */
+void stack_dump(void);
+
+#endif
+
+#endif
@@ -1,5 +1,8 @@
 #include <stddef.h>
 #include <stdint.h>
+#include "port_conf.h"
+#include "heap.h"
+#include "snapshot.h"
 
 /* Add function prototypes to fix conflicting type errors */
 void *memset(void *s, int c, size_t n);
@@ -8,68 +11,394 @@ void *memcpy(void *dest, const void *src, size_t n);
 /* A simple panic function to halt the system on a critical error */
 static void kernel_panic(void)
 {
+#ifdef HOST_BUILD
+    host_panic();
+#else
     /* Disable interrupts and halt the CPU */
     asm volatile("cli; hlt");
+#endif
 }
 
-/* Memory management for LVGL */
-static uint8_t heap[96 * 1024] __attribute__((aligned(8)));
-static size_t heap_index = 0;
+/* Memory management for LVGL
+ *
+ * First-fit allocator with boundary tags and an explicit free list. Every
+ * block starts with an 8-byte header {size | flags, caller}; free blocks
+ * also hold list links after the header and repeat their size in the last
+ * word so a freed neighbour can find them. Blocks coalesce on free, so the
+ * UI can be torn down and rebuilt without exhausting the heap.
+ */
+#define BLK_USED      1u
+#define BLK_PREV_USED 2u
+#define BLK_FLAGS     7u
+#define BLK_HDR       8u
+
+typedef struct blk {
+    uint32_t size_flags;
+    uint32_t caller;
+    /* Only valid while free */
+    struct blk *next;
+    struct blk *prev;
+} blk_t;
+
+#define BLK_MIN  ((sizeof(blk_t) + 4 + 7) & ~7u)
+
+static uint8_t heap[PORT_HEAP_SIZE] __attribute__((aligned(8)));
+static blk_t *free_list;
+static int heap_ready;
+
+static uint32_t used_size, used_cnt, peak_used;
+static uint32_t alloc_total, free_total;
+static uint64_t alloc_bytes;
+
+static inline uint32_t blk_size(const blk_t *b)
+{
+    return b->size_flags & ~BLK_FLAGS;
+}
 
-void *malloc(size_t size)
+static inline blk_t *blk_next(blk_t *b)
+{
+    return (blk_t *)((uint8_t *)b + blk_size(b));
+}
+
+static inline void blk_set_footer(blk_t *b)
 {
-    /* Simple bump allocator - align to 8 bytes */
-    size = (size + 7) & ~7;
+    *(uint32_t *)((uint8_t *)b + blk_size(b) - 4) = blk_size(b);
+}
+
+static void free_list_push(blk_t *b)
+{
+    b->prev = NULL;
+    b->next = free_list;
+    if (free_list)
+        free_list->prev = b;
+    free_list = b;
+}
 
-    if (heap_index + size > sizeof(heap))
+static void free_list_remove(blk_t *b)
+{
+    if (b->prev)
+        b->prev->next = b->next;
+    else
+        free_list = b->next;
+    if (b->next)
+        b->next->prev = b->prev;
+}
+
+static void heap_init(void)
+{
+    blk_t *first = (blk_t *)heap;
+    uint32_t *end = (uint32_t *)(heap + sizeof(heap) - BLK_HDR);
+
+    first->size_flags = (sizeof(heap) - BLK_HDR) | BLK_PREV_USED;
+    first->caller = 0;
+    blk_set_footer(first);
+    free_list = NULL;
+    free_list_push(first);
+
+    /* Zero-sized used sentinel so blk_next never runs off the heap */
+    end[0] = BLK_USED;
+    end[1] = 0;
+
+    used_size = used_cnt = peak_used = 0;
+    alloc_total = free_total = 0;
+    alloc_bytes = 0;
+    heap_ready = 1;
+}
+
+#if PORT_MEM_CALLSITES
+static heap_callsite_t callsites[PORT_MEM_CALLSITE_SLOTS];
+
+static heap_callsite_t *callsite_slot(uint32_t caller)
+{
+    uint32_t i = (caller >> 2) % PORT_MEM_CALLSITE_SLOTS;
+
+    for (uint32_t n = 0; n < PORT_MEM_CALLSITE_SLOTS; n++)
+    {
+        heap_callsite_t *c = &callsites[i];
+        if (c->caller == caller || c->caller == 0)
+        {
+            c->caller = caller;
+            return c;
+        }
+        i = (i + 1) % PORT_MEM_CALLSITE_SLOTS;
+    }
+    /* Table full: lump the rest together under caller 0 */
+    return NULL;
+}
+
+static void callsite_alloc(uint32_t caller, uint32_t bytes)
+{
+    heap_callsite_t *c = callsite_slot(caller);
+    if (c)
+    {
+        c->allocs++;
+        c->bytes += bytes;
+        c->live_blocks++;
+        c->live_bytes += bytes;
+    }
+}
+
+static void callsite_live(uint32_t caller, int32_t blocks, int32_t bytes)
+{
+    heap_callsite_t *c = callsite_slot(caller);
+    if (c)
+    {
+        c->live_blocks += blocks;
+        c->live_bytes += bytes;
+    }
+}
+
+#ifndef HOST_BUILD
+extern uint8_t stack_bottom[], stack_top[];
+#endif
+
+/* Return address PORT_MEM_CALLSITE_DEPTH frames above the function whose
+ * frame is fp, stopping at the edge of the boot stack */
+static uint32_t callsite_walk(uint32_t *fp, uint32_t ret)
+{
+#ifndef HOST_BUILD
+    for (int d = 0; d < PORT_MEM_CALLSITE_DEPTH; d++)
+    {
+        if ((uint8_t *)fp < stack_bottom || (uint8_t *)(fp + 2) > stack_top)
+            break;
+        uint32_t *up = (uint32_t *)fp[0];
+        if (up <= fp || (uint8_t *)(up + 2) > stack_top)
+            break;
+        fp = up;
+        ret = fp[1];
+    }
+#else
+    (void)fp;
+#endif
+    return ret;
+}
+
+#define CALLSITE() \
+    callsite_walk(__builtin_frame_address(0), \
+                  (uint32_t)(uintptr_t)__builtin_return_address(0))
+#else
+#define CALLSITE() ((uint32_t)(uintptr_t)__builtin_return_address(0))
+#endif
+
+static void *heap_alloc(size_t size, uint32_t caller)
+{
+    if (!heap_ready)
+        heap_init();
+
+    if (size > sizeof(heap))
+    {
+        kernel_panic();
+        return NULL;
+    }
+
+    uint32_t need = (size + BLK_HDR + 7) & ~7u;
+    if (need < BLK_MIN)
+        need = BLK_MIN;
+
+    blk_t *b = free_list;
+    while (b && blk_size(b) < need)
+        b = b->next;
+
+    if (b == NULL)
     {
         /* Out of memory! */
         kernel_panic();
         return NULL; /* Unreachable */
     }
 
-    void *ptr = &heap[heap_index];
-    heap_index += size;
+    free_list_remove(b);
+
+    uint32_t have = blk_size(b);
+    if (have - need >= BLK_MIN)
+    {
+        /* Split off the tail as a new free block */
+        blk_t *rest = (blk_t *)((uint8_t *)b + need);
+        rest->size_flags = (have - need) | BLK_PREV_USED;
+        blk_set_footer(rest);
+        free_list_push(rest);
+        have = need;
+    }
+    else
+    {
+        blk_next(b)->size_flags |= BLK_PREV_USED;
+    }
+
+    b->size_flags = have | BLK_USED | (b->size_flags & BLK_PREV_USED);
+    b->caller = caller;
+
+    used_size += have;
+    used_cnt++;
+    if (used_size > peak_used)
+        peak_used = used_size;
+    alloc_total++;
+    alloc_bytes += have;
+#if PORT_MEM_CALLSITES
+    callsite_alloc(caller, have);
+#endif
+
+    return (uint8_t *)b + BLK_HDR;
+}
+
+static void heap_release(void *ptr)
+{
+    blk_t *b = (blk_t *)((uint8_t *)ptr - BLK_HDR);
+
+    if ((uint8_t *)b < heap || (uint8_t *)b >= heap + sizeof(heap) ||
+        !(b->size_flags & BLK_USED))
+    {
+        /* Foreign pointer or double free */
+        kernel_panic();
+        return;
+    }
+
+    uint32_t size = blk_size(b);
+    used_size -= size;
+    used_cnt--;
+    free_total++;
+#if PORT_MEM_CALLSITES
+    callsite_live(b->caller, -1, -(int32_t)size);
+#endif
+
+    uint32_t prev_used = b->size_flags & BLK_PREV_USED;
+
+    blk_t *next = blk_next(b);
+    if (!(next->size_flags & BLK_USED))
+    {
+        free_list_remove(next);
+        size += blk_size(next);
+    }
+
+    if (!prev_used)
+    {
+        uint32_t prev_size = *(uint32_t *)((uint8_t *)b - 4);
+        blk_t *prev = (blk_t *)((uint8_t *)b - prev_size);
+        free_list_remove(prev);
+        size += prev_size;
+        b = prev;
+        prev_used = b->size_flags & BLK_PREV_USED;
+    }
+
+    b->size_flags = size | prev_used;
+    b->caller = 0;
+    blk_set_footer(b);
+    blk_next(b)->size_flags &= ~BLK_PREV_USED;
+    free_list_push(b);
+}
+
+/* Resizes in place when shrinking or when the next block is free and big
+ * enough; returns NULL when the block has to move */
+static void *heap_resize(void *ptr, size_t size)
+{
+    blk_t *b = (blk_t *)((uint8_t *)ptr - BLK_HDR);
+    uint32_t have = blk_size(b);
+
+    if (size > sizeof(heap))
+        return NULL;
+
+    uint32_t need = (size + BLK_HDR + 7) & ~7u;
+    if (need < BLK_MIN)
+        need = BLK_MIN;
+
+    if (need > have)
+    {
+        blk_t *next = blk_next(b);
+        if ((next->size_flags & BLK_USED) || have + blk_size(next) < need)
+            return NULL;
+
+        free_list_remove(next);
+        uint32_t grown = have + blk_size(next);
+        used_size += grown - have;
+#if PORT_MEM_CALLSITES
+        callsite_live(b->caller, 0, grown - have);
+#endif
+        have = grown;
+        b->size_flags = have | (b->size_flags & BLK_FLAGS);
+        blk_next(b)->size_flags |= BLK_PREV_USED;
+    }
+
+    if (have - need >= BLK_MIN)
+    {
+        /* Give the tail back as a used block and free it so it merges */
+        blk_t *tail = (blk_t *)((uint8_t *)b + need);
+        tail->size_flags = (have - need) | BLK_USED | BLK_PREV_USED;
+        tail->caller = b->caller;
+        b->size_flags = need | (b->size_flags & BLK_FLAGS);
+        used_cnt++;
+        free_total--;
+#if PORT_MEM_CALLSITES
+        callsite_live(b->caller, 1, 0);
+#endif
+        heap_release((uint8_t *)tail + BLK_HDR);
+    }
+
+    /* After the split: the whole neighbour was never handed out */
+    if (used_size > peak_used)
+        peak_used = used_size;
+
     return ptr;
 }
 
+void *malloc(size_t size)
+{
+    return heap_alloc(size, CALLSITE());
+}
+
 void free(void *ptr)
 {
-    /* No-op for simple bump allocator */
-    (void)ptr;
+    if (ptr != NULL)
+    {
+        heap_release(ptr);
+    }
 }
 
-void *realloc(void *ptr, size_t size)
+static void *heap_realloc(void *ptr, size_t size, uint32_t caller)
 {
-    /*
-     * This implementation is UNSAFE because it can read past the end of the original
-     * block, but it's required to avoid an immediate crash from a NULL return.
-     * The real fix is a proper memory allocator.
-     */
     if (ptr == NULL)
     {
-        return malloc(size);
+        return heap_alloc(size, caller);
     }
 
-    void *new_ptr = malloc(size);
+    if (size == 0)
+    {
+        heap_release(ptr);
+        return NULL;
+    }
+
+    if (heap_resize(ptr, size) != NULL)
+    {
+        return ptr;
+    }
+
+    void *new_ptr = heap_alloc(size, caller);
     if (new_ptr == NULL)
     {
         /* Malloc will panic if it fails, so this is unlikely to be reached */
         return NULL;
     }
 
-    /* This copy is still dangerous as we don't know the old size. */
-    /* We are knowingly leaving this as is, as the primary bug was the */
-    /* allocator conflict. The next step would be to replace this allocator. */
-    memcpy(new_ptr, ptr, size);
+    /* Copy only what the old block actually holds */
+    blk_t *b = (blk_t *)((uint8_t *)ptr - BLK_HDR);
+    memcpy(new_ptr, ptr, blk_size(b) - BLK_HDR);
+    heap_release(ptr);
 
     return new_ptr;
 }
 
+void *realloc(void *ptr, size_t size)
+{
+    return heap_realloc(ptr, size, CALLSITE());
+}
+
 void *calloc(size_t nmemb, size_t size)
 {
+    if (size != 0 && nmemb > SIZE_MAX / size)
+    {
+        kernel_panic();
+        return NULL;
+    }
+
     size_t total = nmemb * size;
-    void *ptr = malloc(total);
+    void *ptr = heap_alloc(total, CALLSITE());
 
     if (ptr != NULL)
     {
@@ -79,6 +408,116 @@ void *calloc(size_t nmemb, size_t size)
     return ptr;
 }
 
+void heap_get_stats(heap_stats_t *stats)
+{
+    if (!heap_ready)
+        heap_init();
+
+    memset(stats, 0, sizeof(*stats));
+    for (blk_t *b = free_list; b; b = b->next)
+    {
+        uint32_t size = blk_size(b);
+        stats->free_cnt++;
+        stats->free_size += size;
+        if (size > stats->largest_free)
+            stats->largest_free = size;
+    }
+
+    stats->total_size = sizeof(heap);
+    stats->used_size = used_size;
+    stats->used_cnt = used_cnt;
+    stats->peak_used = peak_used;
+    stats->alloc_total = alloc_total;
+    stats->free_total = free_total;
+    stats->alloc_bytes = alloc_bytes;
+    if (stats->free_size)
+        stats->frag_pct = 100 - (uint8_t)((uint64_t)stats->largest_free * 100 /
+                                          stats->free_size);
+}
+
+int heap_get_callsites(heap_callsite_t *out, int max)
+{
+    int n = 0;
+#if PORT_MEM_CALLSITES
+    for (int i = 0; i < PORT_MEM_CALLSITE_SLOTS && n < max; i++)
+    {
+        if (callsites[i].caller != 0)
+            out[n++] = callsites[i];
+    }
+#else
+    (void)out;
+    (void)max;
+#endif
+    return n;
+}
+
+void heap_reset_callsites(void)
+{
+#if PORT_MEM_CALLSITES
+    /* Keep live counts so later frees still balance */
+    for (int i = 0; i < PORT_MEM_CALLSITE_SLOTS; i++)
+    {
+        callsites[i].allocs = 0;
+        callsites[i].bytes = 0;
+    }
+#endif
+}
+
+int heap_check(void)
+{
+    if (!heap_ready)
+        return 0;
+
+    uint8_t *end = heap + sizeof(heap) - BLK_HDR;
+    uint32_t prev_used = BLK_PREV_USED;
+    uint32_t free_blocks = 0, used = 0, used_blocks = 0;
+    blk_t *b = (blk_t *)heap;
+
+    while ((uint8_t *)b < end)
+    {
+        uint32_t size = blk_size(b);
+        if (size < BLK_MIN || (uint8_t *)b + size > end)
+            return -1;
+        if ((b->size_flags & BLK_PREV_USED) != prev_used)
+            return -2;
+        if (b->size_flags & BLK_USED)
+        {
+            used += size;
+            used_blocks++;
+            prev_used = BLK_PREV_USED;
+        }
+        else
+        {
+            /* Two free neighbours should have been merged */
+            if (!prev_used)
+                return -3;
+            if (*(uint32_t *)((uint8_t *)b + size - 4) != size)
+                return -4;
+            free_blocks++;
+            prev_used = 0;
+        }
+        b = blk_next(b);
+    }
+
+    if ((uint8_t *)b != end || !(*(uint32_t *)end & BLK_USED))
+        return -5;
+    if (used != used_size || used_blocks != used_cnt)
+        return -6;
+
+    uint32_t listed = 0;
+    for (blk_t *f = free_list; f; f = f->next)
+    {
+        if ((uint8_t *)f < heap || (uint8_t *)f >= end ||
+            (f->size_flags & BLK_USED) || (f->next && f->next->prev != f) ||
+            ++listed > free_blocks)
+            return -7;
+    }
+    if (listed != free_blocks)
+        return -7;
+
+    return 0;
+}
+
 /* String functions */
 void *memset(void *s, int c, size_t n)
 {
@@ -224,83 +663,468 @@ char *strncat(char *dest, const char *src, size_t n)
     return dest;
 }
 
-/* Simple snprintf implementation for LVGL */
-static void int_to_str(int value, char *buf, int *pos)
+/*
+ * Formatted output for LVGL (lv_snprintf, lv_label_set_text_fmt, ...).
+ *
+ * Allocation-free and covers %d %i %u %x %X %o %c %s %p %% with the
+ * - 0 + space # flags, width and precision (both may be *) and the
+ * hh/h/l/ll/z/t/j length modifiers. Integers are converted two digits at a
+ * time from a table; 64-bit values only take the slower path when they do
+ * not fit in 32 bits. Floating point is not supported (LV_SPRINTF_USE_FLOAT
+ * is 0): the argument is consumed and nothing is printed.
+ *
+ * Like C99, the return value is the length the full output would have had,
+ * so callers can size a buffer with vsnprintf(NULL, 0, ...).
+ */
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char hex_lower[] = "0123456789abcdef";
+static const char hex_upper[] = "0123456789ABCDEF";
+
+#define FMT_LEFT  0x01
+#define FMT_ZERO  0x02
+#define FMT_PLUS  0x04
+#define FMT_SPACE 0x08
+#define FMT_ALT   0x10
+
+/* Output helpers take the buffer, its usable size (excluding the
+ * terminator) and the current position, and return the new position. The
+ * position keeps counting past the end so the full length is known. */
+static inline size_t fmt_putc(char *buf, size_t cap, size_t pos, char c)
 {
-    if (value < 0)
+    if (pos < cap)
     {
-        buf[(*pos)++] = '-';
-        value = -value;
+        buf[pos] = c;
     }
+    return pos + 1;
+}
 
-    if (value == 0)
+/* Pieces are short (literal runs, <= 22 digits), so copy inline rather
+ * than paying for a memcpy call */
+static inline size_t fmt_write(char *buf, size_t cap, size_t pos, const char *s, size_t n)
+{
+    size_t room = (pos < cap) ? cap - pos : 0;
+    if (n < room)
     {
-        buf[(*pos)++] = '0';
-        return;
+        room = n;
     }
+    for (size_t i = 0; i < room; i++)
+    {
+        buf[pos + i] = s[i];
+    }
+    return pos + n;
+}
 
-    char temp[12];
-    int temp_pos = 0;
+static inline size_t fmt_pad(char *buf, size_t cap, size_t pos, char c, int n)
+{
+    while (n-- > 0)
+    {
+        pos = fmt_putc(buf, cap, pos, c);
+    }
+    return pos;
+}
 
-    while (value > 0)
+/* Divide *n in place by d and return the remainder, using a single 64/32
+ * divl on i386 instead of a libgcc call */
+static inline uint32_t fmt_div_u64_u32(uint64_t *n, uint32_t d)
+{
+#if defined(__i386__)
+    uint32_t hi = (uint32_t)(*n >> 32);
+    uint32_t lo = (uint32_t)*n;
+    uint32_t q_hi = hi / d;
+    uint32_t rem;
+
+    hi -= q_hi * d;
+    asm("divl %4" : "=a"(lo), "=d"(rem) : "0"(lo), "1"(hi), "rm"(d));
+    *n = ((uint64_t)q_hi << 32) | lo;
+    return rem;
+#else
+    uint32_t rem = (uint32_t)(*n % d);
+    *n /= d;
+    return rem;
+#endif
+}
+
+/* Write v in decimal ending just before end; returns the first digit */
+static char *fmt_dec32(char *end, uint32_t v)
+{
+    while (v >= 100)
+    {
+        uint32_t q = v / 100;
+        const char *pair = &digit_pairs[(v - q * 100) * 2];
+        end -= 2;
+        end[0] = pair[0];
+        end[1] = pair[1];
+        v = q;
+    }
+
+    if (v >= 10)
     {
-        temp[temp_pos++] = '0' + (value % 10);
-        value /= 10;
+        end -= 2;
+        end[0] = digit_pairs[v * 2];
+        end[1] = digit_pairs[v * 2 + 1];
     }
+    else
+    {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
 
-    while (temp_pos > 0)
+static char *fmt_dec64(char *end, uint64_t v)
+{
+    /* Peel off 9-digit chunks until the rest fits the 32-bit path */
+    while (v > 0xFFFFFFFFu)
     {
-        buf[(*pos)++] = temp[--temp_pos];
+        uint32_t chunk = fmt_div_u64_u32(&v, 1000000000u);
+        char *start = end - 9;
+        char *p = fmt_dec32(end, chunk);
+        while (p > start)
+        {
+            *--p = '0';
+        }
+        end = start;
     }
+    return fmt_dec32(end, (uint32_t)v);
+}
+
+static char *fmt_hex(char *end, uint64_t v, const char *digits)
+{
+    do
+    {
+        *--end = digits[v & 0xF];
+        v >>= 4;
+    } while (v);
+    return end;
+}
+
+static char *fmt_oct(char *end, uint64_t v)
+{
+    do
+    {
+        *--end = (char)('0' + (v & 7));
+        v >>= 3;
+    } while (v);
+    return end;
+}
+
+/* Emit prefix + zero-extended digits, padded to width */
+static size_t fmt_field(char *buf, size_t cap, size_t pos,
+                        const char *prefix, size_t nprefix,
+                        const char *digits, size_t ndigits,
+                        int width, int prec, unsigned flags)
+{
+    int zeros = (prec > (int)ndigits) ? prec - (int)ndigits : 0;
+    int pad = width - (int)(nprefix + ndigits) - zeros;
+
+    /* '0' only pads when neither '-' nor a precision is given */
+    if ((flags & FMT_ZERO) && !(flags & FMT_LEFT) && prec < 0 && pad > 0)
+    {
+        zeros += pad;
+        pad = 0;
+    }
+
+    if (!(flags & FMT_LEFT))
+    {
+        pos = fmt_pad(buf, cap, pos, ' ', pad);
+    }
+    pos = fmt_write(buf, cap, pos, prefix, nprefix);
+    pos = fmt_pad(buf, cap, pos, '0', zeros);
+    pos = fmt_write(buf, cap, pos, digits, ndigits);
+    if (flags & FMT_LEFT)
+    {
+        pos = fmt_pad(buf, cap, pos, ' ', pad);
+    }
+    return pos;
 }
 
 int vsnprintf(char *buf, size_t size, const char *format, __builtin_va_list args)
 {
+    size_t cap = size ? size - 1 : 0;
     size_t pos = 0;
+    char tmp[24];
+    char *end = tmp + sizeof(tmp);
+    char *digits;
 
-    while (*format && pos < size - 1)
+    while (*format)
     {
-        if (*format == '%')
+        if (*format != '%')
+        {
+            pos = fmt_putc(buf, cap, pos, *format++);
+            continue;
+        }
+        format++;
+
+        /* Fast path for plain %d and %s, by far the most common in LVGL */
+        if (*format == 'd')
+        {
+            int v = __builtin_va_arg(args, int);
+            uint32_t u = (v < 0) ? 0u - (uint32_t)v : (uint32_t)v;
+            digits = fmt_dec32(end, u);
+            if (v < 0)
+            {
+                *--digits = '-';
+            }
+            pos = fmt_write(buf, cap, pos, digits, (size_t)(end - digits));
+            format++;
+            continue;
+        }
+        if (*format == 's')
         {
+            const char *s = __builtin_va_arg(args, const char *);
+            if (!s)
+            {
+                s = "(null)";
+            }
+            while (*s)
+            {
+                pos = fmt_putc(buf, cap, pos, *s++);
+            }
             format++;
-            if (*format == 'd')
+            continue;
+        }
+
+        unsigned flags = 0;
+        for (;; format++)
+        {
+            if (*format == '-')
+                flags |= FMT_LEFT;
+            else if (*format == '0')
+                flags |= FMT_ZERO;
+            else if (*format == '+')
+                flags |= FMT_PLUS;
+            else if (*format == ' ')
+                flags |= FMT_SPACE;
+            else if (*format == '#')
+                flags |= FMT_ALT;
+            else
+                break;
+        }
+
+        int width = 0;
+        if (*format == '*')
+        {
+            width = __builtin_va_arg(args, int);
+            if (width < 0)
             {
-                int value = __builtin_va_arg(args, int);
-                int temp_pos = 0;
-                char temp[32];
-                int_to_str(value, temp, &temp_pos);
-                for (int i = 0; i < temp_pos && pos < size - 1; i++)
+                flags |= FMT_LEFT;
+                width = -width;
+            }
+            format++;
+        }
+        else
+        {
+            while (*format >= '0' && *format <= '9')
+            {
+                width = width * 10 + (*format++ - '0');
+            }
+        }
+
+        int prec = -1;
+        if (*format == '.')
+        {
+            format++;
+            prec = 0;
+            if (*format == '*')
+            {
+                prec = __builtin_va_arg(args, int);
+                if (prec < 0)
                 {
-                    buf[pos++] = temp[i];
+                    prec = -1;
                 }
+                format++;
             }
-            else if (*format == 's')
+            else
             {
-                char *str = __builtin_va_arg(args, char *);
-                while (*str && pos < size - 1)
+                while (*format >= '0' && *format <= '9')
                 {
-                    buf[pos++] = *str++;
+                    prec = prec * 10 + (*format++ - '0');
                 }
             }
-            else if (*format == 'c')
+        }
+
+        /* Length modifier: 0 = int, 1 = long, 2 = long long, -1 = short, -2 = char */
+        int len = 0;
+        switch (*format)
+        {
+        case 'h':
+            len = (format[1] == 'h') ? -2 : -1;
+            format += (len == -2) ? 2 : 1;
+            break;
+        case 'l':
+            len = (format[1] == 'l') ? 2 : 1;
+            format += len;
+            break;
+        case 'j':
+            len = 2;
+            format++;
+            break;
+        case 'z':
+        case 't':
+            len = 1; /* size_t and ptrdiff_t are long-sized on i386 */
+            format++;
+            break;
+        case 'L':
+            format++;
+            break;
+        }
+
+        char conv = *format;
+        if (!conv)
+        {
+            break;
+        }
+        format++;
+
+        uint64_t uval;
+        char sign = 0;
+        const char *prefix = NULL;
+        size_t nprefix = 0;
+
+        switch (conv)
+        {
+        case 'd':
+        case 'i':
+        {
+            long long v;
+            if (len == 2)
+                v = __builtin_va_arg(args, long long);
+            else if (len == 1)
+                v = __builtin_va_arg(args, long);
+            else
+                v = __builtin_va_arg(args, int);
+            if (len == -1)
+                v = (short)v;
+            else if (len == -2)
+                v = (signed char)v;
+
+            if (v < 0)
             {
-                char c = (char)__builtin_va_arg(args, int);
-                buf[pos++] = c;
+                sign = '-';
+                uval = 0 - (unsigned long long)v;
             }
-            else if (*format == '%')
+            else
             {
-                buf[pos++] = '%';
+                sign = (flags & FMT_PLUS) ? '+' : (flags & FMT_SPACE) ? ' ' : 0;
+                uval = (unsigned long long)v;
             }
-            format++;
+
+            digits = (uval <= 0xFFFFFFFFu) ? fmt_dec32(end, (uint32_t)uval) : fmt_dec64(end, uval);
+            if (prec == 0 && uval == 0)
+                digits = end;
+            pos = fmt_field(buf, cap, pos, &sign, sign ? 1 : 0, digits, (size_t)(end - digits), width, prec, flags);
+            break;
         }
-        else
+
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'p':
+            if (conv == 'p')
+            {
+                uval = (uintptr_t)__builtin_va_arg(args, void *);
+                flags |= FMT_ALT;
+                conv = 'x';
+            }
+            else if (len == 2)
+                uval = __builtin_va_arg(args, unsigned long long);
+            else if (len == 1)
+                uval = __builtin_va_arg(args, unsigned long);
+            else
+                uval = __builtin_va_arg(args, unsigned int);
+            if (len == -1)
+                uval = (unsigned short)uval;
+            else if (len == -2)
+                uval = (unsigned char)uval;
+
+            if (conv == 'u')
+            {
+                digits = (uval <= 0xFFFFFFFFu) ? fmt_dec32(end, (uint32_t)uval) : fmt_dec64(end, uval);
+            }
+            else if (conv == 'o')
+            {
+                digits = fmt_oct(end, uval);
+            }
+            else
+            {
+                digits = fmt_hex(end, uval, (conv == 'X') ? hex_upper : hex_lower);
+                if ((flags & FMT_ALT) && uval != 0)
+                {
+                    prefix = (conv == 'X') ? "0X" : "0x";
+                    nprefix = 2;
+                }
+            }
+
+            if (prec == 0 && uval == 0)
+                digits = end;
+            /* '#' with 'o' guarantees a leading zero */
+            if (conv == 'o' && (flags & FMT_ALT) && (digits == end || *digits != '0') &&
+                prec <= (int)(end - digits))
+                prec = (int)(end - digits) + 1;
+            pos = fmt_field(buf, cap, pos, prefix, nprefix, digits, (size_t)(end - digits), width, prec, flags);
+            break;
+
+        case 'c':
+            tmp[0] = (char)__builtin_va_arg(args, int);
+            pos = fmt_field(buf, cap, pos, NULL, 0, tmp, 1, width, -1, flags & ~FMT_ZERO);
+            break;
+
+        case 's':
         {
-            buf[pos++] = *format++;
+            const char *s = __builtin_va_arg(args, const char *);
+            size_t n = 0;
+            if (!s)
+                s = "(null)";
+            /* Never read past the precision, the string need not be terminated */
+            while ((prec < 0 || n < (size_t)prec) && s[n])
+                n++;
+            pos = fmt_field(buf, cap, pos, NULL, 0, s, n, width, -1, flags & ~FMT_ZERO);
+            break;
+        }
+
+        case 'n':
+            (void)__builtin_va_arg(args, void *);
+            break;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            (void)__builtin_va_arg(args, double);
+            break;
+
+        case '%':
+            pos = fmt_putc(buf, cap, pos, '%');
+            break;
+
+        default:
+            /* Unknown conversion: print it verbatim */
+            pos = fmt_putc(buf, cap, pos, '%');
+            pos = fmt_putc(buf, cap, pos, conv);
+            break;
         }
     }
 
-    buf[pos] = '\0';
-    return pos;
+    if (size)
+    {
+        buf[pos < cap ? pos : cap] = '\0';
+    }
+    return (int)pos;
 }
 
 int snprintf(char *buf, size_t size, const char *format, ...)
@@ -312,37 +1136,6 @@ int snprintf(char *buf, size_t size, const char *format, ...)
     return result;
 }
 
-/* GCC builtin support for 64-bit division */
-long long __divdi3(long long a, long long b)
-{
-    int neg = 0;
-    if (a < 0)
-    {
-        a = -a;
-        neg = !neg;
-    }
-    if (b < 0)
-    {
-        b = -b;
-        neg = !neg;
-    }
-
-    long long quot = 0;
-    long long rem = 0;
-
-    for (int i = 63; i >= 0; i--)
-    {
-        rem = (rem << 1) | ((a >> i) & 1);
-        if (rem >= b)
-        {
-            rem -= b;
-            quot |= (1LL << i);
-        }
-    }
-
-    return neg ? -quot : quot;
-}
-
 /* LVGL wrapper functions - map lv_* to our implementations */
 void *lv_memcpy(void *dest, const void *src, size_t n)
 {
@@ -436,42 +1229,100 @@ int lv_vsnprintf(char *buf, size_t size, const char *format, __builtin_va_list a
     return vsnprintf(buf, size, format, args);
 }
 
-/* LVGL memory management wrappers */
+/* LVGL memory management wrappers; these are the calls heap_set_trace()
+ * reports */
+static heap_trace_cb_t trace_cb SNAPSHOT_SKIP;
+
+static inline uint32_t heap_id(const void *ptr)
+{
+    return (uint32_t)((const uint8_t *)ptr - heap) / 8;
+}
+
+void heap_set_trace(heap_trace_cb_t cb)
+{
+    trace_cb = cb;
+}
+
 void *lv_malloc_core(size_t size)
 {
-    return malloc(size);
+    void *ptr = heap_alloc(size, CALLSITE());
+
+    if (trace_cb)
+        trace_cb('m', heap_id(ptr), size, 0);
+    return ptr;
 }
 
 void lv_free_core(void *ptr)
 {
+    if (trace_cb && ptr)
+        trace_cb('f', heap_id(ptr), 0, 0);
     free(ptr);
 }
 
 void *lv_realloc_core(void *ptr, size_t size)
 {
-    return realloc(ptr, size);
+    uint32_t old_id = ptr ? heap_id(ptr) : 0;
+    void *new_ptr = heap_realloc(ptr, size, CALLSITE());
+
+    if (trace_cb)
+    {
+        if (!ptr)
+            trace_cb('m', heap_id(new_ptr), size, 0);
+        else if (!new_ptr)
+            trace_cb('f', old_id, 0, 0);
+        else
+            trace_cb('r', old_id, size, heap_id(new_ptr));
+    }
+    return new_ptr;
 }
 
 void lv_mem_init(void)
 {
-    /* Our bump allocator doesn't need initialization */
+    /* Start from an empty heap */
+    heap_init();
+#if PORT_MEM_CALLSITES
+    memset(callsites, 0, sizeof(callsites));
+#endif
 }
 
 void lv_mem_deinit(void)
 {
-    /* Our bump allocator doesn't need deinitialization */
+    /* Nothing to release; the heap is a static array */
 }
 
+/* Same layout as lv_mem_monitor_t in lvgl/src/stdlib/lv_mem.h */
+typedef struct
+{
+    size_t total_size;
+    size_t free_cnt;
+    size_t free_size;
+    size_t free_biggest_size;
+    size_t used_cnt;
+    size_t max_used;
+    uint8_t used_pct;
+    uint8_t frag_pct;
+} port_mem_monitor_t;
+
 void lv_mem_monitor_core(void *mon)
 {
-    /* Not implemented for simple allocator */
-    (void)mon;
+    port_mem_monitor_t *m = mon;
+    heap_stats_t st;
+
+    heap_get_stats(&st);
+    m->total_size = st.total_size;
+    m->free_cnt = st.free_cnt;
+    m->free_size = st.free_size;
+    m->free_biggest_size = st.largest_free;
+    m->used_cnt = st.used_cnt;
+    m->max_used = st.peak_used;
+    m->used_pct = (uint8_t)((uint64_t)st.used_size * 100 / st.total_size);
+    m->frag_pct = st.frag_pct;
 }
 
 int lv_mem_test_core(void)
 {
-    /* Simple allocator always passes */
-    return 1;
+    /* LV_RESULT_OK is 1, LV_RESULT_INVALID is 0 */
+    return heap_check() == 0;
 }
 
 /* Stub for binary decoder (disabled in config) */
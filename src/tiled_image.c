@@ -0,0 +1,283 @@
+#include "tiled_image.h"
+
+#if PORT_TILED_IMAGE
+
+#include "lvgl/lvgl.h"
+#include "modfs.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "tsc.h"
+
+/* "LVTI" */
+#define TIM_MAGIC   0x4954564Cu
+#define TIM_VERSION 1
+
+#define SLOT_PX     (PORT_TILED_IMAGE_TILE_BYTES / 4)
+#define SLOTS       (PORT_TILED_IMAGE_CACHE_SIZE / PORT_TILED_IMAGE_TILE_BYTES)
+
+/*
+ * File layout (little-endian, written by image-pack.py):
+ *   tim_header_t
+ *   uint32_t offsets[cols * rows + 1]  tile i is file bytes offsets[i]..offsets[i + 1]
+ *   tile data
+ * Tiles are tile_w x tile_h in rows, narrower or shorter at the right and
+ * bottom edges. A tile of exactly w * h * 4 bytes is raw pixels, anything
+ * shorter is a run-length stream:
+ *   0x00-0x7f  n + 1 literal pixels follow
+ *   0x80-0xff  one pixel follows, repeated (n & 0x7f) + 1 times
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t w;
+    uint16_t h;
+    uint16_t tile_w;
+    uint16_t tile_h;
+    uint8_t cf;             /* LV_COLOR_FORMAT_XRGB8888 or _ARGB8888 */
+    uint8_t version;
+    uint16_t reserved;
+} tim_header_t;
+
+typedef struct {
+    const tim_header_t *image;  /* NULL: slot is free */
+    uint32_t tile;
+    uint32_t last_use;
+    lv_draw_buf_t buf;
+} slot_t;
+
+/* Decoded pixels are rebuilt on demand, and the images they came from
+ * may sit at other addresses after a reboot, so none of this goes into a
+ * warm-boot snapshot */
+static uint32_t arena[SLOTS][SLOT_PX] __attribute__((aligned(16))) SNAPSHOT_SKIP;
+static slot_t slots[SLOTS] SNAPSHOT_SKIP;
+static uint32_t use_clock SNAPSHOT_SKIP;
+static tiled_image_stats_t stats SNAPSHOT_SKIP;
+
+static lv_image_decoder_t *decoder;
+
+static uint32_t tile_cols(const tim_header_t *h) {
+    return ((uint32_t)h->w + h->tile_w - 1) / h->tile_w;
+}
+
+static uint32_t tile_rows(const tim_header_t *h) {
+    return ((uint32_t)h->h + h->tile_h - 1) / h->tile_h;
+}
+
+static const uint32_t *tile_offsets(const tim_header_t *h) {
+    return (const uint32_t *)(h + 1);
+}
+
+/* The header of a well-formed .tim file on the modfs drive, else NULL */
+static const tim_header_t *image_of_src(const lv_image_decoder_dsc_t *dsc) {
+    if (dsc->src_type != LV_IMAGE_SRC_FILE)
+        return NULL;
+    const char *path = dsc->src;
+    if (path[0] != PORT_MODFS_LETTER || path[1] != ':')
+        return NULL;
+
+    uint32_t size;
+    const tim_header_t *h = modfs_map(path + 2, &size);
+    if (!h || size < sizeof(*h) || h->magic != TIM_MAGIC || h->version != TIM_VERSION ||
+        h->w == 0 || h->h == 0 || h->tile_w == 0 || h->tile_h == 0 ||
+        (uint32_t)h->tile_w * h->tile_h > SLOT_PX ||
+        (h->cf != LV_COLOR_FORMAT_XRGB8888 && h->cf != LV_COLOR_FORMAT_ARGB8888))
+        return NULL;
+
+    /* Offsets must fit the file and run forwards, so decoding never reads
+     * outside the module */
+    uint32_t tiles = tile_cols(h) * tile_rows(h);
+    if ((size - sizeof(*h)) / 4 < tiles + 1)
+        return NULL;
+    const uint32_t *off = tile_offsets(h);
+    uint32_t first = sizeof(*h) + (tiles + 1) * 4;
+    if (off[0] < first || off[tiles] > size)
+        return NULL;
+    for (uint32_t i = 0; i < tiles; i++) {
+        if (off[i + 1] < off[i])
+            return NULL;
+    }
+    return h;
+}
+
+static int rle_decode(const uint8_t *src, uint32_t len, uint32_t *dst, uint32_t npx) {
+    const uint8_t *end = src + len;
+    uint32_t n = 0;
+
+    while (src < end) {
+        uint32_t ctrl = *src++;
+        uint32_t count = (ctrl & 0x7f) + 1;
+        if (count > npx - n)
+            return -1;
+
+        if (ctrl & 0x80) {
+            if (end - src < 4)
+                return -1;
+            uint32_t px = src[0] | (uint32_t)src[1] << 8 | (uint32_t)src[2] << 16 |
+                          (uint32_t)src[3] << 24;
+            src += 4;
+            while (count--)
+                dst[n++] = px;
+        } else {
+            if ((uint32_t)(end - src) < count * 4)
+                return -1;
+            lv_memcpy(dst + n, src, count * 4);
+            src += count * 4;
+            n += count;
+        }
+    }
+    return n == npx ? 0 : -1;
+}
+
+static void decode_tile(const tim_header_t *h, uint32_t tile, slot_t *s, uint32_t *px) {
+    uint32_t cols = tile_cols(h);
+    uint32_t x = tile % cols * h->tile_w;
+    uint32_t y = tile / cols * h->tile_h;
+    uint32_t w = LV_MIN(h->tile_w, h->w - x);
+    uint32_t rows = LV_MIN(h->tile_h, h->h - y);
+    uint32_t npx = w * rows;
+
+    const uint32_t *off = tile_offsets(h);
+    const uint8_t *src = (const uint8_t *)h + off[tile];
+    uint32_t len = off[tile + 1] - off[tile];
+
+    uint64_t t0 = rdtsc();
+    if (len == npx * 4) {
+        lv_memcpy(px, src, len);
+    } else if (rle_decode(src, len, px, npx) != 0) {
+        lv_memset(px, 0, npx * 4);
+        stats.corrupt++;
+    }
+    stats.decode_us += tsc_to_us(rdtsc() - t0, NULL);
+    stats.packed_bytes += len;
+
+    lv_draw_buf_init(&s->buf, w, rows, (lv_color_format_t)h->cf, w * 4, px, npx * 4);
+}
+
+/* The cached tile, decoding it into the least recently used slot on a
+ * miss. A slot is only in use until the next lookup, since tiles are
+ * drawn one at a time */
+static slot_t *tile_get(const tim_header_t *h, uint32_t tile) {
+    slot_t *victim = &slots[0];
+
+    for (uint32_t i = 0; i < SLOTS; i++) {
+        slot_t *s = &slots[i];
+        if (s->image == h && s->tile == tile) {
+            s->last_use = ++use_clock;
+            stats.hits++;
+            return s;
+        }
+        if (!s->image)
+            victim = s;
+        else if (victim->image && s->last_use < victim->last_use)
+            victim = s;
+    }
+
+    stats.misses++;
+    if (victim->image)
+        stats.evictions++;
+    victim->image = h;
+    victim->tile = tile;
+    victim->last_use = ++use_clock;
+    decode_tile(h, tile, victim, arena[victim - slots]);
+    return victim;
+}
+
+static lv_result_t decoder_info(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc,
+                                lv_image_header_t *header) {
+    (void)dec;
+    const tim_header_t *h = image_of_src(dsc);
+    if (!h)
+        return LV_RESULT_INVALID;
+
+    lv_memset(header, 0, sizeof(*header));
+    header->magic = LV_IMAGE_HEADER_MAGIC;
+    header->cf = h->cf;
+    header->w = h->w;
+    header->h = h->h;
+    header->stride = (uint32_t)h->w * 4;
+    return LV_RESULT_OK;
+}
+
+/* Nothing is decoded up front: leaving dsc->decoded NULL makes the
+ * renderer ask for the image area by area through decoder_get_area() */
+static lv_result_t decoder_open(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc) {
+    (void)dec;
+    const tim_header_t *h = image_of_src(dsc);
+    if (!h)
+        return LV_RESULT_INVALID;
+    dsc->user_data = (void *)h;
+    dsc->decoded = NULL;
+    return LV_RESULT_OK;
+}
+
+/* Hands out the tiles overlapping full_area (image coordinates) in rows,
+ * one per call; decoded_area is the previous tile, or LV_COORD_MIN on
+ * the first call */
+static lv_result_t decoder_get_area(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc,
+                                    const lv_area_t *full_area, lv_area_t *decoded_area) {
+    (void)dec;
+    const tim_header_t *h = dsc->user_data;
+    int32_t tw = h->tile_w;
+    int32_t th = h->tile_h;
+    int32_t x1 = LV_MAX(full_area->x1, 0);
+    int32_t y1 = LV_MAX(full_area->y1, 0);
+    int32_t x2 = LV_MIN(full_area->x2, (int32_t)h->w - 1);
+    int32_t y2 = LV_MIN(full_area->y2, (int32_t)h->h - 1);
+    int32_t col, row;
+
+    if (decoded_area->y1 == LV_COORD_MIN) {
+        col = x1 / tw;
+        row = y1 / th;
+    } else {
+        col = decoded_area->x1 / tw + 1;
+        row = decoded_area->y1 / th;
+        if (col * tw > x2) {
+            col = x1 / tw;
+            row++;
+        }
+    }
+    if (x1 > x2 || row * th > y2)
+        return LV_RESULT_INVALID;
+
+    slot_t *s = tile_get(h, (uint32_t)row * tile_cols(h) + (uint32_t)col);
+    decoded_area->x1 = col * tw;
+    decoded_area->y1 = row * th;
+    decoded_area->x2 = decoded_area->x1 + (int32_t)s->buf.header.w - 1;
+    decoded_area->y2 = decoded_area->y1 + (int32_t)s->buf.header.h - 1;
+    dsc->decoded = &s->buf;
+    return LV_RESULT_OK;
+}
+
+static void decoder_close(lv_image_decoder_t *dec, lv_image_decoder_dsc_t *dsc) {
+    (void)dec;
+    (void)dsc;
+}
+
+void tiled_image_init(void) {
+    decoder = lv_image_decoder_create();
+    lv_image_decoder_set_info_cb(decoder, decoder_info);
+    lv_image_decoder_set_open_cb(decoder, decoder_open);
+    lv_image_decoder_set_get_area_cb(decoder, decoder_get_area);
+    lv_image_decoder_set_close_cb(decoder, decoder_close);
+}
+
+void tiled_image_get_stats(tiled_image_stats_t *out) {
+    *out = stats;
+}
+
+void tiled_image_dump(void) {
+    uint32_t lookups = stats.hits + stats.misses;
+    uint32_t used = 0;
+
+    for (uint32_t i = 0; i < SLOTS; i++)
+        used += slots[i].image != NULL;
+    serial_printf("tiled images: %u/%u tiles cached, %u KiB\n", (unsigned)used, (unsigned)SLOTS,
+                  (unsigned)(PORT_TILED_IMAGE_CACHE_SIZE / 1024));
+    serial_printf("  hits %u misses %u (%u%% hit), evictions %u, corrupt %u\n",
+                  (unsigned)stats.hits, (unsigned)stats.misses,
+                  (unsigned)(lookups ? (uint64_t)stats.hits * 100 / lookups : 0),
+                  (unsigned)stats.evictions, (unsigned)stats.corrupt);
+    serial_printf("  decoded %u KiB of tile data in %u us\n",
+                  (unsigned)(stats.packed_bytes / 1024), (unsigned)stats.decode_us);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TILED_IMAGE_H
+#define TILED_IMAGE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * Compressed images from the assets archive (".tim" files written by
+ * image-pack.py). An image is cut into tiles that are RLE-compressed
+ * separately, already in the display's color format. The decoder
+ * registered here serves "M:/name.tim" sources one tile at a time. Tiles
+ * are decompressed when a draw touches them and kept in an LRU cache of
+ * PORT_TILED_IMAGE_CACHE_SIZE bytes, so a partial redraw decodes only
+ * the tiles under the dirty area. Draw these images untransformed: LVGL
+ * draws each tile on its own and cannot rotate or scale them as a whole.
+ */
+typedef struct {
+    uint32_t hits;          /* Tiles found in the cache */
+    uint32_t misses;        /* Tiles decompressed */
+    uint32_t evictions;
+    uint32_t corrupt;       /* Tiles whose data did not decode (drawn transparent) */
+    uint32_t packed_bytes;  /* Compressed bytes read by misses */
+    uint64_t decode_us;     /* Time spent decompressing */
+} tiled_image_stats_t;
+
+#if PORT_TILED_IMAGE
+/* Registers the image decoder; call once after modfs_lvgl_init() */
+void tiled_image_init(void);
+void tiled_image_get_stats(tiled_image_stats_t *stats);
+/* Prints the stats on serial ('i' command) */
+void tiled_image_dump(void);
+#else
+static inline void tiled_image_init(void) {}
+static inline void tiled_image_get_stats(tiled_image_stats_t *stats) { *stats = (tiled_image_stats_t){ 0 }; }
+static inline void tiled_image_dump(void) {}
+#endif
+
+#endif
@@ -0,0 +1,67 @@
+#include "timer.h"
+#include "io.h"
+#include "port_conf.h"
+
+#define PIT_HZ       1193182
+#define PIT_CH0_DATA 0x40
+#define PIT_CMD      0x43
+
+#define MAX_CALLBACKS 4
+
+typedef struct {
+    timer_cb_t cb;
+    uint32_t period;
+    uint32_t countdown;
+} timer_slot_t;
+
+static volatile uint32_t ticks;
+static timer_slot_t slots[MAX_CALLBACKS];
+
+static void timer_irq(irq_frame_t *frame) {
+    ticks++;
+
+    for (int i = 0; i < MAX_CALLBACKS; i++) {
+        timer_slot_t *s = &slots[i];
+        if (s->cb && --s->countdown == 0) {
+            s->countdown = s->period;
+            s->cb(frame);
+        }
+    }
+}
+
+void timer_init(void) {
+    uint32_t divisor = PIT_HZ / PORT_TIMER_HZ;
+
+    /* Channel 0, lobyte/hibyte, mode 2 (rate generator) */
+    outb(PIT_CMD, 0x34);
+    outb(PIT_CH0_DATA, divisor & 0xFF);
+    outb(PIT_CH0_DATA, (divisor >> 8) & 0xFF);
+
+    irq_install(0, timer_irq);
+}
+
+uint32_t timer_ticks(void) {
+    return ticks;
+}
+
+int timer_add_callback(timer_cb_t cb, uint32_t period) {
+    if (period == 0)
+        period = 1;
+
+    for (int i = 0; i < MAX_CALLBACKS; i++) {
+        if (!slots[i].cb) {
+            slots[i].period = period;
+            slots[i].countdown = period;
+            slots[i].cb = cb;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void timer_remove_callback(timer_cb_t cb) {
+    for (int i = 0; i < MAX_CALLBACKS; i++) {
+        if (slots[i].cb == cb)
+            slots[i].cb = 0;
+    }
+}
@@ -0,0 +1,20 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include "idt.h"
+
+/* Periodic callback, run from the IRQ0 handler with the interrupted state */
+typedef void (*timer_cb_t)(irq_frame_t *frame);
+
+/* Programs PIT channel 0 to PORT_TIMER_HZ and installs the IRQ0 handler */
+void timer_init(void);
+
+/* Ticks since timer_init() */
+uint32_t timer_ticks(void);
+
+/* Runs cb every `period` ticks; returns 0 on success, -1 if full */
+int timer_add_callback(timer_cb_t cb, uint32_t period);
+void timer_remove_callback(timer_cb_t cb);
+
+#endif
@@ -0,0 +1,104 @@
+#include "trace.h"
+
+#if PORT_TRACE
+
+#include "serial.h"
+#include "tsc.h"
+#include "snapshot.h"
+
+typedef struct {
+    uint64_t tsc;
+    const char *name;
+    int32_t value;
+    char phase;         /* Chrome "ph": B, E, i or C */
+} trace_event_t;
+
+/* The timeline belongs to this boot, warm or cold */
+static trace_event_t boot_events[PORT_TRACE_BOOT_EVENTS] SNAPSHOT_SKIP;
+static uint32_t boot_count SNAPSHOT_SKIP;
+static int boot_done SNAPSHOT_SKIP;
+
+static trace_event_t ring[PORT_TRACE_RING_EVENTS] SNAPSHOT_SKIP;
+static uint32_t ring_head SNAPSHOT_SKIP;      /* Total events written, wraps the index */
+
+static void record(char phase, const char *name, int32_t value) {
+    trace_event_t *ev;
+
+    if (!boot_done) {
+        if (boot_count >= PORT_TRACE_BOOT_EVENTS)
+            return;
+        ev = &boot_events[boot_count++];
+    } else {
+        ev = &ring[ring_head++ % PORT_TRACE_RING_EVENTS];
+    }
+
+    ev->tsc = rdtsc();
+    ev->name = name;
+    ev->value = value;
+    ev->phase = phase;
+}
+
+void trace_init(void) {
+    boot_count = 0;
+    boot_done = 0;
+    ring_head = 0;
+
+    /* The first event is _start itself */
+    boot_events[boot_count++] = (trace_event_t){ boot_tsc, "_start", 0, 'i' };
+
+    trace_begin("tsc_calibrate");
+    tsc_calibrate();
+    trace_end("tsc_calibrate");
+}
+
+void trace_begin(const char *name) {
+    record('B', name, 0);
+}
+
+void trace_end(const char *name) {
+    record('E', name, 0);
+}
+
+void trace_instant(const char *name) {
+    record('i', name, 0);
+}
+
+void trace_counter(const char *name, int32_t value) {
+    record('C', name, value);
+}
+
+void trace_boot_done(void) {
+    boot_done = 1;
+}
+
+static void dump_event(const trace_event_t *ev, int first) {
+    uint32_t frac;
+    uint64_t us = tsc_to_us(ev->tsc - boot_tsc, &frac);
+
+    serial_printf("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":1",
+                  first ? "" : ",\n", ev->name, ev->phase,
+                  (unsigned long long)us, (unsigned)frac);
+    if (ev->phase == 'C')
+        serial_printf(",\"args\":{\"value\":%d}", (int)ev->value);
+    else if (ev->phase == 'i')
+        serial_puts(",\"s\":\"g\"");
+    serial_putc('}');
+}
+
+void trace_dump(void) {
+    uint32_t start = 0;
+    uint32_t n = ring_head;
+
+    /* Only the newest PORT_TRACE_RING_EVENTS frame-loop events survive */
+    if (n > PORT_TRACE_RING_EVENTS)
+        start = n - PORT_TRACE_RING_EVENTS;
+
+    serial_puts("\n{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint32_t i = 0; i < boot_count; i++)
+        dump_event(&boot_events[i], i == 0);
+    for (uint32_t i = start; i < n; i++)
+        dump_event(&ring[i % PORT_TRACE_RING_EVENTS], boot_count == 0 && i == start);
+    serial_puts("\n]}\n");
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * Timeline tracing, TSC-stamped relative to _start and dumped as Chrome
+ * trace-event JSON (load it in Perfetto or chrome://tracing).
+ *
+ * Event names are stored by pointer and must be string literals.
+ */
+#if PORT_TRACE
+void trace_init(void);
+void trace_begin(const char *name);
+void trace_end(const char *name);
+void trace_instant(const char *name);
+void trace_counter(const char *name, int32_t value);
+/* Switches recording from the boot buffer to the frame-loop ring */
+void trace_boot_done(void);
+/* Writes everything recorded so far to the serial port */
+void trace_dump(void);
+#else
+static inline void trace_init(void) {}
+static inline void trace_begin(const char *name) { (void)name; }
+static inline void trace_end(const char *name) { (void)name; }
+static inline void trace_instant(const char *name) { (void)name; }
+static inline void trace_counter(const char *name, int32_t value) { (void)name; (void)value; }
+static inline void trace_boot_done(void) {}
+static inline void trace_dump(void) {}
+#endif
+
+#endif
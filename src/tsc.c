@@ -0,0 +1,48 @@
+#include "tsc.h"
+#include "io.h"
+#include "snapshot.h"
+
+#define PIT_HZ        1193182
+#define PIT_CH2_DATA  0x42
+#define PIT_CMD       0x43
+#define PIT_CH2_GATE  0x61
+
+#define CALIBRATE_MS  10
+
+static uint32_t khz SNAPSHOT_SKIP;
+
+void tsc_calibrate(void) {
+    uint16_t count = PIT_HZ / 1000 * CALIBRATE_MS;
+
+    /* Gate channel 2 on with the speaker disconnected */
+    outb(PIT_CH2_GATE, (inb(PIT_CH2_GATE) & ~0x02) | 0x01);
+
+    /* Mode 0: OUT goes high once the count reaches zero */
+    outb(PIT_CMD, 0xB0);
+    outb(PIT_CH2_DATA, count & 0xFF);
+    outb(PIT_CH2_DATA, count >> 8);
+
+    uint64_t start = rdtsc();
+    while (!(inb(PIT_CH2_GATE) & 0x20));
+    uint64_t ticks = rdtsc() - start;
+
+    khz = (uint32_t)(ticks / CALIBRATE_MS);
+}
+
+uint32_t tsc_khz(void) {
+    return khz;
+}
+
+uint64_t tsc_to_us(uint64_t ticks, uint32_t *frac_ns) {
+    if (khz == 0) {
+        if (frac_ns)
+            *frac_ns = 0;
+        return 0;
+    }
+
+    uint64_t scaled = ticks * 1000;
+    uint64_t us = scaled / khz;
+    if (frac_ns)
+        *frac_ns = (uint32_t)((scaled - us * khz) * 1000 / khz);
+    return us;
+}
@@ -0,0 +1,22 @@
+#ifndef TSC_H
+#define TSC_H
+
+#include <stdint.h>
+
+/* Time-stamp counter value latched by _start in boot.S */
+extern uint64_t boot_tsc;
+
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Measures the TSC rate against PIT channel 2 (about 10 ms) */
+void tsc_calibrate(void);
+/* TSC ticks per millisecond, 0 before tsc_calibrate() */
+uint32_t tsc_khz(void);
+/* Converts a TSC delta to microseconds and the sub-microsecond nanoseconds */
+uint64_t tsc_to_us(uint64_t ticks, uint32_t *frac_ns);
+
+#endif
@@ -0,0 +1,323 @@
+import json
+import sys
+
+# Compiles a declarative UI description (ui.json) into C.
+#
+# Usage: python3 ui-gen.py ui.json ui_gen
+#
+# Writes ui_gen.h and ui_gen.c. Every entry of "styles" becomes a constant
+# style (LV_STYLE_CONST_INIT), so its properties live in .rodata and boot
+# does no lv_style_set_* calls. The "local" properties of a node become
+# constant styles too instead of heap-allocated local styles, and label
+# text is set with lv_label_set_text_static. Each entry of "screens"
+# becomes ui_<name>_create(parent, ui), which builds the tree inside one
+# ui_batch (ui_batch.h) and stores nodes with an "id" in ui_<name>_t.
+#
+# Node keys:
+#   type        obj | button | label | vlist
+#   id          name of the field in ui_<screen>_t
+#   width, height   pixels, "pct:N" or "content"
+#   align       LV_ALIGN_* suffix, e.g. "center"; x, y give the offset
+#   flex_flow   LV_FLEX_FLOW_* suffix, e.g. "column"
+#   flags       list of LV_OBJ_FLAG_* suffixes to add
+#   styles      list of [style name, selector]
+#   local       {selector: {property: value}}
+#   text        label text
+#   events      {event: C function}, e.g. {"clicked": "on_click"}
+#   children    list of nodes
+# vlist nodes also take rows, row_height, bind (C function) and row (the
+# node used for every pooled row).
+#
+# Selectors are "|"-separated LV_PART_*/LV_STATE_* suffixes, e.g.
+# "scrollbar|pressed". Property values are integers, "palette:NAME",
+# "#rrggbb" or LV_* constants.
+
+PALETTE = {
+    "RED": 0xF44336,
+    "PINK": 0xE91E63,
+    "PURPLE": 0x9C27B0,
+    "DEEP_PURPLE": 0x673AB7,
+    "INDIGO": 0x3F51B5,
+    "BLUE": 0x2196F3,
+    "LIGHT_BLUE": 0x03A9F4,
+    "CYAN": 0x00BCD4,
+    "TEAL": 0x009688,
+    "GREEN": 0x4CAF50,
+    "LIGHT_GREEN": 0x8BC34A,
+    "LIME": 0xCDDC39,
+    "YELLOW": 0xFFEB3B,
+    "AMBER": 0xFFC107,
+    "ORANGE": 0xFF9800,
+    "DEEP_ORANGE": 0xFF5722,
+    "BROWN": 0x795548,
+    "BLUE_GREY": 0x607D8B,
+    "GREY": 0x9E9E9E,
+}
+
+PARTS = ("main", "scrollbar", "indicator", "knob", "selected", "items", "cursor")
+
+CREATE = {
+    "obj": "lv_obj_create",
+    "button": "lv_button_create",
+    "label": "lv_label_create",
+}
+
+NODE_KEYS = {"type", "id", "width", "height", "align", "x", "y", "flex_flow",
+             "flags", "styles", "local", "text", "events", "children"}
+VLIST_KEYS = {"rows", "row_height", "bind", "row"}
+
+
+def fail(msg):
+    sys.stderr.write("ui-gen: %s\n" % msg)
+    sys.exit(1)
+
+
+def c_ident(name):
+    if not name.replace("_", "").isalnum() or name[0].isdigit():
+        fail("not a C identifier: %r" % name)
+    return name
+
+
+def c_string(text):
+    out = '"'
+    for ch in text:
+        if ch in '"\\':
+            out += "\\" + ch
+        elif ch == "\n":
+            out += "\\n"
+        elif 32 <= ord(ch) < 127:
+            out += ch
+        else:
+            for b in ch.encode("utf-8"):
+                out += "\\%03o" % b
+    return out + '"'
+
+
+def selector(sel):
+    terms = []
+    for tok in sel.split("|"):
+        tok = tok.strip().lower()
+        if tok in PARTS:
+            terms.append("LV_PART_" + tok.upper())
+        else:
+            terms.append("LV_STATE_" + tok.upper())
+    return " | ".join(terms)
+
+
+def color(value):
+    if value.startswith("palette:"):
+        name = value[len("palette:"):].upper()
+        if name not in PALETTE:
+            fail("unknown palette color %r" % value)
+        rgb = PALETTE[name]
+    elif value.startswith("#") and len(value) == 7:
+        rgb = int(value[1:], 16)
+    else:
+        return None
+    return "LV_COLOR_MAKE(0x%02X, 0x%02X, 0x%02X)" % (rgb >> 16, (rgb >> 8) & 0xFF, rgb & 0xFF)
+
+
+def prop_value(prop, value):
+    if isinstance(value, bool):
+        return "true" if value else "false"
+    if isinstance(value, int):
+        return str(value)
+    if isinstance(value, str):
+        c = color(value)
+        if c:
+            if not prop.endswith("color"):
+                fail("%s does not take a color" % prop)
+            return c
+        if value.startswith("LV_"):
+            return value
+    fail("bad value for %s: %r" % (prop, value))
+
+
+def size(value):
+    if isinstance(value, int):
+        return str(value)
+    if value == "content":
+        return "LV_SIZE_CONTENT"
+    if isinstance(value, str) and value.startswith("pct:"):
+        return "lv_pct(%d)" % int(value[4:])
+    fail("bad size %r" % value)
+
+
+class Gen:
+    def __init__(self, desc):
+        self.desc = desc
+        self.styles = []        # (c name, {prop: value})
+        self.style_names = {}
+        self.externs = []       # prototypes of callbacks the app provides
+        self.row_funcs = []     # row constructors for vlists
+        self.vlist = False
+
+    def const_style(self, name, props, static):
+        lines = ["static const lv_style_const_prop_t %s_props[] = {" % name]
+        for prop, value in props.items():
+            lines.append("    LV_STYLE_CONST_%s(%s)," % (c_ident(prop).upper(), prop_value(prop, value)))
+        lines.append("    LV_STYLE_CONST_PROPS_END")
+        lines.append("};")
+        lines.append("%sLV_STYLE_CONST_INIT(%s, %s_props);" % ("static " if static else "", name, name))
+        return "\n".join(lines)
+
+    def extern(self, proto):
+        if proto not in self.externs:
+            self.externs.append(proto)
+
+    def node(self, n, parent, var, out, prefix, ids, indent="    "):
+        t = n.get("type", "obj")
+        keys = NODE_KEYS | (VLIST_KEYS if t == "vlist" else set())
+        for k in n:
+            if k not in keys:
+                fail("%s: unknown key %r for %s" % (prefix, k, t))
+
+        name = n.get("id")
+        if t == "vlist":
+            self.vlist = True
+            if "bind" not in n or "row" not in n:
+                fail("%s: vlist needs bind and row" % prefix)
+            row_func = "%s_%s_row" % (prefix, c_ident(name or var))
+            self.row(n["row"], row_func)
+            bind = c_ident(n["bind"])
+            self.extern("void %s(lv_obj_t *row, uint32_t index, void *user_data);" % bind)
+            out.append("%svlist_config_t %s_cfg = {" % (indent, var))
+            out.append("%s    .row_count = %d," % (indent, int(n.get("rows", 0))))
+            out.append("%s    .row_height = %d," % (indent, int(n.get("row_height", 40))))
+            out.append("%s    .create_row = %s," % (indent, row_func))
+            out.append("%s    .bind = %s," % (indent, bind))
+            out.append("%s    .user_data = NULL," % indent)
+            out.append("%s};" % indent)
+            out.append("%slv_obj_t *%s = vlist_create(%s, &%s_cfg);" % (indent, var, parent, var))
+        elif t in CREATE:
+            out.append("%slv_obj_t *%s = %s(%s);" % (indent, var, CREATE[t], parent))
+        else:
+            fail("%s: unknown type %r" % (prefix, t))
+        created = len(out) - 1
+
+        if "width" in n or "height" in n:
+            out.append("%slv_obj_set_size(%s, %s, %s);" % (
+                indent, var, size(n.get("width", "content")), size(n.get("height", "content"))))
+        if "align" in n:
+            out.append("%slv_obj_align(%s, LV_ALIGN_%s, %d, %d);" % (
+                indent, var, n["align"].upper(), int(n.get("x", 0)), int(n.get("y", 0))))
+        elif "x" in n or "y" in n:
+            out.append("%slv_obj_set_pos(%s, %d, %d);" % (indent, var, int(n.get("x", 0)), int(n.get("y", 0))))
+        if "flex_flow" in n:
+            out.append("%slv_obj_set_flex_flow(%s, LV_FLEX_FLOW_%s);" % (indent, var, n["flex_flow"].upper()))
+        for flag in n.get("flags", []):
+            out.append("%slv_obj_add_flag(%s, LV_OBJ_FLAG_%s);" % (indent, var, flag.upper()))
+        for style, sel in n.get("styles", []):
+            if style not in self.style_names:
+                fail("%s: unknown style %r" % (prefix, style))
+            out.append("%slv_obj_add_style(%s, &%s, %s);" % (indent, var, self.style_names[style], selector(sel)))
+        for sel, props in n.get("local", {}).items():
+            sname = "%s_%s_%s" % (prefix, c_ident(name or var), "_".join(
+                tok.strip().lower() for tok in sel.split("|")))
+            self.styles.append((sname, props))
+            out.append("%slv_obj_add_style(%s, &%s, %s);" % (indent, var, sname, selector(sel)))
+        if "text" in n:
+            if t != "label":
+                fail("%s: text on a %s" % (prefix, t))
+            out.append("%slv_label_set_text_static(%s, %s);" % (indent, var, c_string(n["text"])))
+        for event, func in n.get("events", {}).items():
+            func = c_ident(func)
+            self.extern("void %s(lv_event_t *e);" % func)
+            out.append("%slv_obj_add_event_cb(%s, %s, LV_EVENT_%s, NULL);" % (indent, var, func, event.upper()))
+        if name is not None and ids is not None:
+            ids.append(c_ident(name))
+            out.append("%sui->%s = %s;" % (indent, name, var))
+
+        for i, child in enumerate(n.get("children", [])):
+            self.node(child, var, "%s_%d" % (var, i), out, prefix, ids, indent)
+
+        # Leaves without properties need no variable (-Wunused-variable)
+        if t in CREATE and len(out) == created + 1 and var not in ("o", "row"):
+            out[created] = "%s%s(%s);" % (indent, CREATE[t], parent)
+
+    def row(self, n, func):
+        out = ["static lv_obj_t *%s(lv_obj_t *list, void *user_data)" % func, "{",
+               "    (void)user_data;", ""]
+        self.node(n, "list", "row", out, func, None)
+        out.append("    return row;")
+        out.append("}")
+        self.row_funcs.append("\n".join(out))
+
+    def run(self, base):
+        for sname, props in self.desc.get("styles", {}).items():
+            self.style_names[sname] = "ui_style_" + c_ident(sname)
+            self.styles.append((self.style_names[sname], props))
+
+        screens = []
+        for sname, root in self.desc.get("screens", {}).items():
+            prefix = "ui_" + c_ident(sname)
+            ids = []
+            body = []
+            self.node(root, "parent", "o", body, prefix, ids)
+            screens.append((prefix, ids, body))
+
+        guard = base.upper().replace("-", "_") + "_H"
+        h = ["/* Generated by ui-gen.py from ui.json; do not edit */",
+             "#ifndef " + guard, "#define " + guard, "",
+             "#include <stdint.h>", '#include "lvgl/lvgl.h"', ""]
+        for name, _ in self.styles:
+            if name.startswith("ui_style_"):
+                h.append("extern const lv_style_t %s;" % name)
+        h.append("")
+        if self.externs:
+            h.append("/* Callbacks named in ui.json, provided by the application */")
+            h.extend(self.externs)
+            h.append("")
+        for prefix, ids, _ in screens:
+            h.append("typedef struct {")
+            for i in ids:
+                h.append("    lv_obj_t *%s;" % i)
+            if not ids:
+                h.append("    lv_obj_t *root;")
+            h.append("} %s_t;" % prefix)
+            h.append("")
+            h.append("/* Builds the screen under parent inside one ui_batch */")
+            h.append("void %s_create(lv_obj_t *parent, %s_t *ui);" % (prefix, prefix))
+            h.append("")
+        h.append("#endif")
+
+        c = ["/* Generated by ui-gen.py from ui.json; do not edit */",
+             '#include "%s.h"' % base, '#include "ui_batch.h"']
+        if self.vlist:
+            c.append('#include "vlist.h"')
+        c.append("")
+        for name, props in self.styles:
+            c.append(self.const_style(name, props, not name.startswith("ui_style_")))
+            c.append("")
+        for f in self.row_funcs:
+            c.append(f)
+            c.append("")
+        for prefix, ids, body in screens:
+            c.append("void %s_create(lv_obj_t *parent, %s_t *ui)" % (prefix, prefix))
+            c.append("{")
+            if not ids:
+                body.append("    ui->root = o;")
+            c.append("    ui_batch_begin();")
+            c.append("")
+            c.extend(body)
+            c.append("")
+            c.append("    ui_batch_commit(o);")
+            c.append("}")
+            c.append("")
+
+        with open(base + ".h", "w") as f:
+            f.write("\n".join(h) + "\n")
+        with open(base + ".c", "w") as f:
+            f.write("\n".join(c))
+
+
+def main():
+    if len(sys.argv) != 3:
+        fail("usage: ui-gen.py ui.json <output base name>")
+    with open(sys.argv[1]) as f:
+        desc = json.load(f)
+    Gen(desc).run(sys.argv[2])
+
+
+if __name__ == "__main__":
+    main()
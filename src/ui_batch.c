@@ -0,0 +1,125 @@
+#include "ui_batch.h"
+#include "heap.h"
+#include "serial.h"
+#include "trace.h"
+#include "tsc.h"
+
+static uint32_t depth;
+
+void ui_batch_begin(void) {
+    if (depth++ > 0)
+        return;
+
+    trace_begin("ui_batch");
+    lv_obj_enable_style_refresh(false);
+    lv_display_enable_invalidation(lv_display_get_default(), false);
+}
+
+void ui_batch_commit(lv_obj_t *root) {
+    if (depth == 0 || --depth > 0)
+        return;
+
+    lv_obj_enable_style_refresh(true);
+    lv_obj_refresh_style(root, LV_PART_ANY, LV_STYLE_PROP_ANY);
+    lv_obj_update_layout(root);
+
+    lv_display_enable_invalidation(lv_display_get_default(), true);
+    lv_obj_invalidate(lv_obj_get_screen(root));
+    trace_end("ui_batch");
+}
+
+/* A column of checkable buttons styled like create_ui() */
+static lv_obj_t *build(lv_obj_t *parent, int count, lv_style_t *styles) {
+    lv_obj_t *list = lv_obj_create(parent);
+    lv_obj_set_size(list, lv_pct(100), lv_pct(100));
+    lv_obj_set_flex_flow(list, LV_FLEX_FLOW_COLUMN);
+
+    for (int i = 0; i < count; i++) {
+        lv_obj_t *btn = lv_button_create(list);
+        lv_group_remove_obj(btn);
+        lv_obj_set_size(btn, lv_pct(100), LV_SIZE_CONTENT);
+        lv_obj_add_flag(btn, LV_OBJ_FLAG_CHECKABLE);
+        lv_obj_add_style(btn, &styles[0], LV_STATE_DEFAULT);
+        lv_obj_add_style(btn, &styles[1], LV_STATE_CHECKED);
+        lv_obj_add_style(btn, &styles[2], LV_STATE_FOCUSED);
+
+        lv_obj_t *label = lv_label_create(btn);
+        lv_label_set_text_fmt(label, "List item %d", i);
+    }
+    return list;
+}
+
+/* Heap bytes one item takes, measured on a small build */
+static uint32_t bytes_per_item(lv_style_t *styles) {
+    heap_stats_t before, after;
+
+    heap_get_stats(&before);
+    lv_obj_t *list = build(lv_screen_active(), 10, styles);
+    heap_get_stats(&after);
+    lv_obj_delete(list);
+    return (after.used_size - before.used_size) / 10;
+}
+
+static uint32_t time_build(int count, int batched, lv_style_t *styles) {
+    lv_obj_t *screen = lv_screen_active();
+    uint64_t t0 = rdtsc();
+    lv_obj_t *list;
+
+    if (batched) {
+        ui_batch_begin();
+        list = build(screen, count, styles);
+        ui_batch_commit(list);
+    } else {
+        list = build(screen, count, styles);
+        lv_obj_update_layout(list);
+    }
+
+    uint64_t ticks = rdtsc() - t0;
+    lv_obj_delete(list);
+
+    uint32_t frac;
+    return (uint32_t)tsc_to_us(ticks, &frac);
+}
+
+void ui_batch_bench(void) {
+    static const int counts[] = { 10, 100, 1000 };
+    lv_style_t styles[3];
+
+    lv_style_init(&styles[0]);
+    lv_style_set_bg_color(&styles[0], lv_palette_main(LV_PALETTE_BLUE_GREY));
+    lv_style_init(&styles[1]);
+    lv_style_set_bg_color(&styles[1], lv_palette_main(LV_PALETTE_ORANGE));
+    lv_style_init(&styles[2]);
+    lv_style_set_outline_width(&styles[2], 3);
+
+    uint32_t per_item = bytes_per_item(styles);
+
+    serial_puts("\n# --- screen build time ---\n");
+    serial_printf("# items are a button and a label, ~%u heap bytes each\n",
+                  (unsigned)per_item);
+    serial_puts("#    items    direct us   batched us\n");
+    for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        heap_stats_t st;
+        heap_get_stats(&st);
+
+        /* The whole list or nothing: splitting it would hide the cost that
+         * grows with the child count. Leave a quarter for label text and
+         * fragmentation. */
+        uint32_t need = per_item * (uint32_t)counts[i] / 4 * 5;
+        if (need > st.largest_free) {
+            serial_printf("%10d  not measured: needs ~%u KiB of heap, %u KiB free\n",
+                          counts[i], (unsigned)(need / 1024),
+                          (unsigned)(st.largest_free / 1024));
+            continue;
+        }
+
+        uint32_t direct = time_build(counts[i], 0, styles);
+        uint32_t batched = time_build(counts[i], 1, styles);
+        serial_printf("%10d %12u %12u\n", counts[i],
+                      (unsigned)direct, (unsigned)batched);
+    }
+    serial_puts("# --- end ---\n");
+
+    for (int i = 0; i < 3; i++)
+        lv_style_reset(&styles[i]);
+}
@@ -0,0 +1,28 @@
+#ifndef UI_BATCH_H
+#define UI_BATCH_H
+
+#include "lvgl/lvgl.h"
+
+/*
+ * Bulk construction. Between ui_batch_begin() and ui_batch_commit(),
+ * nothing is invalidated; the commit refreshes the styles of `root` and
+ * its descendants, runs one layout pass and invalidates the screen once.
+ * Batches nest; only the outermost commit does the work.
+ *
+ * Style refreshes are only held off until the next object is created:
+ * lv_obj_class_init_obj() turns them back on for every new object, so
+ * only invalidation is reliably batched.
+ *
+ * Everything created or changed inside the batch should be under root.
+ * Focus objects (lv_group_focus_obj) after the commit, since focusing
+ * scrolls to the object and needs the final layout.
+ */
+void ui_batch_begin(void);
+void ui_batch_commit(lv_obj_t *root);
+
+/* Builds and deletes create_ui()-like lists of 10/100/1000 items with and
+ * without a batch and prints the times to the serial port. Sizes that do
+ * not fit in the heap are reported as not measured */
+void ui_batch_bench(void);
+
+#endif
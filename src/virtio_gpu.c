@@ -0,0 +1,533 @@
+#include <stddef.h>
+#include "virtio_gpu.h"
+
+#if PORT_VIRTIO_GPU
+
+#include "cmdline.h"
+#include "pci.h"
+#include "serial.h"
+#include "snapshot.h"
+#include "timer.h"
+#include "vbe.h"
+
+void *memcpy(void *dest, const void *src, size_t n);
+
+#define VIRTIO_VENDOR           0x1AF4
+#define VIRTIO_GPU_DEVICE       0x1050      /* 0x1040 + device type 16 */
+
+/* Virtio vendor capability in PCI config space */
+#define PCI_CAP_VENDOR          0x09
+#define CAP_COMMON_CFG          1
+#define CAP_NOTIFY_CFG          2
+
+#define STATUS_ACKNOWLEDGE      0x01
+#define STATUS_DRIVER           0x02
+#define STATUS_DRIVER_OK        0x04
+#define STATUS_FEATURES_OK      0x08
+
+#define VIRTIO_F_VERSION_1      (1u << 0)   /* In feature word 1 */
+#define NO_VECTOR               0xFFFF
+
+#define DESC_F_NEXT             1
+#define DESC_F_WRITE            2
+#define USED_F_NO_NOTIFY        1
+
+#define CMD_RESOURCE_CREATE_2D  0x0101
+#define CMD_SET_SCANOUT         0x0103
+#define CMD_RESOURCE_FLUSH      0x0104
+#define CMD_TRANSFER_TO_HOST_2D 0x0105
+#define CMD_ATTACH_BACKING      0x0106
+#define CMD_UPDATE_CURSOR       0x0300
+#define CMD_MOVE_CURSOR         0x0301
+#define RESP_OK_NODATA          0x1100
+
+#define FORMAT_B8G8R8A8         1
+#define FORMAT_B8G8R8X8         2
+
+#define CONTROLQ                0
+#define CURSORQ                 1
+/* Descriptors per queue, at most; each command takes two */
+#define QUEUE_SIZE              64
+#define REQ_MAX                 64
+
+#define SCREEN_ID               1
+#define CURSOR_ID               2
+#define CURSOR_SIZE             64
+#define SCREEN_W                PORT_VIRTIO_GPU_WIDTH
+#define SCREEN_H                PORT_VIRTIO_GPU_HEIGHT
+
+/* Ticks to wait for the device before giving up on a command */
+#define TIMEOUT                 (PORT_TIMER_HZ / 10)
+
+#define barrier() asm volatile ("" ::: "memory")
+
+/* virtio_pci_common_cfg; 64-bit fields written as two halves */
+typedef volatile struct {
+    uint32_t device_feature_select;
+    uint32_t device_feature;
+    uint32_t driver_feature_select;
+    uint32_t driver_feature;
+    uint16_t msix_config;
+    uint16_t num_queues;
+    uint8_t device_status;
+    uint8_t config_generation;
+    uint16_t queue_select;
+    uint16_t queue_size;
+    uint16_t queue_msix_vector;
+    uint16_t queue_enable;
+    uint16_t queue_notify_off;
+    uint32_t queue_desc[2];
+    uint32_t queue_driver[2];
+    uint32_t queue_device[2];
+} common_cfg_t;
+
+typedef struct {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} desc_t;
+
+typedef struct {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t fence_id;
+    uint32_t ctx_id;
+    uint8_t ring_idx;
+    uint8_t padding[3];
+} gpu_hdr_t;
+
+typedef struct {
+    uint32_t x, y, w, h;
+} gpu_rect_t;
+
+typedef struct {
+    gpu_hdr_t hdr;
+    uint32_t resource_id;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+} gpu_create_2d_t;
+
+/* One backing entry: the buffer is contiguous */
+typedef struct {
+    gpu_hdr_t hdr;
+    uint32_t resource_id;
+    uint32_t nr_entries;
+    uint64_t addr;
+    uint32_t length;
+    uint32_t padding;
+} gpu_attach_backing_t;
+
+typedef struct {
+    gpu_hdr_t hdr;
+    gpu_rect_t r;
+    uint32_t scanout_id;
+    uint32_t resource_id;
+} gpu_set_scanout_t;
+
+typedef struct {
+    gpu_hdr_t hdr;
+    gpu_rect_t r;
+    uint64_t offset;            /* Of the rect's first pixel in the backing */
+    uint32_t resource_id;
+    uint32_t padding;
+} gpu_transfer_t;
+
+typedef struct {
+    gpu_hdr_t hdr;
+    gpu_rect_t r;
+    uint32_t resource_id;
+    uint32_t padding;
+} gpu_flush_t;
+
+typedef struct {
+    gpu_hdr_t hdr;
+    uint32_t scanout_id;
+    uint32_t x, y;
+    uint32_t padding;
+    uint32_t resource_id;
+    uint32_t hot_x, hot_y;
+    uint32_t padding2;
+} gpu_cursor_t;
+
+/* A command's request and response, described by descriptors 2n and
+ * 2n + 1 of its queue */
+typedef struct {
+    uint8_t req[REQ_MAX];
+    gpu_hdr_t resp;
+} slot_t;
+
+typedef struct {
+    desc_t desc[QUEUE_SIZE];
+    struct {
+        uint16_t flags;
+        uint16_t idx;
+        uint16_t ring[QUEUE_SIZE];
+        uint16_t used_event;
+    } avail;
+    struct {
+        uint16_t flags;
+        uint16_t idx;
+        struct {
+            uint32_t id;
+            uint32_t len;
+        } ring[QUEUE_SIZE];
+        uint16_t avail_event;
+    } used __attribute__((aligned(4)));
+    slot_t slots[QUEUE_SIZE / 2];
+    uint8_t busy[QUEUE_SIZE / 2];
+    uint16_t size;              /* Descriptors in use, a power of two */
+    uint16_t index;
+    uint16_t last_used;
+    uint16_t next_slot;
+    int respond;                /* The cursor queue sends no responses */
+    volatile uint16_t *notify;
+} queue_t;
+
+/* Device state and buffers are per boot; a warm boot sets them up again */
+static queue_t controlq __attribute__((aligned(4096))) SNAPSHOT_SKIP;
+static queue_t cursorq __attribute__((aligned(4096))) SNAPSHOT_SKIP;
+static uint32_t screen[SCREEN_W * SCREEN_H] __attribute__((aligned(4096))) SNAPSHOT_SKIP;
+static uint32_t cursor[CURSOR_SIZE * CURSOR_SIZE] __attribute__((aligned(4096))) SNAPSHOT_SKIP;
+
+static common_cfg_t *common SNAPSHOT_SKIP;
+static uint32_t notify_base SNAPSHOT_SKIP;
+static uint32_t notify_mult SNAPSHOT_SKIP;
+static int active SNAPSHOT_SKIP;
+static int32_t cursor_x SNAPSHOT_SKIP;
+static int32_t cursor_y SNAPSHOT_SKIP;
+static virtio_gpu_stats_t stats SNAPSHOT_SKIP;
+
+static int find_caps(uint16_t bdf) {
+    if (!(pci_read16(bdf, PCI_STATUS) & PCI_STATUS_CAP_LIST))
+        return -1;
+
+    uint8_t cap = pci_read8(bdf, PCI_CAP_PTR) & 0xFC;
+    while (cap) {
+        if (pci_read8(bdf, cap) == PCI_CAP_VENDOR) {
+            uint8_t type = pci_read8(bdf, (uint8_t)(cap + 3));
+            uint32_t base = pci_bar_address(bdf, pci_read8(bdf, (uint8_t)(cap + 4)));
+            uint32_t offset = pci_read32(bdf, (uint8_t)(cap + 8));
+            if (base && type == CAP_COMMON_CFG && !common) {
+                common = (common_cfg_t *)(base + offset);
+            } else if (base && type == CAP_NOTIFY_CFG && !notify_base) {
+                notify_base = base + offset;
+                notify_mult = pci_read32(bdf, (uint8_t)(cap + 16));
+            }
+        }
+        cap = pci_read8(bdf, (uint8_t)(cap + 1)) & 0xFC;
+    }
+    return common && notify_base ? 0 : -1;
+}
+
+static int setup_queue(queue_t *q, uint16_t index, int respond) {
+    common->queue_select = index;
+    uint16_t max = common->queue_size;
+    if (max < 2)
+        return -1;
+
+    q->size = QUEUE_SIZE;
+    while (q->size > max)
+        q->size >>= 1;
+    q->index = index;
+    q->respond = respond;
+    for (uint16_t i = 0; i < q->size / 2; i++) {
+        q->desc[2 * i] = (desc_t){ (uintptr_t)q->slots[i].req, 0, 0, 0 };
+        q->desc[2 * i + 1] = (desc_t){ (uintptr_t)&q->slots[i].resp, sizeof(gpu_hdr_t),
+                                       DESC_F_WRITE, 0 };
+    }
+
+    common->queue_size = q->size;
+    common->queue_msix_vector = NO_VECTOR;
+    common->queue_desc[0] = (uintptr_t)q->desc;
+    common->queue_desc[1] = 0;
+    common->queue_driver[0] = (uintptr_t)&q->avail;
+    common->queue_driver[1] = 0;
+    common->queue_device[0] = (uintptr_t)&q->used;
+    common->queue_device[1] = 0;
+    q->notify = (volatile uint16_t *)(notify_base + common->queue_notify_off * notify_mult);
+    common->queue_enable = 1;
+    return 0;
+}
+
+static int setup_device(uint16_t bdf) {
+    pci_write16(bdf, PCI_COMMAND,
+                pci_read16(bdf, PCI_COMMAND) | PCI_COMMAND_MEMORY | PCI_COMMAND_MASTER);
+    if (find_caps(bdf) < 0)
+        return -1;
+
+    common->device_status = 0;
+    uint32_t start = timer_ticks();
+    while (common->device_status) {
+        if (timer_ticks() - start > TIMEOUT)
+            return -1;
+    }
+    common->device_status = STATUS_ACKNOWLEDGE | STATUS_DRIVER;
+
+    /* Only VIRTIO_F_VERSION_1; no interrupts, event index or EDID */
+    common->device_feature_select = 1;
+    if (!(common->device_feature & VIRTIO_F_VERSION_1))
+        return -1;
+    common->driver_feature_select = 0;
+    common->driver_feature = 0;
+    common->driver_feature_select = 1;
+    common->driver_feature = VIRTIO_F_VERSION_1;
+    common->device_status |= STATUS_FEATURES_OK;
+    if (!(common->device_status & STATUS_FEATURES_OK))
+        return -1;
+
+    if (setup_queue(&controlq, CONTROLQ, 1) < 0 || setup_queue(&cursorq, CURSORQ, 0) < 0)
+        return -1;
+    common->device_status |= STATUS_DRIVER_OK;
+    return 0;
+}
+
+/* Frees the slots of completed commands */
+static void reclaim(queue_t *q) {
+    volatile uint16_t *used_idx = &q->used.idx;
+
+    while (q->last_used != *used_idx) {
+        barrier();
+        uint32_t slot = q->used.ring[q->last_used & (q->size - 1)].id / 2;
+        if (q->respond && q->slots[slot].resp.type != RESP_OK_NODATA)
+            stats.errors++;
+        q->busy[slot] = 0;
+        q->last_used++;
+    }
+}
+
+static int wait_slot(queue_t *q, uint16_t slot) {
+    uint32_t start = timer_ticks();
+
+    for (;;) {
+        reclaim(q);
+        if (!q->busy[slot])
+            return 0;
+        if (timer_ticks() - start > TIMEOUT)
+            return -1;
+    }
+}
+
+/* Queues a command without telling the device; returns its slot, or -1
+ * if the device has stopped taking commands */
+static int submit(queue_t *q, const void *req, uint32_t len) {
+    uint16_t slot = q->next_slot;
+
+    reclaim(q);
+    if (q->busy[slot]) {
+        stats.waits++;
+        if (wait_slot(q, slot) < 0) {
+            stats.errors++;
+            return -1;
+        }
+    }
+
+    memcpy(q->slots[slot].req, req, len);
+    q->slots[slot].resp.type = 0;
+    desc_t *d = &q->desc[2 * slot];
+    d->len = len;
+    d->flags = q->respond ? DESC_F_NEXT : 0;
+    d->next = (uint16_t)(2 * slot + 1);
+
+    q->avail.ring[q->avail.idx & (q->size - 1)] = (uint16_t)(2 * slot);
+    barrier();
+    q->avail.idx++;
+    q->busy[slot] = 1;
+    q->next_slot = (uint16_t)((slot + 1) % (q->size / 2));
+    return slot;
+}
+
+static void kick(queue_t *q) {
+    barrier();
+    if (!(*(volatile uint16_t *)&q->used.flags & USED_F_NO_NOTIFY))
+        *q->notify = q->index;
+}
+
+/* Runs a setup command to completion */
+static int command(queue_t *q, const void *req, uint32_t len) {
+    int slot = submit(q, req, len);
+    if (slot < 0)
+        return -1;
+    kick(q);
+    if (wait_slot(q, (uint16_t)slot) < 0)
+        return -1;
+    return !q->respond || q->slots[slot].resp.type == RESP_OK_NODATA ? 0 : -1;
+}
+
+static int create_resource(uint32_t id, uint32_t format, uint32_t w, uint32_t h,
+                           const uint32_t *backing) {
+    gpu_create_2d_t create = { .hdr.type = CMD_RESOURCE_CREATE_2D, .resource_id = id,
+                               .format = format, .width = w, .height = h };
+    gpu_attach_backing_t attach = { .hdr.type = CMD_ATTACH_BACKING, .resource_id = id,
+                                    .nr_entries = 1, .addr = (uintptr_t)backing,
+                                    .length = w * h * 4 };
+
+    if (command(&controlq, &create, sizeof(create)) < 0)
+        return -1;
+    return command(&controlq, &attach, sizeof(attach));
+}
+
+static gpu_transfer_t transfer_cmd(uint32_t id, uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+                                   uint32_t pitch) {
+    return (gpu_transfer_t){ .hdr.type = CMD_TRANSFER_TO_HOST_2D, .r = { x, y, w, h },
+                             .offset = (uint64_t)y * pitch + x * 4, .resource_id = id };
+}
+
+static void send_rect(int32_t x, int32_t y, int32_t w, int32_t h) {
+    /* Clipped to the screen, like fb_blit() */
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > SCREEN_W)
+        w = SCREEN_W - x;
+    if (y + h > SCREEN_H)
+        h = SCREEN_H - y;
+    if (w <= 0 || h <= 0)
+        return;
+
+    gpu_rect_t r = { (uint32_t)x, (uint32_t)y, (uint32_t)w, (uint32_t)h };
+    gpu_transfer_t transfer = transfer_cmd(SCREEN_ID, r.x, r.y, r.w, r.h, SCREEN_W * 4);
+    gpu_flush_t flush = { .hdr.type = CMD_RESOURCE_FLUSH, .r = r, .resource_id = SCREEN_ID };
+
+    submit(&controlq, &transfer, sizeof(transfer));
+    submit(&controlq, &flush, sizeof(flush));
+    kick(&controlq);
+
+    stats.rects++;
+    stats.bytes += (uint64_t)r.w * r.h * 4;
+}
+
+void virtio_gpu_flush(int32_t x, int32_t y, int32_t w, int32_t h, int last) {
+    if (!active)
+        return;
+
+    send_rect(x, y, w, h);
+    if (last) {
+        stats.frames++;
+        stats.full_bytes += SCREEN_W * SCREEN_H * 4;
+    }
+}
+
+void virtio_gpu_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx, int32_t dy) {
+    if (active)
+        send_rect(x + dx, y + dy, w, h);
+}
+
+static void cursor_cmd(uint32_t type, uint32_t hot_x, uint32_t hot_y) {
+    gpu_cursor_t c = { .hdr.type = type, .x = (uint32_t)cursor_x, .y = (uint32_t)cursor_y,
+                       .resource_id = CURSOR_ID, .hot_x = hot_x, .hot_y = hot_y };
+    submit(&cursorq, &c, sizeof(c));
+    kick(&cursorq);
+}
+
+/* Sends the cursor image and shows it; the host copy must be current
+ * before the cursor queue refers to it */
+static void show_cursor(uint32_t hot_x, uint32_t hot_y) {
+    gpu_transfer_t transfer = transfer_cmd(CURSOR_ID, 0, 0, CURSOR_SIZE, CURSOR_SIZE,
+                                           CURSOR_SIZE * 4);
+    if (command(&controlq, &transfer, sizeof(transfer)) == 0)
+        cursor_cmd(CMD_UPDATE_CURSOR, hot_x, hot_y);
+}
+
+void virtio_gpu_cursor_set(const uint32_t *argb, uint32_t hot_x, uint32_t hot_y) {
+    if (!active)
+        return;
+    memcpy(cursor, argb, sizeof(cursor));
+    show_cursor(hot_x, hot_y);
+}
+
+void virtio_gpu_cursor_move(int32_t x, int32_t y) {
+    if (!active)
+        return;
+
+    cursor_x = x < 0 ? 0 : x;
+    cursor_y = y < 0 ? 0 : y;
+    cursor_cmd(CMD_MOVE_CURSOR, 0, 0);
+    stats.cursor_moves++;
+}
+
+/* White arrow with a black outline, hotspot at its tip */
+static void default_cursor(uint32_t *px) {
+    for (uint32_t i = 0; i < CURSOR_SIZE * CURSOR_SIZE; i++)
+        px[i] = 0;
+    for (uint32_t y = 0; y < 16; y++) {
+        uint32_t edge = y * 3 / 4;
+        for (uint32_t x = 0; x <= edge; x++) {
+            int outline = x == 0 || x == edge || y == 15;
+            px[y * CURSOR_SIZE + x] = outline ? 0xFF000000 : 0xFFFFFFFF;
+        }
+    }
+}
+
+void virtio_gpu_init(void *mboot_info) {
+    uint16_t bdf;
+
+    if (!cmdline_is(mboot_info, "display", "virtio"))
+        return;
+    if (pci_find(VIRTIO_VENDOR, VIRTIO_GPU_DEVICE, &bdf) < 0) {
+        serial_puts("virtio-gpu: no device, staying on VBE\n");
+        return;
+    }
+
+    gpu_set_scanout_t scanout = { .hdr.type = CMD_SET_SCANOUT,
+                                  .r = { 0, 0, SCREEN_W, SCREEN_H },
+                                  .resource_id = SCREEN_ID };
+    if (setup_device(bdf) < 0 ||
+        create_resource(SCREEN_ID, FORMAT_B8G8R8X8, SCREEN_W, SCREEN_H, screen) < 0 ||
+        command(&controlq, &scanout, sizeof(scanout)) < 0) {
+        if (common)
+            common->device_status = 0;
+        serial_puts("virtio-gpu: setup failed, staying on VBE\n");
+        return;
+    }
+
+    /* Everything that draws goes through vbe_get_info() */
+    vbe_info_t *vbe = vbe_get_info();
+    vbe->framebuffer = screen;
+    vbe->width = SCREEN_W;
+    vbe->height = SCREEN_H;
+    vbe->pitch = SCREEN_W * 4;
+    vbe->bpp = 32;
+    active = 1;
+
+    serial_printf("virtio-gpu: %ux%u on %02x:%02x.%u\n", (unsigned)SCREEN_W,
+                  (unsigned)SCREEN_H, (unsigned)(bdf >> 8), (unsigned)((bdf >> 3) & 0x1F),
+                  (unsigned)(bdf & 7));
+
+    if (create_resource(CURSOR_ID, FORMAT_B8G8R8A8, CURSOR_SIZE, CURSOR_SIZE, cursor) == 0) {
+        default_cursor(cursor);
+        cursor_x = SCREEN_W / 2;
+        cursor_y = SCREEN_H / 2;
+        show_cursor(0, 0);
+    }
+}
+
+int virtio_gpu_active(void) {
+    return active;
+}
+
+void virtio_gpu_get_stats(virtio_gpu_stats_t *out) {
+    *out = stats;
+}
+
+void virtio_gpu_dump(void) {
+    if (!active) {
+        serial_puts("virtio-gpu: not in use (boot with display=virtio)\n");
+        return;
+    }
+    serial_printf("virtio-gpu: %ux%u, frames %u, rects %u\n", (unsigned)SCREEN_W,
+                  (unsigned)SCREEN_H, (unsigned)stats.frames, (unsigned)stats.rects);
+    serial_printf("  transferred %u KB, full frames would be %u KB (%u%%)\n",
+                  (unsigned)(stats.bytes / 1024), (unsigned)(stats.full_bytes / 1024),
+                  (unsigned)(stats.full_bytes ? stats.bytes * 100 / stats.full_bytes : 0));
+    serial_printf("  slot waits %u, errors %u, cursor moves %u\n", (unsigned)stats.waits,
+                  (unsigned)stats.errors, (unsigned)stats.cursor_moves);
+}
+
+#endif
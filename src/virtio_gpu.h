@@ -0,0 +1,69 @@
+#ifndef VIRTIO_GPU_H
+#define VIRTIO_GPU_H
+
+#include <stdint.h>
+#include "port_conf.h"
+
+/*
+ * virtio-gpu 2D display backend, chosen with "display=virtio" on the
+ * kernel command line (make run-virtio). The framebuffer moves into a
+ * RAM buffer of PORT_VIRTIO_GPU_WIDTH x PORT_VIRTIO_GPU_HEIGHT, attached
+ * as the backing of a host resource shown on scanout 0. vbe_get_info()
+ * then points there, so every writer of the framebuffer is unchanged.
+ * The host only sees what is transferred: each flushed area and each
+ * fb_move() destination is sent with TRANSFER_TO_HOST_2D followed by a
+ * RESOURCE_FLUSH of the same rect. Commands are queued without waiting
+ * for the device. The driver only waits when all command slots are in
+ * use. A 64x64 cursor resource goes on the cursor queue, so a pointer
+ * moves without redrawing anything. Without the device, the VBE
+ * framebuffer stays in use.
+ */
+typedef struct {
+    uint32_t rects;             /* Rects transferred */
+    uint64_t bytes;             /* Pixel bytes transferred */
+    uint64_t full_bytes;        /* Bytes had each frame sent the whole screen */
+    uint32_t frames;
+    uint32_t waits;             /* Submissions that found every slot in use */
+    uint32_t errors;            /* Commands the device did not answer OK */
+    uint32_t cursor_moves;
+} virtio_gpu_stats_t;
+
+#if PORT_VIRTIO_GPU
+/* Takes over the display if "display=virtio" is given and the device is
+ * there; call every boot after vbe_init() and before anything draws */
+void virtio_gpu_init(void *mboot_info);
+/* Nonzero when the framebuffer is shown through virtio-gpu */
+int virtio_gpu_active(void);
+/* Called by the flush callback after an area reached the framebuffer;
+ * last is set on the final area of a frame */
+void virtio_gpu_flush(int32_t x, int32_t y, int32_t w, int32_t h, int last);
+/* Sends the destination of an fb_move() with the same arguments */
+void virtio_gpu_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx, int32_t dy);
+/* Replaces the cursor image: 64x64 ARGB8888, hotspot in pixels. The
+ * demo keeps the default arrow and moves it to the focused row. */
+void virtio_gpu_cursor_set(const uint32_t *argb, uint32_t hot_x, uint32_t hot_y);
+void virtio_gpu_cursor_move(int32_t x, int32_t y);
+void virtio_gpu_get_stats(virtio_gpu_stats_t *stats);
+/* Prints the stats on serial ('u' command) */
+void virtio_gpu_dump(void);
+#else
+static inline void virtio_gpu_init(void *mboot_info) { (void)mboot_info; }
+static inline int virtio_gpu_active(void) { return 0; }
+static inline void virtio_gpu_flush(int32_t x, int32_t y, int32_t w, int32_t h, int last) {
+    (void)x; (void)y; (void)w; (void)h; (void)last;
+}
+static inline void virtio_gpu_move(int32_t x, int32_t y, int32_t w, int32_t h, int32_t dx,
+                                   int32_t dy) {
+    (void)x; (void)y; (void)w; (void)h; (void)dx; (void)dy;
+}
+static inline void virtio_gpu_cursor_set(const uint32_t *argb, uint32_t hot_x, uint32_t hot_y) {
+    (void)argb; (void)hot_x; (void)hot_y;
+}
+static inline void virtio_gpu_cursor_move(int32_t x, int32_t y) { (void)x; (void)y; }
+static inline void virtio_gpu_get_stats(virtio_gpu_stats_t *stats) {
+    *stats = (virtio_gpu_stats_t){ 0 };
+}
+static inline void virtio_gpu_dump(void) {}
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+#include "vlist.h"
+
+/* Rows kept bound above and below the view, so small scroll steps rebind
+ * only rows that are off screen */
+#define VLIST_MARGIN 2
+
+typedef struct {
+    lv_obj_t *obj;
+    uint32_t index;         /* Bound data row, VLIST_NONE if unused */
+} vlist_slot_t;
+
+typedef struct {
+    vlist_config_t cfg;
+    uint32_t focused;
+    vlist_slot_t *slots;
+    uint32_t slot_cnt;
+} vlist_t;
+
+static vlist_t *get(lv_obj_t *list) {
+    return lv_obj_get_user_data(list);
+}
+
+static int32_t pitch(lv_obj_t *list, const vlist_t *v) {
+    return v->cfg.row_height + lv_obj_get_style_pad_row(list, LV_PART_MAIN);
+}
+
+static lv_obj_t *default_row(lv_obj_t *list, void *user_data) {
+    (void)user_data;
+    lv_obj_t *row = lv_button_create(list);
+    lv_label_create(row);
+    return row;
+}
+
+static void apply_focus(lv_obj_t *list, vlist_t *v, vlist_slot_t *s) {
+    lv_state_t st = LV_STATE_FOCUSED | LV_STATE_FOCUS_KEY;
+    int on = s->index == v->focused && lv_obj_has_state(list, LV_STATE_FOCUSED);
+
+    if (on && !lv_obj_has_state(s->obj, st))
+        lv_obj_add_state(s->obj, st);
+    else if (!on && lv_obj_has_state(s->obj, LV_STATE_FOCUSED))
+        lv_obj_remove_state(s->obj, st);
+}
+
+static void bind_slot(lv_obj_t *list, vlist_t *v, vlist_slot_t *s, uint32_t index) {
+    s->index = index;
+    lv_obj_remove_flag(s->obj, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_y(s->obj, (int32_t)index * pitch(list, v));
+    v->cfg.bind(s->obj, index, v->cfg.user_data);
+}
+
+/* Binds the rows around the scroll position. Row i always lives in slot
+ * i % slot_cnt, so rows that stay in the window keep their object */
+static void update_window(lv_obj_t *list, vlist_t *v, int force) {
+    if (v->slot_cnt == 0)
+        return;
+
+    int32_t p = pitch(list, v);
+    int32_t top = lv_obj_get_scroll_y(list);
+    uint32_t first = top > 0 ? (uint32_t)(top / p) : 0;
+    first = first > VLIST_MARGIN ? first - VLIST_MARGIN : 0;
+
+    for (uint32_t i = 0; i < v->slot_cnt; i++) {
+        uint32_t index = first + i;
+        vlist_slot_t *s = &v->slots[index % v->slot_cnt];
+
+        if (index >= v->cfg.row_count) {
+            s->index = VLIST_NONE;
+            lv_obj_add_flag(s->obj, LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+        if (force || s->index != index)
+            bind_slot(list, v, s, index);
+        apply_focus(list, v, s);
+    }
+}
+
+/* Enough rows to cover the content height plus the margins */
+static void resize_pool(lv_obj_t *list, vlist_t *v) {
+    int32_t h = lv_obj_get_content_height(list);
+    uint32_t need = (uint32_t)(h / pitch(list, v)) + 2 + 2 * VLIST_MARGIN;
+
+    if (need <= v->slot_cnt)
+        return;
+
+    vlist_slot_t *slots = lv_realloc(v->slots, need * sizeof(*slots));
+    LV_ASSERT_MALLOC(slots);
+    if (!slots)
+        return;
+
+    for (uint32_t i = v->slot_cnt; i < need; i++) {
+        vlist_create_row_cb_t create = v->cfg.create_row ? v->cfg.create_row : default_row;
+        lv_obj_t *row = create(list, v->cfg.user_data);
+
+        /* The list owns focus; rows only mirror it */
+        lv_group_remove_obj(row);
+        lv_obj_remove_flag(row, LV_OBJ_FLAG_CLICK_FOCUSABLE | LV_OBJ_FLAG_SCROLL_ON_FOCUS |
+                                LV_OBJ_FLAG_CHECKABLE);
+        lv_obj_add_flag(row, LV_OBJ_FLAG_EVENT_BUBBLE);
+        lv_obj_set_size(row, lv_pct(100), v->cfg.row_height);
+
+        slots[i].obj = row;
+        slots[i].index = VLIST_NONE;
+    }
+
+    v->slots = slots;
+    v->slot_cnt = need;
+    /* The index -> slot mapping changed */
+    for (uint32_t i = 0; i < need; i++)
+        slots[i].index = VLIST_NONE;
+}
+
+static void scroll_into_view(lv_obj_t *list, vlist_t *v, uint32_t index, lv_anim_enable_t anim) {
+    int32_t y = (int32_t)index * pitch(list, v);
+    int32_t top = lv_obj_get_scroll_y(list);
+    int32_t h = lv_obj_get_content_height(list);
+
+    if (y < top)
+        lv_obj_scroll_to_y(list, y, anim);
+    else if (y + v->cfg.row_height > top + h)
+        lv_obj_scroll_to_y(list, y + v->cfg.row_height - h, anim);
+}
+
+static void event_cb(lv_event_t *e) {
+    lv_obj_t *list = lv_event_get_current_target(e);
+    vlist_t *v = get(list);
+    lv_event_code_t code = lv_event_get_code(e);
+
+    /* Children are deleted after the list's LV_EVENT_DELETE */
+    if (!v)
+        return;
+
+    switch (code) {
+        case LV_EVENT_GET_SELF_SIZE: {
+            /* Scroll range of all rows without objects for them */
+            lv_point_t *p = lv_event_get_param(e);
+            int32_t h = (int32_t)v->cfg.row_count * pitch(list, v);
+            if (v->cfg.row_count)
+                h -= lv_obj_get_style_pad_row(list, LV_PART_MAIN);
+            p->y = LV_MAX(p->y, h);
+            break;
+        }
+        case LV_EVENT_SIZE_CHANGED:
+            resize_pool(list, v);
+            update_window(list, v, 0);
+            break;
+        case LV_EVENT_SCROLL:
+            update_window(list, v, 0);
+            break;
+        case LV_EVENT_FOCUSED:
+        case LV_EVENT_DEFOCUSED:
+            update_window(list, v, 0);
+            break;
+        case LV_EVENT_KEY: {
+            uint32_t key = lv_event_get_key(e);
+            if (key == LV_KEY_DOWN && v->focused + 1 < v->cfg.row_count)
+                vlist_set_focused(list, v->focused + 1, LV_ANIM_ON);
+            else if (key == LV_KEY_UP && v->focused > 0)
+                vlist_set_focused(list, v->focused - 1, LV_ANIM_ON);
+            break;
+        }
+        case LV_EVENT_CLICKED: {
+            /* A click on a row bubbles up here; focus that row first */
+            lv_obj_t *target = lv_event_get_target(e);
+            while (target && target != list && lv_obj_get_parent(target) != list)
+                target = lv_obj_get_parent(target);
+            if (target && target != list) {
+                uint32_t index = vlist_get_row_index(target);
+                if (index != VLIST_NONE)
+                    vlist_set_focused(list, index, LV_ANIM_OFF);
+            }
+            break;
+        }
+        case LV_EVENT_DELETE:
+            lv_free(v->slots);
+            lv_free(v);
+            lv_obj_set_user_data(list, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+lv_obj_t *vlist_create(lv_obj_t *parent, const vlist_config_t *cfg) {
+    vlist_t *v = lv_malloc_zeroed(sizeof(*v));
+    LV_ASSERT_MALLOC(v);
+    if (!v)
+        return NULL;
+
+    v->cfg = *cfg;
+    v->focused = 0;
+
+    lv_obj_t *list = lv_obj_create(parent);
+    lv_obj_set_user_data(list, v);
+    lv_obj_set_scroll_dir(list, LV_DIR_VER);
+    /* Arrow keys move the focus, not the view */
+    lv_obj_remove_flag(list, LV_OBJ_FLAG_SCROLL_WITH_ARROW);
+    lv_obj_add_event_cb(list, event_cb, LV_EVENT_ALL, NULL);
+    lv_obj_refresh_self_size(list);
+    return list;
+}
+
+void vlist_set_row_count(lv_obj_t *list, uint32_t count) {
+    vlist_t *v = get(list);
+    v->cfg.row_count = count;
+    if (v->focused >= count)
+        v->focused = count ? count - 1 : 0;
+    lv_obj_refresh_self_size(list);
+    update_window(list, v, 1);
+}
+
+uint32_t vlist_get_row_count(lv_obj_t *list) {
+    return get(list)->cfg.row_count;
+}
+
+void vlist_refresh(lv_obj_t *list) {
+    update_window(list, get(list), 1);
+}
+
+uint32_t vlist_get_focused(lv_obj_t *list) {
+    vlist_t *v = get(list);
+    return v->cfg.row_count ? v->focused : VLIST_NONE;
+}
+
+void vlist_set_focused(lv_obj_t *list, uint32_t index, lv_anim_enable_t anim) {
+    vlist_t *v = get(list);
+    if (index >= v->cfg.row_count || index == v->focused)
+        return;
+
+    v->focused = index;
+    scroll_into_view(list, v, index, anim);
+    update_window(list, v, 0);
+    lv_obj_send_event(list, LV_EVENT_VALUE_CHANGED, NULL);
+}
+
+uint32_t vlist_get_row_index(lv_obj_t *row) {
+    lv_obj_t *list = lv_obj_get_parent(row);
+    vlist_t *v = list ? get(list) : NULL;
+    if (!v)
+        return VLIST_NONE;
+
+    for (uint32_t i = 0; i < v->slot_cnt; i++) {
+        if (v->slots[i].obj == row)
+            return v->slots[i].index;
+    }
+    return VLIST_NONE;
+}
+
+uint32_t vlist_get_pool_size(lv_obj_t *list) {
+    return get(list)->slot_cnt;
+}
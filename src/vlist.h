@@ -0,0 +1,55 @@
+#ifndef VLIST_H
+#define VLIST_H
+
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+/*
+ * Virtual list: a scrollable column of fixed-height rows where only the
+ * rows in view (plus a small margin) exist as objects. Rows are recycled
+ * on scroll and rebound to the data through bind(), so memory and
+ * per-frame work do not depend on the row count.
+ *
+ * The list itself is the focusable object: add it to a group and it
+ * moves a virtual focus with LV_KEY_UP/DOWN, scrolling as needed. The
+ * focused row gets LV_STATE_FOCUSED | LV_STATE_FOCUS_KEY so focus styles
+ * apply to it. Enter (or clicking a row) sends LV_EVENT_CLICKED to the
+ * list; focus moves send LV_EVENT_VALUE_CHANGED. Read the row with
+ * vlist_get_focused().
+ *
+ * The list keeps its state in its user data and positions the rows
+ * itself, so do not set a layout or user data on it.
+ */
+#define VLIST_NONE UINT32_MAX
+
+/* Creates one pool row as a child of list; NULL uses a button with a label */
+typedef lv_obj_t *(*vlist_create_row_cb_t)(lv_obj_t *list, void *user_data);
+/* Fills a pool row with the content of row `index` */
+typedef void (*vlist_bind_cb_t)(lv_obj_t *row, uint32_t index, void *user_data);
+
+typedef struct {
+    uint32_t row_count;
+    int32_t row_height;
+    vlist_create_row_cb_t create_row;
+    vlist_bind_cb_t bind;
+    void *user_data;
+} vlist_config_t;
+
+lv_obj_t *vlist_create(lv_obj_t *parent, const vlist_config_t *cfg);
+
+void vlist_set_row_count(lv_obj_t *list, uint32_t count);
+uint32_t vlist_get_row_count(lv_obj_t *list);
+
+/* Rebinds the rows in view, e.g. after the data changed */
+void vlist_refresh(lv_obj_t *list);
+
+uint32_t vlist_get_focused(lv_obj_t *list);
+void vlist_set_focused(lv_obj_t *list, uint32_t index, lv_anim_enable_t anim);
+
+/* Data index a pool row is bound to, or VLIST_NONE */
+uint32_t vlist_get_row_index(lv_obj_t *row);
+
+/* Live row objects, for checking that the pool stays bounded */
+uint32_t vlist_get_pool_size(lv_obj_t *list);
+
+#endif
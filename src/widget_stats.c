@@ -0,0 +1,205 @@
+#include "widget_stats.h"
+
+#if PORT_WIDGET_STATS
+
+#include "lvgl/src/draw/lv_draw_private.h"
+#include "serial.h"
+#include "tsc.h"
+
+typedef struct {
+    widget_stats_entry_t e;
+    uint64_t start;         /* TSC at the open DRAW_*_BEGIN */
+} slot_t;
+
+static slot_t slots[PORT_WIDGET_STATS_SLOTS];
+static uint32_t untracked;     /* Objects seen with the table full */
+
+static inline uint32_t obj_hash(const lv_obj_t *obj) {
+    uint32_t x = (uint32_t)(uintptr_t)obj;
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    return x;
+}
+
+static slot_t *find(const lv_obj_t *obj, int create) {
+    uint32_t h = obj_hash(obj);
+
+    for (uint32_t i = 0; i < PORT_WIDGET_STATS_SLOTS; i++) {
+        slot_t *s = &slots[(h + i) & (PORT_WIDGET_STATS_SLOTS - 1)];
+        if (s->e.obj == obj)
+            return s;
+        if (!s->e.obj) {
+            if (!create)
+                return NULL;
+            lv_memset(s, 0, sizeof(*s));
+            s->e.obj = (lv_obj_t *)obj;
+            return s;
+        }
+    }
+    return NULL;
+}
+
+/* Backward-shift delete keeps the linear probe chains intact */
+static void forget(const lv_obj_t *obj) {
+    uint32_t mask = PORT_WIDGET_STATS_SLOTS - 1;
+    slot_t *s = find(obj, 0);
+    if (!s)
+        return;
+
+    uint32_t hole = (uint32_t)(s - slots);
+    uint32_t i = hole;
+    for (;;) {
+        i = (i + 1) & mask;
+        if (!slots[i].e.obj)
+            break;
+        uint32_t home = obj_hash(slots[i].e.obj) & mask;
+        /* Move the entry back if the hole lies between its home and here */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].e.obj = NULL;
+}
+
+static void obj_event_cb(lv_event_t *e) {
+    lv_obj_t *obj = lv_event_get_current_target(e);
+    slot_t *s;
+
+    switch (lv_event_get_code(e)) {
+        case LV_EVENT_DRAW_MAIN_BEGIN:
+        case LV_EVENT_DRAW_POST_BEGIN:
+            s = find(obj, 1);
+            if (s) {
+                if (lv_event_get_code(e) == LV_EVENT_DRAW_MAIN_BEGIN)
+                    s->e.draws++;
+                s->start = rdtsc();
+            }
+            break;
+
+        case LV_EVENT_DRAW_MAIN_END:
+        case LV_EVENT_DRAW_POST_END:
+            s = find(obj, 0);
+            if (s && s->start) {
+                s->e.cycles += rdtsc() - s->start;
+                s->start = 0;
+            }
+            break;
+
+        case LV_EVENT_DRAW_TASK_ADDED: {
+            lv_draw_task_t *t = lv_event_get_draw_task(e);
+            lv_area_t drawn;
+            s = find(obj, 1);
+            if (s) {
+                s->e.tasks++;
+                if (lv_area_intersect(&drawn, &t->area, &t->clip_area))
+                    s->e.pixels += lv_area_get_size(&drawn);
+            }
+            break;
+        }
+
+        case LV_EVENT_CHILD_CREATED:
+            /* Sent to the parent once the new child is fully constructed */
+            widget_stats_attach(lv_event_get_param(e));
+            break;
+
+        case LV_EVENT_DELETE:
+            forget(obj);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void widget_stats_attach(lv_obj_t *root) {
+    /* One LV_EVENT_ALL descriptor per object, skipping ones we already have */
+    if (!find(root, 0)) {
+        if (find(root, 1)) {
+            lv_obj_add_event_cb(root, obj_event_cb, LV_EVENT_ALL, NULL);
+            lv_obj_add_flag(root, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+        } else {
+            /* Table full; still descend so the subtree is counted */
+            untracked++;
+        }
+    }
+
+    uint32_t n = lv_obj_get_child_count(root);
+    for (uint32_t i = 0; i < n; i++)
+        widget_stats_attach(lv_obj_get_child(root, (int32_t)i));
+}
+
+void widget_stats_reset(void) {
+    for (uint32_t i = 0; i < PORT_WIDGET_STATS_SLOTS; i++) {
+        if (!slots[i].e.obj)
+            continue;
+        slots[i].e.cycles = 0;
+        slots[i].e.pixels = 0;
+        slots[i].e.tasks = 0;
+        slots[i].e.draws = 0;
+    }
+}
+
+int widget_stats_top(widget_stats_entry_t *out, int n) {
+    int count = 0;
+
+    /* Insertion into a short sorted output array */
+    for (uint32_t i = 0; i < PORT_WIDGET_STATS_SLOTS; i++) {
+        const widget_stats_entry_t *e = &slots[i].e;
+        if (!e->obj || !e->draws)
+            continue;
+
+        int pos = count < n ? count : n;
+        while (pos > 0 && out[pos - 1].cycles < e->cycles)
+            pos--;
+        if (pos >= n)
+            continue;
+
+        int last = count < n ? count : n - 1;
+        for (int k = last; k > pos; k--)
+            out[k] = out[k - 1];
+        out[pos] = *e;
+        if (count < n)
+            count++;
+    }
+    return count;
+}
+
+static const char *class_name(const lv_obj_t *obj) {
+    if (lv_obj_check_type(obj, &lv_button_class))
+        return "button";
+    if (lv_obj_check_type(obj, &lv_label_class))
+        return "label";
+    if (lv_obj_get_parent(obj) == NULL)
+        return "screen";
+    return "obj";
+}
+
+void widget_stats_dump(void) {
+    widget_stats_entry_t top[PORT_WIDGET_STATS_TOP];
+    int n = widget_stats_top(top, PORT_WIDGET_STATS_TOP);
+    uint32_t khz = tsc_khz();
+
+    serial_puts("\n# --- widget render cost ---\n");
+    serial_puts("#        obj class       us/draw   draws      tasks     kpixels  outline radius shadow\n");
+    for (int i = 0; i < n; i++) {
+        const widget_stats_entry_t *e = &top[i];
+        uint64_t per_draw = e->cycles / e->draws;
+        uint32_t us = khz ? (uint32_t)(per_draw * 1000 / khz) : 0;
+
+        serial_printf("%12p %-8s %10u %7u %10u %11u  %7d %6d %6d\n",
+                      (void *)e->obj, class_name(e->obj), (unsigned)us,
+                      (unsigned)e->draws, (unsigned)e->tasks,
+                      (unsigned)(e->pixels / 1000),
+                      (int)lv_obj_get_style_outline_width(e->obj, LV_PART_MAIN),
+                      (int)lv_obj_get_style_radius(e->obj, LV_PART_MAIN),
+                      (int)lv_obj_get_style_shadow_width(e->obj, LV_PART_MAIN));
+    }
+    if (untracked)
+        serial_printf("# %u objects not tracked, PORT_WIDGET_STATS_SLOTS is full\n",
+                      (unsigned)untracked);
+    serial_puts("# --- end ---\n");
+}
+
+#endif
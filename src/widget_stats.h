@@ -0,0 +1,37 @@
+#ifndef WIDGET_STATS_H
+#define WIDGET_STATS_H
+
+#include <stdint.h>
+#include "port_conf.h"
+#include "lvgl/lvgl.h"
+
+/*
+ * Charges draw time (TSC ticks between an object's DRAW_MAIN/DRAW_POST
+ * begin and end events, children excluded), pixels and draw tasks to the
+ * lv_obj_t that generated them, accumulated across frames.
+ */
+typedef struct {
+    lv_obj_t *obj;
+    uint64_t cycles;
+    uint64_t pixels;
+    uint32_t tasks;
+    uint32_t draws;     /* DRAW_MAIN passes, i.e. frames it was redrawn in */
+} widget_stats_entry_t;
+
+#if PORT_WIDGET_STATS
+/* Instruments root and all its descendants; children created later are
+ * picked up through LV_EVENT_CHILD_CREATED */
+void widget_stats_attach(lv_obj_t *root);
+void widget_stats_reset(void);
+/* Fills out with up to n entries, most expensive first; returns the count */
+int widget_stats_top(widget_stats_entry_t *out, int n);
+/* Prints the top PORT_WIDGET_STATS_TOP table to the serial port */
+void widget_stats_dump(void);
+#else
+static inline void widget_stats_attach(lv_obj_t *root) { (void)root; }
+static inline void widget_stats_reset(void) {}
+static inline int widget_stats_top(widget_stats_entry_t *out, int n) { (void)out; (void)n; return 0; }
+static inline void widget_stats_dump(void) {}
+#endif
+
+#endif